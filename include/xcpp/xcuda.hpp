@@ -0,0 +1,676 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XCPP_CUDA_HPP
+#define XCPP_CUDA_HPP
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xeus-cling/xeus_cling_config.hpp"
+
+// Opaque CUDA driver types. The declarations are identical to the ones in
+// cuda.h, so both can be visible in the same translation unit.
+typedef int CUdevice_v1;
+typedef CUdevice_v1 CUdevice;
+typedef unsigned long long CUdeviceptr_v2;
+typedef CUdeviceptr_v2 CUdeviceptr;
+typedef struct CUctx_st* CUcontext;
+typedef struct CUmod_st* CUmodule;
+typedef struct CUfunc_st* CUfunction;
+typedef struct CUstream_st* CUstream;
+typedef struct CUevent_st* CUevent;
+typedef struct CUgraph_st* CUgraph;
+typedef struct CUgraphExec_st* CUgraphExec;
+
+namespace xcpp
+{
+    namespace cuda
+    {
+        // Handle of a kernel compiled with %%nvrtc. If the kernel is part of a
+        // pending -async build, the accessors block until this build finished.
+        class XEUS_CLING_API kernel_future
+        {
+        public:
+
+            explicit kernel_future(const std::string& name);
+
+            const std::string& name() const;
+            bool ready() const;
+            void wait() const;
+
+            // throws std::runtime_error if the build of the kernel failed
+            CUfunction get(int device = 0) const;
+
+            operator CUfunction() const
+            {
+                return get();
+            }
+
+        private:
+
+            std::string m_name;
+        };
+
+        XEUS_CLING_API kernel_future kernel(const std::string& name);
+
+        // grid and block size of a launch, like dim3 of the CUDA runtime
+        struct dim3
+        {
+            dim3(unsigned int vx = 1, unsigned int vy = 1, unsigned int vz = 1)
+                : x(vx), y(vy), z(vz)
+            {
+            }
+
+            unsigned int x;
+            unsigned int y;
+            unsigned int z;
+        };
+
+        // Stream of the pool of a device, created on first use. The streams do not
+        // synchronize with the default stream, kernels on different streams
+        // can overlap. Throws std::out_of_range before the first %%nvrtc cell.
+        XEUS_CLING_API CUstream stream(int device = 0, int index = 0);
+
+        // Waits for all streams and all work of the devices, returns the first
+        // CUresult error. Called by the kernel before the result of a cell is published.
+        XEUS_CLING_API int synchronize_all();
+
+        // CUDA event of a device for dependencies between streams and for timing
+        class XEUS_CLING_API event
+        {
+        public:
+
+            explicit event(int device = 0, bool timing = false);
+            ~event();
+
+            event(const event&) = delete;
+            event& operator=(const event&) = delete;
+            event(event&& other) noexcept;
+            event& operator=(event&& other) noexcept;
+
+            int record(CUstream stream);
+            int wait(CUstream stream) const;      //work submitted to stream afterwards waits for the event
+            int synchronize() const;
+            float elapsed_ms(const event& start) const;   //both events need timing
+
+            CUevent get() const;
+
+        private:
+
+            CUevent m_event = nullptr;
+            int m_device = 0;
+            double m_time = 0.0;    //milliseconds of the host clock at record, kernels of -emulate
+        };
+
+        // counters of the caching allocator, bytes are rounded to the size classes
+        struct memory_statistics
+        {
+            std::size_t allocations;        //requests of device_buffer and device_allocate
+            std::size_t cache_hits;         //requests served from the free lists
+            std::size_t driver_allocations; //calls of cuMemAlloc
+            std::size_t bytes_in_use;
+            std::size_t peak_bytes_in_use;
+            std::size_t bytes_cached;       //free device blocks kept by the pool
+            std::size_t host_bytes_in_use;
+            std::size_t host_bytes_cached;
+        };
+
+        // Session wide caching allocator, see device_buffer and host_pinned_buffer.
+        // The allocation functions throw std::runtime_error if the driver fails.
+        XEUS_CLING_API CUdeviceptr device_allocate(std::size_t bytes, int device = 0, CUstream stream = nullptr);
+        XEUS_CLING_API void device_free(CUdeviceptr pointer, std::size_t bytes, int device = 0, CUstream stream = nullptr);
+        XEUS_CLING_API void* host_allocate(std::size_t bytes);
+        XEUS_CLING_API void host_free(void* pointer, std::size_t bytes, CUstream stream = nullptr);
+        XEUS_CLING_API memory_statistics memory_stats();
+        XEUS_CLING_API void empty_cache();     //returns the cached blocks to the driver
+
+        // Copies between host and device memory, synchronous for the null stream,
+        // otherwise ordered on the stream. Return the CUresult.
+        XEUS_CLING_API int copy_to_device(CUdeviceptr destination, const void* source, std::size_t bytes, int device = 0, CUstream stream = nullptr);
+        XEUS_CLING_API int copy_to_host(void* destination, CUdeviceptr source, std::size_t bytes, int device = 0, CUstream stream = nullptr);
+
+        // Device memory for count elements of T from the caching allocator. The
+        // memory goes back to the pool on destruction, it can be passed to typed
+        // launchers as CUdeviceptr.
+        template <class T>
+        class device_buffer
+        {
+        public:
+
+            explicit device_buffer(std::size_t count, int device = 0, CUstream stream = nullptr)
+                : m_count(count), m_device(device), m_stream(stream)
+            {
+                m_pointer = count == 0 ? 0 : device_allocate(bytes(), device, stream);
+            }
+
+            ~device_buffer()
+            {
+                reset();
+            }
+
+            device_buffer(const device_buffer&) = delete;
+            device_buffer& operator=(const device_buffer&) = delete;
+
+            device_buffer(device_buffer&& other) noexcept
+                : m_pointer(other.m_pointer), m_count(other.m_count), m_device(other.m_device), m_stream(other.m_stream)
+            {
+                other.m_pointer = 0;
+                other.m_count = 0;
+            }
+
+            device_buffer& operator=(device_buffer&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    m_pointer = other.m_pointer;
+                    m_count = other.m_count;
+                    m_device = other.m_device;
+                    m_stream = other.m_stream;
+                    other.m_pointer = 0;
+                    other.m_count = 0;
+                }
+                return *this;
+            }
+
+            int upload(const T* source, std::size_t count, CUstream stream = nullptr)
+            {
+                return copy_to_device(m_pointer, source, count * sizeof(T), m_device, stream);
+            }
+
+            int download(T* destination, std::size_t count, CUstream stream = nullptr) const
+            {
+                return copy_to_host(destination, m_pointer, count * sizeof(T), m_device, stream);
+            }
+
+            // the stream of the last use, the block is reused on it without synchronization
+            void set_stream(CUstream stream)
+            {
+                m_stream = stream;
+            }
+
+            CUdeviceptr get() const
+            {
+                return m_pointer;
+            }
+
+            operator CUdeviceptr() const
+            {
+                return m_pointer;
+            }
+
+            std::size_t size() const
+            {
+                return m_count;
+            }
+
+            std::size_t bytes() const
+            {
+                return m_count * sizeof(T);
+            }
+
+            int device() const
+            {
+                return m_device;
+            }
+
+        private:
+
+            void reset()
+            {
+                if (m_pointer != 0) device_free(m_pointer, bytes(), m_device, m_stream);
+                m_pointer = 0;
+            }
+
+            CUdeviceptr m_pointer = 0;
+            std::size_t m_count;
+            int m_device;
+            CUstream m_stream;
+        };
+
+        // Page locked host memory from the caching allocator for fast and
+        // asynchronous copies. Pass the stream of asynchronous copies, the
+        // memory is then not reused before the next synchronization.
+        template <class T>
+        class host_pinned_buffer
+        {
+        public:
+
+            explicit host_pinned_buffer(std::size_t count, CUstream stream = nullptr)
+                : m_count(count), m_stream(stream)
+            {
+                m_data = count == 0 ? nullptr : static_cast<T*>(host_allocate(count * sizeof(T)));
+            }
+
+            ~host_pinned_buffer()
+            {
+                reset();
+            }
+
+            host_pinned_buffer(const host_pinned_buffer&) = delete;
+            host_pinned_buffer& operator=(const host_pinned_buffer&) = delete;
+
+            host_pinned_buffer(host_pinned_buffer&& other) noexcept
+                : m_data(other.m_data), m_count(other.m_count), m_stream(other.m_stream)
+            {
+                other.m_data = nullptr;
+                other.m_count = 0;
+            }
+
+            host_pinned_buffer& operator=(host_pinned_buffer&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    m_data = other.m_data;
+                    m_count = other.m_count;
+                    m_stream = other.m_stream;
+                    other.m_data = nullptr;
+                    other.m_count = 0;
+                }
+                return *this;
+            }
+
+            // the stream of asynchronous copies using the buffer
+            void set_stream(CUstream stream)
+            {
+                m_stream = stream;
+            }
+
+            T* data() const
+            {
+                return m_data;
+            }
+
+            T& operator[](std::size_t i) const
+            {
+                return m_data[i];
+            }
+
+            T* begin() const
+            {
+                return m_data;
+            }
+
+            T* end() const
+            {
+                return m_data + m_count;
+            }
+
+            std::size_t size() const
+            {
+                return m_count;
+            }
+
+        private:
+
+            void reset()
+            {
+                if (m_data != nullptr) host_free(m_data, m_count * sizeof(T), m_stream);
+                m_data = nullptr;
+            }
+
+            T* m_data;
+            std::size_t m_count;
+            CUstream m_stream;
+        };
+
+        // counters of a graph, the host times compare the captured launch calls with one graph launch
+        struct graph_statistics
+        {
+            std::size_t nodes;          //nodes of the last capture
+            std::size_t captures;
+            std::size_t updates;        //captures applied to the executable graph in place
+            std::size_t instantiations;
+            std::size_t launches;
+            double capture_us;          //host time of the launch calls of the last capture
+            double launch_us;           //host time of the last graph launch
+        };
+
+        // CUDA graph of a sequence of launches on one device. capture runs body,
+        // whose launches and copies on the null stream or on the stream passed
+        // to body are recorded instead of executed. The first capture
+        // instantiates the graph, later captures with the same topology update
+        // the kernel parameters of the executable graph in place. launch replays
+        // the whole sequence with one driver call. Not available with -emulate.
+        class XEUS_CLING_API graph
+        {
+        public:
+
+            explicit graph(int device = 0);
+            ~graph();
+
+            graph(const graph&) = delete;
+            graph& operator=(const graph&) = delete;
+            graph(graph&& other) noexcept;
+            graph& operator=(graph&& other) noexcept;
+
+            // return the CUresult, body may throw, the capture is discarded then
+            int capture(const std::function<void(CUstream)>& body);
+            int launch(CUstream stream = nullptr);     //on the stream of the graph for nullptr
+            int synchronize() const;
+
+            bool ready() const;
+            int device() const;
+            CUstream stream() const;
+            graph_statistics statistics() const;
+
+        private:
+
+            void release();
+
+            int m_device;
+            CUstream m_stream = nullptr;
+            CUgraphExec m_exec = nullptr;
+            graph_statistics m_statistics = {};
+        };
+
+        // cuLaunchKernel of the driver loaded by the magic, returns the CUresult.
+        // Kernels of %%nvrtc -emulate run on the CPU and are finished on return.
+        XEUS_CLING_API int launch(CUfunction function, dim3 grid, dim3 block, unsigned int sharedMemory, CUstream stream, void** arguments);
+
+        // one configuration timed by autotune
+        struct tuning_candidate
+        {
+            std::string kernel;     //source name of the kernel or of the variant
+            unsigned int block;
+            double milliseconds;    //mean of the timed launches, negative if the launch failed
+            double occupancy;       //active threads per multiprocessor relative to the maximum, 0 if unknown
+            bool suggested;         //block size of cuOccupancyMaxPotentialBlockSize
+        };
+
+        // Times 1-D launches of problem_size threads for the block sizes (default:
+        // the occupancy suggestion and the powers of two from 32 to the limit of
+        // the kernel) and for the variants, kernels with the same parameters. launch
+        // starts one configuration with the arguments of the caller. The fastest is
+        // kept per kernel, device and problem size rounded up to a power of two.
+        // Returns the candidates, fastest first, empty if none could be launched.
+        XEUS_CLING_API std::vector<tuning_candidate> autotune(CUfunction function, const std::vector<std::string>& variants, std::size_t problem_size,
+                                                              const std::vector<unsigned int>& blocks, int repeat, unsigned int shared_memory,
+                                                              const std::function<int(CUfunction, dim3, dim3, CUstream)>& launch);
+
+        // block size for a 1-D launch of problem_size threads, the one of autotune or
+        // the occupancy suggestion; tuned is set to the winning variant or function
+        XEUS_CLING_API unsigned int tuned_launch(CUfunction function, std::size_t problem_size, unsigned int shared_memory, CUfunction& tuned);
+
+        // Typed launcher for a kernel, declared by %%nvrtc for every __global__
+        // function with the parameter types of its signature, pointers are passed
+        // as CUdeviceptr. The arguments are copied into a buffer owned by the
+        // launcher, a launch does not allocate.
+        template <class... Args>
+        class typed_kernel
+        {
+        public:
+
+            // the launcher follows the CUfunction variable, a rerun of the cell rebinds both
+            explicit typed_kernel(CUfunction& function)
+                : m_function(&function)
+            {
+                bind(std::index_sequence_for<Args...>());
+            }
+
+            typed_kernel(const typed_kernel& other)
+                : m_function(other.m_function), m_shared_memory(other.m_shared_memory), m_values(other.m_values)
+            {
+                bind(std::index_sequence_for<Args...>());
+            }
+
+            typed_kernel& operator=(const typed_kernel& other)
+            {
+                m_function = other.m_function;
+                m_shared_memory = other.m_shared_memory;
+                m_values = other.m_values;
+                return *this;
+            }
+
+            int launch(dim3 grid, dim3 block, CUstream stream, const Args&... args)
+            {
+                m_values = std::tie(args...);
+                return xcpp::cuda::launch(*m_function, grid, block, m_shared_memory, stream, m_arguments.data());
+            }
+
+            // one thread per element, kernel and block size as tuned by %nvrtc_autotune
+            int launch_n(std::size_t n, CUstream stream, const Args&... args)
+            {
+                CUfunction function = *m_function;
+                unsigned int block = tuned_launch(*m_function, n, m_shared_memory, function);
+                m_values = std::tie(args...);
+                return xcpp::cuda::launch(function, dim3(static_cast<unsigned int>((n + block - 1) / block)), dim3(block), m_shared_memory, stream, m_arguments.data());
+            }
+
+            // launch of another kernel with the same parameters, e.g. a variant of the autotuner
+            int launch_function(CUfunction function, dim3 grid, dim3 block, CUstream stream, const Args&... args)
+            {
+                m_values = std::tie(args...);
+                return xcpp::cuda::launch(function, grid, block, m_shared_memory, stream, m_arguments.data());
+            }
+
+            // dynamic shared memory of the following launches in bytes
+            void set_shared_memory(unsigned int bytes)
+            {
+                m_shared_memory = bytes;
+            }
+
+            unsigned int shared_memory() const
+            {
+                return m_shared_memory;
+            }
+
+            CUfunction function() const
+            {
+                return *m_function;
+            }
+
+        private:
+
+            template <std::size_t... I>
+            void bind(std::index_sequence<I...>)
+            {
+                m_arguments = {{static_cast<void*>(&std::get<I>(m_values))..., nullptr}};
+            }
+
+            CUfunction* m_function;
+            unsigned int m_shared_memory = 0;
+            std::tuple<Args...> m_values;
+            std::array<void*, sizeof...(Args) + 1> m_arguments;
+        };
+
+        // part [begin, end) of the split dimension of a launch_all index space
+        struct device_slice
+        {
+            int device;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        // Slices of [0, extent) for all devices in multiples of granularity. With
+        // weighted the slices follow the throughput launch_all measured for the
+        // kernel, otherwise, or before each device ran it, they are equal.
+        XEUS_CLING_API std::vector<device_slice> partition(const std::string& kernel, std::size_t extent, std::size_t granularity = 1, bool weighted = false);
+
+        // Runs launch for each non-empty slice on the thread of its device, which
+        // has the context of the device current, and waits until the work of all
+        // devices is finished. Returns the first CUresult error.
+        XEUS_CLING_API int run_on_devices(const std::string& kernel, const std::vector<device_slice>& slices, const std::function<int(const device_slice&)>& launch);
+
+        // placeholders for launch_all arguments, replaced by the first index and
+        // the size of the slice of the device, passed as unsigned int
+        struct slice_begin_t {};
+        struct slice_size_t {};
+        constexpr slice_begin_t slice_begin{};
+        constexpr slice_size_t slice_size{};
+
+        // launch_all argument with a value for each device, e.g. the device
+        // pointers or the device_buffers allocated on each device
+        template <class T>
+        class per_device
+        {
+        public:
+
+            per_device(std::initializer_list<T> values)
+                : m_values(values)
+            {
+            }
+
+            explicit per_device(std::vector<T> values)
+                : m_values(std::move(values))
+            {
+            }
+
+            const T& operator[](int device) const
+            {
+                return m_values.at(device);
+            }
+
+        private:
+
+            std::vector<T> m_values;
+        };
+
+        struct launch_all_options
+        {
+            launch_all_options(dim3 block_size = dim3(256), unsigned int shared_memory_bytes = 0, bool weighted_split = false)
+                : block(block_size), shared_memory(shared_memory_bytes), weighted(weighted_split)
+            {
+            }
+
+            dim3 block;
+            unsigned int shared_memory;
+            bool weighted;      //split by the measured throughput of the devices
+        };
+
+        namespace detail
+        {
+            template <class T>
+            struct slice_argument
+            {
+                using type = T;
+                static const T& get(const T& value, const device_slice&) { return value; }
+            };
+
+            template <>
+            struct slice_argument<slice_begin_t>
+            {
+                using type = unsigned int;
+                static type get(const slice_begin_t&, const device_slice& slice) { return static_cast<type>(slice.begin); }
+            };
+
+            template <>
+            struct slice_argument<slice_size_t>
+            {
+                using type = unsigned int;
+                static type get(const slice_size_t&, const device_slice& slice) { return static_cast<type>(slice.end - slice.begin); }
+            };
+
+            //only for the device of the buffer, checked by check_devices
+            template <class T>
+            struct slice_argument<device_buffer<T>>
+            {
+                using type = CUdeviceptr;
+                static type get(const device_buffer<T>& value, const device_slice&) { return value.get(); }
+            };
+
+            template <class T>
+            struct slice_argument<per_device<T>>
+            {
+                using type = T;
+                static const T& get(const per_device<T>& value, const device_slice& slice) { return value[slice.device]; }
+            };
+
+            template <class T>
+            struct slice_argument<per_device<device_buffer<T>>>
+            {
+                using type = CUdeviceptr;
+                static type get(const per_device<device_buffer<T>>& value, const device_slice& slice) { return value[slice.device].get(); }
+            };
+
+            // false for a buffer of another context than the device of the launch
+            template <class T>
+            bool on_device(const T&, int)
+            {
+                return true;
+            }
+
+            template <class T>
+            bool on_device(const device_buffer<T>& value, int device)
+            {
+                return value.device() == device;
+            }
+
+            template <class T>
+            bool on_device(const per_device<device_buffer<T>>& value, int device)
+            {
+                return value[device].device() == device;
+            }
+
+            // throws std::invalid_argument if a device would get the pointer of another device
+            template <class... Args>
+            void check_devices(const std::vector<device_slice>& slices, const Args&... args)
+            {
+                for (const device_slice& slice : slices)
+                {
+                    if (slice.end <= slice.begin) continue;
+                    std::array<bool, sizeof...(Args) + 1> valid = {{true, on_device(args, slice.device)...}};
+                    for (std::size_t i = 1; i < valid.size(); i++)
+                    {
+                        if (!valid[i])
+                        {
+                            throw std::invalid_argument("launch_all: argument " + std::to_string(i) + " is a device_buffer of another device than device "
+                                                        + std::to_string(slice.device) + ", pass per_device buffers of each device");
+                        }
+                    }
+                }
+            }
+
+            template <class Tuple, std::size_t... I>
+            int launch_slice(CUfunction function, dim3 grid, dim3 block, unsigned int sharedMemory, CUstream stream, Tuple& values, std::index_sequence<I...>)
+            {
+                void* arguments[] = {static_cast<void*>(&std::get<I>(values))..., nullptr};
+                return xcpp::cuda::launch(function, grid, block, sharedMemory, stream, arguments);
+            }
+        }
+
+        // Launches kernel on all devices, each device runs a slice of the threads of
+        // range. The slowest dimension of range with more than one thread is split,
+        // the kernel gets its slice through slice_begin and slice_size and checks
+        // the local index against slice_size. Arguments are the same on all
+        // devices except per_device values. A device_buffer belongs to one
+        // context, it is only accepted when the launch runs on its device alone,
+        // several devices need per_device<device_buffer<T>> or per_device<CUdeviceptr>
+        // (std::invalid_argument otherwise). The launches run concurrently on one
+        // host thread per device and the call returns when all devices finished.
+        template <class... Args>
+        int launch_all(const kernel_future& kernel, dim3 range, const launch_all_options& options, const Args&... args)
+        {
+            unsigned int dim3::*axis = range.z > 1 ? &dim3::z : (range.y > 1 ? &dim3::y : &dim3::x);
+            std::vector<device_slice> slices = partition(kernel.name(), range.*axis, options.block.*axis, options.weighted);
+            detail::check_devices(slices, args...);
+            return run_on_devices(kernel.name(), slices, [&](const device_slice& slice)
+            {
+                dim3 threads = range;
+                threads.*axis = static_cast<unsigned int>(slice.end - slice.begin);
+                dim3 grid((threads.x + options.block.x - 1) / options.block.x, (threads.y + options.block.y - 1) / options.block.y,
+                          (threads.z + options.block.z - 1) / options.block.z);
+                std::tuple<typename detail::slice_argument<Args>::type...> values(detail::slice_argument<Args>::get(args, slice)...);
+                return detail::launch_slice(kernel.get(slice.device), grid, options.block, options.shared_memory, stream(slice.device),
+                                            values, std::index_sequence_for<Args...>());
+            });
+        }
+    }
+}
+
+#endif
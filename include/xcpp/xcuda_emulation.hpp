@@ -0,0 +1,214 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XCPP_CUDA_EMULATION_HPP
+#define XCPP_CUDA_EMULATION_HPP
+
+// CUDA builtins for kernels of %%nvrtc -emulate, which are compiled by cling
+// and run on the CPU. The header is loaded by the magic with the first
+// emulated cell, the macros are visible in all following cells.
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "xcpp/xcuda.hpp"
+
+struct uint3
+{
+    unsigned int x;
+    unsigned int y;
+    unsigned int z;
+};
+
+using dim3 = xcpp::cuda::dim3;
+
+struct int2 { int x, y; };
+struct int3 { int x, y, z; };
+struct int4 { int x, y, z, w; };
+struct float2 { float x, y; };
+struct float3 { float x, y, z; };
+struct float4 { float x, y, z, w; };
+struct double2 { double x, y; };
+
+inline int2 make_int2(int x, int y) { return {x, y}; }
+inline int3 make_int3(int x, int y, int z) { return {x, y, z}; }
+inline int4 make_int4(int x, int y, int z, int w) { return {x, y, z, w}; }
+inline float2 make_float2(float x, float y) { return {x, y}; }
+inline float3 make_float3(float x, float y, float z) { return {x, y, z}; }
+inline float4 make_float4(float x, float y, float z, float w) { return {x, y, z, w}; }
+inline double2 make_double2(double x, double y) { return {x, y}; }
+
+namespace xcpp
+{
+    namespace cuda
+    {
+        namespace emulation
+        {
+            // indices of the CUDA thread running on the calling CPU thread
+            struct thread_state
+            {
+                uint3 threadIdx;
+                uint3 blockIdx;
+                dim3 blockDim;
+                dim3 gridDim;
+            };
+
+            XEUS_CLING_API const thread_state& current();
+
+            // barrier of the threads of a block, only in kernels registered with barrier
+            XEUS_CLING_API void syncthreads();
+
+            // extern __shared__ memory of the launch
+            XEUS_CLING_API void* dynamic_shared();
+
+            // __shared__ variable of the running block, id is unique in the session
+            XEUS_CLING_API void* shared_variable(std::size_t id, std::size_t size, std::size_t alignment);
+
+            // returns the handle for xcpp::cuda::launch, invoke gets the argument array of the launch
+            XEUS_CLING_API CUfunction register_invoker(const std::string& name, std::function<void(void**)> invoke, bool barrier);
+
+            template <class T>
+            T& shared(std::size_t id)
+            {
+                return *static_cast<T*>(shared_variable(id, sizeof(T), alignof(T)));
+            }
+
+            template <class... Args, std::size_t... I>
+            void invoke(void (*kernel)(Args...), void** arguments, std::index_sequence<I...>)
+            {
+                //pointers arrive as CUdeviceptr of the same size
+                kernel(*static_cast<std::decay_t<Args>*>(arguments[I])...);
+            }
+
+            template <class... Args>
+            CUfunction register_kernel(const std::string& name, void (*kernel)(Args...), bool barrier)
+            {
+                return register_invoker(name, [kernel](void** arguments)
+                {
+                    invoke(kernel, arguments, std::index_sequence_for<Args...>());
+                }, barrier);
+            }
+
+            template <class T, class F>
+            T atomic_update(T* address, F update)
+            {
+                T old = __atomic_load_n(address, __ATOMIC_RELAXED);
+                while (!__atomic_compare_exchange_n(address, &old, update(old), true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+                {
+                }
+                return old;
+            }
+
+            template <class T>
+            T atomic_float_add(T* address, T value)
+            {
+                //no atomic add for floating point types, the bits are exchanged
+                static_assert(sizeof(T) == 4 || sizeof(T) == 8, "float or double");
+                using bits = std::conditional_t<sizeof(T) == 4, unsigned int, unsigned long long>;
+                bits* raw = reinterpret_cast<bits*>(address);
+                bits old = __atomic_load_n(raw, __ATOMIC_RELAXED);
+                while (true)
+                {
+                    T current;
+                    __builtin_memcpy(&current, &old, sizeof(T));
+                    T sum = current + value;
+                    bits next;
+                    __builtin_memcpy(&next, &sum, sizeof(T));
+                    if (__atomic_compare_exchange_n(raw, &old, next, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) return current;
+                }
+            }
+        }
+    }
+}
+
+// the implementation in libxeus-cling includes only the declarations
+#ifndef XCPP_CUDA_EMULATION_DECLARATIONS_ONLY
+
+#define threadIdx (::xcpp::cuda::emulation::current().threadIdx)
+#define blockIdx (::xcpp::cuda::emulation::current().blockIdx)
+#define blockDim (::xcpp::cuda::emulation::current().blockDim)
+#define gridDim (::xcpp::cuda::emulation::current().gridDim)
+#define warpSize 32
+
+#define __global__
+#define __device__
+#define __host__
+#define __noinline__
+#define __constant__
+#define __managed__
+#define __grid_constant__
+#define __forceinline__ inline
+#define __restrict__ __restrict
+#define __launch_bounds__(...)
+#define __align__(n) __attribute__((aligned(n)))
+
+#define __syncthreads() ::xcpp::cuda::emulation::syncthreads()
+#define __threadfence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __threadfence_block() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+template <class T> inline T atomicAdd(T* address, T value) { return __atomic_fetch_add(address, value, __ATOMIC_SEQ_CST); }
+inline float atomicAdd(float* address, float value) { return xcpp::cuda::emulation::atomic_float_add(address, value); }
+inline double atomicAdd(double* address, double value) { return xcpp::cuda::emulation::atomic_float_add(address, value); }
+template <class T> inline T atomicSub(T* address, T value) { return __atomic_fetch_sub(address, value, __ATOMIC_SEQ_CST); }
+template <class T> inline T atomicAnd(T* address, T value) { return __atomic_fetch_and(address, value, __ATOMIC_SEQ_CST); }
+template <class T> inline T atomicOr(T* address, T value) { return __atomic_fetch_or(address, value, __ATOMIC_SEQ_CST); }
+template <class T> inline T atomicXor(T* address, T value) { return __atomic_fetch_xor(address, value, __ATOMIC_SEQ_CST); }
+template <class T> inline T atomicExch(T* address, T value) { return __atomic_exchange_n(address, value, __ATOMIC_SEQ_CST); }
+inline float atomicExch(float* address, float value)
+{
+    unsigned int bits = __atomic_exchange_n(reinterpret_cast<unsigned int*>(address), *reinterpret_cast<unsigned int*>(&value), __ATOMIC_SEQ_CST);
+    return *reinterpret_cast<float*>(&bits);
+}
+template <class T> inline T atomicCAS(T* address, T compare, T value)
+{
+    __atomic_compare_exchange_n(address, &compare, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return compare;     //the old value also if the exchange failed
+}
+template <class T> inline T atomicMin(T* address, T value)
+{
+    return xcpp::cuda::emulation::atomic_update(address, [value](T old) { return value < old ? value : old; });
+}
+template <class T> inline T atomicMax(T* address, T value)
+{
+    return xcpp::cuda::emulation::atomic_update(address, [value](T old) { return value > old ? value : old; });
+}
+inline unsigned int atomicInc(unsigned int* address, unsigned int limit)
+{
+    return xcpp::cuda::emulation::atomic_update(address, [limit](unsigned int old) { return old >= limit ? 0u : old + 1; });
+}
+inline unsigned int atomicDec(unsigned int* address, unsigned int limit)
+{
+    return xcpp::cuda::emulation::atomic_update(address, [limit](unsigned int old) { return (old == 0 || old > limit) ? limit : old - 1; });
+}
+
+// intrinsics with the precision of the CPU functions
+inline float rsqrtf(float x) { return 1.0f / std::sqrt(x); }
+inline double rsqrt(double x) { return 1.0 / std::sqrt(x); }
+inline float __expf(float x) { return std::exp(x); }
+inline float __logf(float x) { return std::log(x); }
+inline float __sinf(float x) { return std::sin(x); }
+inline float __cosf(float x) { return std::cos(x); }
+inline float __powf(float x, float y) { return std::pow(x, y); }
+inline float __fdividef(float x, float y) { return x / y; }
+inline float __saturatef(float x) { return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x); }
+inline float __fmaf_rn(float x, float y, float z) { return std::fma(x, y, z); }
+inline double __fma_rn(double x, double y, double z) { return std::fma(x, y, z); }
+inline void __sincosf(float x, float* s, float* c) { *s = std::sin(x); *c = std::cos(x); }
+inline int __popc(unsigned int x) { return __builtin_popcount(x); }
+inline int __popcll(unsigned long long x) { return __builtin_popcountll(x); }
+inline int __clz(int x) { return x == 0 ? 32 : __builtin_clz(static_cast<unsigned int>(x)); }
+inline int __ffs(int x) { return __builtin_ffs(x); }
+template <class T> inline T __ldg(const T* address) { return *address; }
+
+#endif
+#endif
@@ -29,6 +29,9 @@
 #include "xeus-cling/xeus_cling_config.hpp"
 #include "xeus-cling/xinterpreter.hpp"
 
+#include "xmagics/nvrtc_doorbell.hpp"
+#include "xmagics/nvrtc_session.hpp"
+
 #ifdef __GNUC__
 void handler(int sig)
 {
@@ -100,6 +103,13 @@ interpreter_ptr build_interpreter(int argc, char** argv)
     return interp_ptr;
 }
 
+// results of background %%nvrtc builds are shown at once, also in an idle notebook
+void wake_shell_on_posts(const xeus::xconfiguration& config)
+{
+    xcpp::nvrtc_doorbell::instance().configure(config.m_transport, config.m_ip, config.m_shell_port, config.m_signature_scheme, config.m_key);
+    xcpp::nvrtc_session::instance().setPostHook([]() { xcpp::nvrtc_doorbell::instance().ring(); });
+}
+
 int main(int argc, char* argv[])
 {
     if (should_print_version(argc, argv))
@@ -157,6 +167,7 @@ int main(int argc, char* argv[])
                          + file_name + " file."
                   << std::endl;
 
+        wake_shell_on_posts(config);
         kernel.start();
     }
     else
@@ -208,6 +219,7 @@ int main(int argc, char* argv[])
                          + "\"\n"
                            "}\n```\n";
 
+        wake_shell_on_posts(config);
         kernel.start();
     }
 
@@ -30,6 +30,11 @@
 #include "xmagics/execution.hpp"
 #include "xmagics/os.hpp"
 #include "xmagics/nvrtc.hpp"
+#include "xmagics/nvrtc_autotune.hpp"
+#include "xmagics/nvrtc_graph.hpp"
+#include "xmagics/nvrtc_session.hpp"
+#include "xmagics/nvrtc_stats.hpp"
+#include "xmagics/nvrtc_streams.hpp"
 #include "xmime_internal.hpp"
 #include "xparser.hpp"
 #include "xsystem.hpp"
@@ -82,16 +87,28 @@ namespace xcpp
     {
         nl::json kernel_res;
 
+        // Results of background %%nvrtc builds
+        nvrtc_session::instance().runPosted();
+
         // Check for magics
         for (auto& pre : preamble_manager.preamble)
         {
             if (pre.second.is_match(code))
             {
                 pre.second.apply(code, kernel_res);
+                // Timings of a %%nvrtc cell
+                nl::json metadata = nvrtc_session::instance().takeReplyMetadata();
+                if (!metadata.is_null())
+                {
+                    kernel_res["metadata"] = metadata;
+                }
                 return kernel_res;
             }
         }
 
+        // Declarations of the CUDA driver API, parsed when a cell uses it for the first time
+        nvrtc_session::instance().prepareHostCell(code);
+
         // Split code from includes
         auto blocks = split_from_includes(code.c_str());
 
@@ -161,6 +178,18 @@ namespace xcpp
             }
         }
 
+        // Wait for the CUDA work of the cell, a failed kernel is an error of the cell
+        if (!errorlevel)
+        {
+            std::string cuda_error;
+            if (nvrtc_stream_pool::instance().synchronizeAll(cuda_error) != 0)
+            {
+                errorlevel = 1;
+                ename = "CUDA Error";
+                evalue = cuda_error;
+            }
+        }
+
         // Flush streams
         std::cout << std::flush;
         std::cerr << std::flush;
@@ -213,6 +242,9 @@ namespace xcpp
 
     nl::json interpreter::complete_request_impl(const std::string& code, int cursor_pos)
     {
+        // Results of background %%nvrtc builds, shown before the request
+        nvrtc_session::instance().runPosted();
+
         std::vector<std::string> result;
         cling::Interpreter::CompilationResult compilation_result;
         nl::json kernel_res;
@@ -248,6 +280,9 @@ namespace xcpp
 
     nl::json interpreter::inspect_request_impl(const std::string& code, int cursor_pos, int /*detail_level*/)
     {
+        // Results of background %%nvrtc builds, shown before the request
+        nvrtc_session::instance().runPosted();
+
         nl::json kernel_res;
 
         auto dummy = code.substr(0, cursor_pos);
@@ -264,6 +299,9 @@ namespace xcpp
 
     nl::json interpreter::is_complete_request_impl(const std::string& code)
     {
+        // Results of background %%nvrtc builds, also sent by the doorbell of a finished build
+        nvrtc_session::instance().runPosted();
+
         nl::json kernel_res;
 
         m_input_validator.reset();
@@ -459,6 +497,9 @@ namespace xcpp
             executable(m_interpreter)
         );
         preamble_manager["magics"].get_cast<xmagics_manager>().register_magic("nvrtc",nvrtc(m_interpreter));
+        preamble_manager["magics"].get_cast<xmagics_manager>().register_magic("cuda_graph", nvrtc_graph(m_interpreter));
+        preamble_manager["magics"].get_cast<xmagics_manager>().register_magic("nvrtc_stats", nvrtc_stats());
+        preamble_manager["magics"].get_cast<xmagics_manager>().register_magic("nvrtc_autotune", nvrtc_autotune(m_interpreter));
         preamble_manager["magics"].get_cast<xmagics_manager>().register_magic("file", writefile());
         preamble_manager["magics"].get_cast<xmagics_manager>().register_magic("timeit", timeit(&m_interpreter));
     }
@@ -8,10 +8,28 @@
 ****************************************************************************************/
 
 #include "nvrtc.hpp"
+#include "nvrtc_emulator.hpp"
+#include "nvrtc_ptx.hpp"
+#include "nvrtc_report.hpp"
+#include "nvrtc_session.hpp"
+#include "nvrtc_streams.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <unordered_set>
 #include "cling/Interpreter/Value.h"
-#include "../xmime_internal.hpp"
+#include "xeus/xguid.hpp"
+#include "xeus/xinterpreter.hpp"
+
+namespace nl = nlohmann;
 
 #define ERROR_CODE -1
 #define SUCCESS 0
@@ -25,21 +43,56 @@ namespace xcpp
 
     void nvrtc::generateNVRTC(const std::string& line, const std::string& cell)
     {
+        auto timings = std::make_shared<nvrtc_timings>();
         getCompileOptions(line);    //get input from magic command line
+        bool table = showTimings;
+        nvrtc_total total(timings, [table](const nvrtc_timings& t) { reportTimings(t, table, true, std::cout); });   //on every return
 
         foundHeaders.clear();   //reset header content
         foundContent.clear();   //reset header content
-        getIncludePaths(cell);  //extract and load headerfile from magic command cell
+        {
+            nvrtc_phase phase(timings.get(), "include scan");
+            getIncludePaths(cell);  //extract and load headerfile from magic command cell
+        }
+
+        //the kernels of a session run either on the GPU or on the CPU
+        if(emulate && initializationDone)
+        {
+            std::cerr << "-emulate can not be used after kernels were compiled for the GPU, restart the kernel" << std::endl;
+            return;
+        }
+        if(!emulate && nvrtc_emulator::instance().isActive())
+        {
+            std::cerr << "The session emulates CUDA on the CPU, use -emulate or restart the kernel" << std::endl;
+            return;
+        }
+        if(emulate)
+        {
+            if(showReport) std::cerr << "-report is not available with -emulate" << std::endl;
+            if(showPTXStats) std::cerr << "-ptxstats is not available with -emulate" << std::endl;
+            emulateCell(cell, *timings);
+            return;
+        }
+
+        //without a CUDA device -ptxstats only compiles the cell, e.g. on build machines
+        if(!initializationDone && (compileOnly || (showPTXStats && !nvrtc_api::instance().hasDevice())))
+        {
+            if(!showPTXStats)
+            {
+                std::cerr << "No CUDA device, only cells with -ptxstats can be compiled" << std::endl;
+                return;
+            }
+            compileOnly = true;
+            analyzeCell(line, cell, timings);
+            return;
+        }
 
         if(!initializationDone) //only at the first attempt 
         {   
-            if(SUCCESS!=loadLibrarys()) return;     //load libs
+            nvrtc_phase phase(timings.get(), "initialization");
+            if(SUCCESS!=loadLibrarys(getCudaIncludePath(line))) return;     //load libs
             
             if(SUCCESS!=loadIncludes(getCudaIncludePath(line))) return; //load header with path
-            
-            if(SUCCESS!=defineCUDACheckError()) return; //define CUDA function for error response
-           
-            if(SUCCESS!=declareNVRTCVar())  return; //define vars
            
             if(SUCCESS!=initDevice())  return;    //init CUDA devices
 
@@ -51,9 +104,323 @@ namespace xcpp
         } 
         if(SUCCESS!=printDeviceName()) return;
 
-    
-        definePTX(cell);            //create PTX code
-        generateKernelFunction();   //load function in modules
+
+        //the build owns a copy of the input, it stays valid while the next cells run
+        nvrtc_build build;
+        build.code = cell;
+        build.headers = foundHeaders;
+        build.contents = foundContent;
+        build.options = compilerOptions;
+        build.useCache = useCache;
+        build.usePCH = useCache && usePCH;
+        build.timings = timings;
+        build.showTimings = showTimings;
+        build.showReport = showReport;
+        build.showPTXStats = showPTXStats;
+
+        build.rdc = relocatableDeviceCode;
+
+        //one compilation per distinct architecture of the devices
+        build.targets = build.rdc ? getLinkTargets(build.options) : getTargets(build.options);
+        if (build.rdc)
+        {
+            //the cell is one unit of the link set, instantiations included
+            build.nameExpressions = instantiations;
+            runBuild(std::move(build));
+            return;
+        }
+
+        //each template instantiation is compiled and cached on its own, adding one does not recompile the others
+        bool plainKernels = instantiations.empty();
+        for (const nvrtc_kernel_declaration& kernel : scanSource(cell).kernels)
+        {
+            if (!kernel.isTemplate) plainKernels = true;
+        }
+        for (const std::string& expression : instantiations)
+        {
+            nvrtc_build instance = build;
+            instance.nameExpressions.push_back(expression);
+            runBuild(std::move(instance));
+        }
+        if (plainKernels) runBuild(std::move(build));
+    }
+
+    void nvrtc::reportTimings(const nvrtc_timings& timings, bool table, bool reply, std::ostream& out)
+    {
+        //machine readable log line, metadata of the execute_reply and the -timings table
+        nl::json report = timings.toJson();
+        report["event"] = "nvrtc_timings";
+        logTimings(report);
+        if (reply) nvrtc_session::instance().setReplyMetadata(nl::json::object({{"nvrtc", {{"timings", report}}}}));
+        if (table) out << timings.table();
+    }
+
+    void nvrtc::reportResources(const nvrtc_loaded_program& program, bool display, std::ostream& out)
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+        nvrtc_resource_report report;
+        for (int i = 0; i < foundCUDADevices; i++)
+        {
+            //the occupancy calculator needs the context of the function
+            CUcontext previous = nullptr;
+            if (api.cuda.cuCtxPushCurrent(contexts[i]) != CUDA_API_SUCCESS) continue;
+            int threadsPerMultiprocessor = 0;
+            api.cuda.cuDeviceGetAttribute(&threadsPerMultiprocessor, CU_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR, devices[i]);
+            std::unordered_map<std::string, nvrtc_ptxas_info> ptxas;
+            if (i < static_cast<int>(program.compilerLogs.size())) ptxas = nvrtc_resource_report::parsePtxasLog(program.compilerLogs[i]);
+
+            for (const std::string& s : program.functionNames)
+            {
+                CUfunction function = program.functions.at(s)[i];
+                if (function == nullptr) continue;
+                nvrtc_kernel_resources kernel;
+                auto expression = program.expressions.find(s);
+                kernel.kernel = expression != program.expressions.end() ? expression->second : nvrtc_compiler::kernelName(s);
+                kernel.device = i;
+                kernel.architecture = "sm_" + std::to_string(deviceArchitectures[i]);
+                if (api.cuda.cuFuncGetAttribute != nullptr)
+                {
+                    api.cuda.cuFuncGetAttribute(&kernel.registers, CU_FUNC_ATTRIBUTE_NUM_REGS, function);
+                    api.cuda.cuFuncGetAttribute(&kernel.sharedBytes, CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES, function);
+                    api.cuda.cuFuncGetAttribute(&kernel.localBytes, CU_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES, function);
+                    api.cuda.cuFuncGetAttribute(&kernel.constBytes, CU_FUNC_ATTRIBUTE_CONST_SIZE_BYTES, function);
+                    api.cuda.cuFuncGetAttribute(&kernel.maxThreads, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, function);
+                }
+                auto info = ptxas.find(s);
+                if (info != ptxas.end()) kernel.ptxas = info->second;
+
+                //theoretical occupancy of the block size suggested for the kernel without dynamic shared memory
+                int minGridSize = 0;
+                int active = 0;
+                if (threadsPerMultiprocessor > 0 && api.cuda.cuOccupancyMaxPotentialBlockSize != nullptr && api.cuda.cuOccupancyMaxActiveBlocksPerMultiprocessor != nullptr
+                    && api.cuda.cuOccupancyMaxPotentialBlockSize(&minGridSize, &kernel.block, function, nullptr, 0, 0) == CUDA_API_SUCCESS
+                    && api.cuda.cuOccupancyMaxActiveBlocksPerMultiprocessor(&active, function, kernel.block, 0) == CUDA_API_SUCCESS)
+                {
+                    kernel.occupancy = static_cast<double>(active) * kernel.block / threadsPerMultiprocessor;
+                }
+                else
+                {
+                    kernel.block = 0;
+                }
+                report.add(kernel);
+            }
+            api.cuda.cuCtxPopCurrent(&previous);
+        }
+        if (report.empty()) return;
+
+        //the reply of a background build is already sent, its output is plain text
+        if (!display)
+        {
+            out << report.table();
+            return;
+        }
+        xeus::get_interpreter().display_data(nl::json::object({{"text/plain", report.table()}, {"text/html", report.html()}}), nl::json::object(), nl::json::object());
+        nvrtc_session::instance().setReplyMetadata(nl::json::object({{"nvrtc", {{"resources", report.toJson()}}}}));
+    }
+
+    void nvrtc::reportPTXStats(const nvrtc_build& build, bool reply, std::ostream& out)
+    {
+        nl::json stats = nl::json::object();
+        for (const nvrtc_target& target : build.targets)
+        {
+            std::string label = target.cubin ? "cubin" : "ptx";
+            for (const std::string& option : target.options)
+            {
+                if (option.rfind("-arch=", 0) == 0) label = option.substr(6);
+            }
+            if (!target.linkArchitecture.empty())
+            {
+                out << "PTX statistics [" << label << "]: not available for -rdc cells" << std::endl;
+                continue;
+            }
+            const std::string& ptx = target.cubin ? target.ptx : target.image;
+            if (ptx.empty())
+            {
+                out << "PTX statistics [" << label << "]: NVRTC returned no PTX, compile with -co -arch=compute_XX" << std::endl;
+                continue;
+            }
+
+            //the functions are shown with the names of the source
+            std::vector<nvrtc_ptx_function> functions = nvrtc_ptx_analyzer::analyze(ptx);
+            for (nvrtc_ptx_function& function : functions)
+            {
+                auto expression = target.expressions.find(function.name);
+                function.name = expression != target.expressions.end() ? expression->second : nvrtc_compiler::kernelName(function.name);
+            }
+            out << "PTX statistics [" << label << "]:" << std::endl << nvrtc_ptx_analyzer::table(functions);
+            stats[label] = nvrtc_ptx_analyzer::toJson(functions);
+        }
+        if (reply && !stats.empty()) nvrtc_session::instance().setReplyMetadata(nl::json::object({{"nvrtc", {{"ptx", stats}}}}));
+    }
+
+    int nvrtc::analyzeCell(const std::string& line, const std::string& cell, const std::shared_ptr<nvrtc_timings>& timings)
+    {
+        {
+            nvrtc_phase phase(timings.get(), "initialization");
+            if(SUCCESS!=nvrtc_api::instance().loadCompiler(getCudaIncludePath(line))) return ERROR_CODE;
+        }
+
+        //one compilation for the architecture of -co or the NVRTC default, nothing is loaded
+        nvrtc_build build;
+        build.code = cell;
+        build.headers = foundHeaders;
+        build.contents = foundContent;
+        build.options = compilerOptions;
+        build.nameExpressions = instantiations;
+        build.useCache = useCache;
+        build.usePCH = useCache && usePCH;
+        build.timings = timings;
+        build.showTimings = showTimings;
+        build.showPTXStats = true;
+        build.cacheKey = compileFingerprint(build);
+        build.targets.push_back(nvrtc_compiler::fixedTarget(build.options, getTargetArchitecture(build.options)));
+        nvrtc_compiler::setTargetKeys(build);
+        if(SUCCESS!=compiler->definePTX(build, build.targets[0]))
+        {
+            std::cerr << build.targets[0].errors << std::endl;
+            return ERROR_CODE;
+        }
+        reportPTXStats(build, true, std::cout);
+        return SUCCESS;
+    }
+
+    void nvrtc::runBuild(nvrtc_build build)
+    {
+        build.cacheKey = compileFingerprint(build);
+        auto loaded = build.rdc ? loadedPrograms.end() : loadedPrograms.find(build.cacheKey);  //-rdc programs depend on the link set
+        std::shared_ptr<nvrtc_loaded_program> program = loaded != loadedPrograms.end() ? loaded->second.lock() : nullptr;
+        if(program && (program->reported || !build.showReport) && !build.showPTXStats)  //unchanged cell, the modules are still loaded
+        {
+            {
+                nvrtc_phase phase(build.timings.get(), "cling");
+                registerKernels(*program);
+                bindKernelFunctions(program, std::cout);
+            }
+            if(build.showReport) reportResources(*program, true, std::cout);
+            return;
+        }
+
+        if(asyncBuild)
+        {
+            startAsyncBuild(std::move(build));  //returns immediately
+            return;
+        }
+
+        if(SUCCESS!=compiler->buildProgram(build))    //create PTX code and load function in modules
+        {
+            std::cerr << build.errors << std::endl;
+            return;
+        }
+        //keep the loaded program, an unchanged rerun of the cell only rebinds the handles
+        program = std::make_shared<nvrtc_loaded_program>(std::move(build.program));
+        loadedPrograms[build.cacheKey] = program;
+        {
+            nvrtc_phase phase(build.timings.get(), "cling");
+            registerKernels(*program);
+            bindKernelFunctions(program, std::cout);
+        }
+        if(build.showReport) reportResources(*program, true, std::cout);
+        if(build.showPTXStats) reportPTXStats(build, true, std::cout);
+    }
+
+    void nvrtc::startAsyncBuild(nvrtc_build build)
+    {
+        nvrtc_session& session = nvrtc_session::instance();
+        std::vector<std::string> names = extractKernelNames(build);
+
+        //the output of the cell is replaced when the build is finished
+        std::string displayId = xeus::new_xguid();
+        std::string message = "Compiling in the background:";
+        for (const std::string& name : names) message += " " + name;
+        xeus::get_interpreter().display_data(nl::json::object({{"text/plain", message}}), nl::json::object(), nl::json::object({{"display_id", displayId}}));
+
+        //xcpp::cuda::kernel waits only for builds which contain the requested kernel
+        auto done = std::make_shared<std::promise<void>>();
+        std::size_t buildId = session.setPending(names, done->get_future().share());
+
+        //remove finished builds
+        auto& builds = *backgroundBuilds;
+        builds.erase(std::remove_if(builds.begin(), builds.end(), [](std::future<void>& f)
+        {
+            return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), builds.end());
+
+        auto shared = std::make_shared<nvrtc_build>(std::move(build));
+        shared->timings = std::make_shared<nvrtc_timings>();    //reported when this build is finished
+
+        //the tasks hold the compiler, not the magic, they may finish after it is gone
+        std::shared_ptr<nvrtc_compiler> buildCompiler = compiler;
+        std::weak_ptr<nvrtc> magic = weak_from_this();
+        builds.push_back(std::async(std::launch::async, [buildCompiler, magic, shared, done, names, buildId, displayId]()
+        {
+            nvrtc_session& session = nvrtc_session::instance();
+            if(SUCCESS==buildCompiler->buildProgram(*shared))
+            {
+                registerKernels(shared->program);
+            }
+            else
+            {
+                session.setFailed(names, shared->errors);
+            }
+            session.clearPending(names, buildId);
+            //cling and the frontend are only used from the shell thread
+            session.post([magic, shared, names, displayId]()
+            {
+                std::ostringstream out;
+                std::shared_ptr<nvrtc> self = magic.lock();
+                if(!shared->errors.empty())
+                {
+                    out << "Background compilation failed:" << std::endl << shared->errors;
+                }
+                else if(self)
+                {
+                    self->finishAsyncBuild(*shared, out);
+                }
+                else
+                {
+                    //the modules are released with the build, the handles must not be used
+                    nvrtc_session::instance().setFailed(names, "The %%nvrtc magic was removed before the kernels were bound");
+                    out << "Compiled in the background, but the %%nvrtc magic was removed" << std::endl;
+                }
+                reportTimings(*shared->timings, shared->showTimings, false, out);    //the reply of the cell is already sent
+                xeus::get_interpreter().update_display_data(nl::json::object({{"text/plain", out.str()}}), nl::json::object(), nl::json::object({{"display_id", displayId}}));
+            });
+            done->set_value();
+        }));
+    }
+
+    void nvrtc::finishAsyncBuild(nvrtc_build& build, std::ostream& out)
+    {
+        //an identical build may have finished first, the new modules are then released
+        std::shared_ptr<nvrtc_loaded_program> program = loadedPrograms[build.cacheKey].lock();
+        if (!program)
+        {
+            program = std::make_shared<nvrtc_loaded_program>(std::move(build.program));
+            loadedPrograms[build.cacheKey] = program;
+        }
+        build.program = nvrtc_loaded_program();
+        out << "Compiled in the background:" << std::endl;
+        {
+            nvrtc_phase phase(build.timings.get(), "cling");
+            registerKernels(*program);
+            bindKernelFunctions(program, out);
+        }
+        if (build.showReport) reportResources(*program, false, out);
+        if (build.showPTXStats) reportPTXStats(build, false, out);
+    }
+
+    void nvrtc::registerKernels(const nvrtc_loaded_program& program)
+    {
+        //the handles are available with the name of the cling variable and the source name
+        nvrtc_session& session = nvrtc_session::instance();
+        for (const std::string& s: program.functionNames)
+        {
+            const std::vector<CUfunction>& functions = program.functions.at(s);
+            auto expression = program.expressions.find(s);
+            if (expression != program.expressions.end()) session.setKernel(expression->second, functions);
+            else session.setKernel(nvrtc_compiler::kernelName(s), functions);
+            session.setKernel(variableName(program, s), functions);
+        }
     }
 
     int nvrtc::getCompileOptions(const std::string& line)
@@ -65,6 +432,37 @@ namespace xcpp
         } else {
             printDeviceInfo=false;
         }
+        //disable the persistent PTX cache for this cell
+        std::regex noCache(R"(-nocache(\s|$))");
+        useCache = !std::regex_search(line, noCache);
+        //disable the precompiled headers for this cell
+        std::regex noPCH(R"(-nopch(\s|$))");
+        usePCH = !std::regex_search(line, noPCH);
+        //compile to LTO-IR and link with the other -rdc cells
+        std::regex rdcOption(R"(-rdc(\s|$))");
+        relocatableDeviceCode = std::regex_search(line, rdcOption);
+        //compile on a background thread, the kernels are available with xcpp::cuda::kernel
+        std::regex async(R"((^|\s)--?async(\s|$))");
+        asyncBuild = std::regex_search(line, async);
+        //print the duration of each phase of the pipeline
+        std::regex timingsOption(R"(-timings(\s|$))");
+        showTimings = std::regex_search(line, timingsOption);
+        //registers, shared and local memory, spills and occupancy of each kernel
+        std::regex reportOption(R"(-report(\s|$))");
+        showReport = std::regex_search(line, reportOption);
+        //instruction mix and memory accesses of the PTX, also without a GPU
+        std::regex ptxStatsOption(R"(-ptxstats(\s|$))");
+        showPTXStats = std::regex_search(line, ptxStatsOption);
+        //compile the kernels with cling and run them on the CPU
+        std::regex emulateOption(R"(-emulate(\s|$))");
+        emulate = std::regex_search(line, emulateOption);
+        //template instantiations, e.g. -instantiate "saxpy<float>", quotes are needed for expressions with spaces
+        std::regex instantiate(R"#(-instantiate\s+(?:"([^"]*)"|(\S+)))#");
+        instantiations.clear();
+        for (std::sregex_iterator i(line.begin(), line.end(), instantiate), end; i != end; ++i)
+        {
+            instantiations.push_back((*i)[1].matched ? (*i)[1].str() : (*i)[2].str());
+        }
         //serach for -co and extract following entry
         std::regex pattern(R"(-co\s+((?:[^\s](?:[^\s]*))))"); 
         std::sregex_iterator it(line.begin(), line.end(), pattern);
@@ -75,62 +473,65 @@ namespace xcpp
             compilerOptions.push_back((*it)[1]); 
             ++it;
         }
+
+        //headers are searched in the -I directories of the compiler options and the -cudaPath directory
+        std::vector<std::string> searchPaths;
+        for (const std::string& option : compilerOptions)
+        {
+            if (option.rfind("-I", 0) == 0) searchPaths.push_back(option.substr(2));
+            else if (option.rfind("--include-path=", 0) == 0) searchPaths.push_back(option.substr(15));
+        }
+        searchPaths.push_back(getCudaIncludePath(line));
+        includeResolver.setSearchPaths(searchPaths);
         return SUCCESS;
     } 
 
     int nvrtc::getIncludePaths(const std::string& content)
     {
-        std::string tempContent;
-        std::string cellWithoutComment=removeComments(content);     //exclude comment to not use comment include definitions
-
-        std::regex pattern(R"#(#include\s*<([^>]+)>|#include\s*"([^"]+)")#");   //search for include instruction
-        std::smatch match;
+        //headers are read and scanned again only if the file changed
+        includeResolver.resolve(content, foundHeaders, foundContent);
+        return SUCCESS;
+    } 
 
+    int nvrtc::loadLibrarys(const std::string includePath)
+    {
+        //load libraries with dlopen, compilation and module loading is done natively
+        nvrtc_api& api = nvrtc_api::instance();
+        if(api.load(includePath)!=SUCCESS) return ERROR_CODE;
 
-        std::string::const_iterator searchStart(cellWithoutComment.cbegin());
-        while (std::regex_search(searchStart, cellWithoutComment.cend(), match, pattern)) {
-            if (match[1].matched) {
-                //if match allready found ignore this one
-                if (std::find(foundHeaders.begin(), foundHeaders.end(), match[1].str()) == foundHeaders.end()) {
-                    tempContent=readFileToString(match[1].str()); // read file
-                    foundHeaders.push_back(match[1].str()); //register file in list
-                    foundContent.push_back(tempContent);    //add content to list
-                    getIncludePaths(tempContent);           //search also in file for include entrys
-                } 
-            } else if (match[2].matched) {
-                //same methode like match 1 but fpr the "" notation
-                if (std::find(foundHeaders.begin(), foundHeaders.end(), match[2].str()) == foundHeaders.end()) {
-                    tempContent=readFileToString(match[2].str());
-                    foundHeaders.push_back(match[2].str());
-                    foundContent.push_back(tempContent);
-                    getIncludePaths(tempContent);
-                } 
-            } 
-            searchStart = match.suffix().first; //set for next match
+        // Load libraries also in cling, the driver API can then be used in the cells
+        for (const std::string& lib : {api.nvrtcLibraryPath(), api.cudaLibraryPath()})
+        {
+            if(m_interpreter.loadLibrary(lib,true)!=cling::Interpreter::CompilationResult::kSuccess)
+            {
+                std::cerr << "Could not load library: " << lib << std::endl;
+                return ERROR_CODE;
+            }
         }
         return SUCCESS;
-    } 
+    }
 
-    int nvrtc::loadLibrarys()
+    int nvrtc::loadIncludes(const std::string includePath)
     {
-        
-        std::string nvrtcLib = "libnvrtc.so";
-        std::string cudaLib = "cuda.so";
-        // Load libraries in cling 
-        if(m_interpreter.loadLibrary(nvrtcLib,true)!=cling::Interpreter::CompilationResult::kSuccess)
+        //runtime API of the magic, e.g. xcpp::cuda::kernel, with the CUDA handle types
+        if(m_interpreter.loadHeader("xcpp/xcuda.hpp")!=cling::Interpreter::CompilationResult::kSuccess)
         {
-            std::cerr << "Could not load library: " << nvrtcLib << std::endl;
+            std::cerr << "Could not load header: xcpp/xcuda.hpp" << std::endl;
             return ERROR_CODE;
         }
-        if(m_interpreter.loadLibrary(cudaLib,true)!=cling::Interpreter::CompilationResult::kSuccess)
+
+        //cuda.h and nvrtc.h take seconds to parse, they are loaded before the first host cell using the driver API
+        cling::Interpreter& interpreter = m_interpreter;
+        nvrtc_session::instance().setHostCellHook([&interpreter, includePath](const std::string& code)
         {
-            std::cerr << "Could not load library: " << cudaLib << std::endl;
-            return ERROR_CODE;
-        }
+            if (!usesDriverAPI(code)) return false;
+            loadDriverHeaders(interpreter, includePath);
+            return true;
+        });
         return SUCCESS;
     }
 
-    int nvrtc::loadIncludes(const std::string includePath)
+    int nvrtc::loadDriverHeaders(cling::Interpreter& interpreter, const std::string& includePath)
     {
         //load headerfiles
         std::string nvrtcHeader = "/usr/local/cuda/include/nvrtc.h";    
@@ -142,20 +543,32 @@ namespace xcpp
             cudaHeader = includePath + "cuda.h";
         } 
         //load header in cling
-        if(m_interpreter.loadHeader(nvrtcHeader)!=cling::Interpreter::CompilationResult::kSuccess)
+        if(interpreter.loadHeader(nvrtcHeader)!=cling::Interpreter::CompilationResult::kSuccess)
         {
             std::cerr << "Could not load header: " << nvrtcHeader << std::endl;
             return ERROR_CODE;
         }
-        if(m_interpreter.loadHeader(cudaHeader)!=cling::Interpreter::CompilationResult::kSuccess)
+        if(interpreter.loadHeader(cudaHeader)!=cling::Interpreter::CompilationResult::kSuccess)
         {
             std::cerr << "Could not load header: " << cudaHeader << std::endl;
             return ERROR_CODE;
         }
-        return SUCCESS;
+        return defineCUDACheckError(interpreter);   //define CUDA function for error response
     }
-    
-    int nvrtc::defineCUDACheckError()
+
+    bool nvrtc::usesDriverAPI(const std::string& code)
+    {
+        //names of cuda.h and nvrtc.h, except the handle types declared by xcpp/xcuda.hpp
+        static const std::regex driverName(R"(\b(cu[A-Z]\w*|CU[a-z_]\w*|CUDA_\w+|nvrtc[A-Z]\w*|NVRTC_\w+|checkCudaError)\b)");
+        static const std::unordered_set<std::string> declared = {"CUdevice", "CUdevice_v1", "CUdeviceptr", "CUdeviceptr_v2", "CUcontext", "CUmodule", "CUfunction", "CUstream", "CUevent", "CUgraph", "CUgraphExec"};
+        for (std::sregex_iterator i(code.begin(), code.end(), driverName), end; i != end; ++i)
+        {
+            if (declared.count(i->str()) == 0) return true;
+        }
+        return false;
+    }
+
+    int nvrtc::defineCUDACheckError(cling::Interpreter& interpreter)
     {
         /*
             define function in cling
@@ -172,13 +585,13 @@ namespace xcpp
         std::string clingInput="void checkCudaError(nvrtcResult result){ if(result != NVRTC_SUCCESS) {std::cerr <<\"NVRTC Error:\" << nvrtcGetErrorString(result) << std::endl;return -1; }}";
         cling::Value output; 
         //load iostream header
-        if(m_interpreter.loadHeader("iostream")!=cling::Interpreter::CompilationResult::kSuccess)
+        if(interpreter.loadHeader("iostream")!=cling::Interpreter::CompilationResult::kSuccess)
         {
             std::cerr << "Could not load header: " <<  "iostream" << std::endl;
             return ERROR_CODE;
         } 
 
-        if(m_interpreter.process(clingInput, &output)!=cling::Interpreter::CompilationResult::kSuccess)
+        if(interpreter.process(clingInput, &output)!=cling::Interpreter::CompilationResult::kSuccess)
         {
             std::cerr << "Could not define CudaErrorFunction" << std::endl;
             return ERROR_CODE;
@@ -199,7 +612,7 @@ namespace xcpp
         */
 
         clingInput="void checkCudaError(CUresult result){ if(result != CUDA_SUCCESS) {const char* errorStr = nullptr; cuGetErrorString(result, &errorStr); std::cerr <<\"CUDA Error:\" << errorStr << std::endl;return -1; }}";
-        if(m_interpreter.process(clingInput, &output)!=cling::Interpreter::CompilationResult::kSuccess)
+        if(interpreter.process(clingInput, &output)!=cling::Interpreter::CompilationResult::kSuccess)
         {
             std::cerr << "Could not define CudaErrorFunction" << std::endl;
             return ERROR_CODE;
@@ -207,329 +620,503 @@ namespace xcpp
         return SUCCESS;
     }
     
-    int nvrtc::declareNVRTCVar()
-    {
-        //devine result var
-        if(m_interpreter.declare("nvrtcResult XCnvrtc_result;")!=cling::Interpreter::CompilationResult::kSuccess)
-        {
-            std::cerr << "Could not declare nvrtcResult" << std::endl;
-            return ERROR_CODE;
-        } 
-        return SUCCESS;
-    } 
-    
     int nvrtc::initDevice()
     {
-        cling::Value output;
-        std::string clingInput= "cuInit(0);"; 
-        m_interpreter.process(clingInput, &output);
-        //get number of CUDA devices in cling context and return it to xeus context
-        clingInput= "CUdevice XCnvrtc_deviceInfo; int XCnvrtc_CUDAdeviceCount = 0; checkCudaError(cuDeviceGetCount(&XCnvrtc_CUDAdeviceCount));XCnvrtc_CUDAdeviceCount;"; 
-        m_interpreter.process(clingInput, &output);
-        foundCUDADevices= output.getLL();
-        //for each device create device context und module
+        cuda_functions& cu = nvrtc_api::instance().cuda;
+        if(SUCCESS!=checkCUDA(cu.cuInit(0), "cuInit")) return ERROR_CODE;
+        if(SUCCESS!=checkCUDA(cu.cuDeviceGetCount(&foundCUDADevices), "cuDeviceGetCount")) return ERROR_CODE;
+
+        //for each device create device context, the handles are declared once in cling
+        std::string clingInput = "int XCnvrtc_CUDAdeviceCount = " + std::to_string(foundCUDADevices) + ";";
         for (int i = 0; i < foundCUDADevices; i++)
         {
-            if(m_interpreter.declare("CUdevice XCnvrtc_device"+ std::to_string(i) +";")!=cling::Interpreter::CompilationResult::kSuccess)
+            CUdevice device;
+            CUcontext context;
+            if(SUCCESS!=checkCUDA(cu.cuDeviceGet(&device, i), "cuDeviceGet"))
             {
                 std::cerr << "Could not init device: " << std::to_string(i) <<std::endl;
-                  return ERROR_CODE;
+                return ERROR_CODE;
             }
-            clingInput= "checkCudaError(cuDeviceGet(&XCnvrtc_device"+ std::to_string(i) + ", " + std::to_string(i) + "));"; 
-            m_interpreter.process(clingInput, &output);
-            m_interpreter.declare("CUcontext XCnvrtc_cuContext"+std::to_string(i)+";");
-            clingInput = "checkCudaError(cuCtxCreate(&XCnvrtc_cuContext" + std::to_string(i) + ", 0, XCnvrtc_device" + std::to_string(i) + "));";
-            m_interpreter.process(clingInput, &output);
-            m_interpreter.declare("CUmodule XCnvrtc_cuModule"+ std::to_string(i) + ";");
+            if(SUCCESS!=checkCUDA(cu.cuCtxCreate(&context, 0, device), "cuCtxCreate")) return ERROR_CODE;
+            devices.push_back(device);
+            contexts.push_back(context);
+
+            int major = 0, minor = 0;
+            cu.cuDeviceGetAttribute(&major, CU_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device);
+            cu.cuDeviceGetAttribute(&minor, CU_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, device);
+            deviceArchitectures.push_back(major * 10 + minor);
+
+            clingInput += "CUdevice XCnvrtc_device" + std::to_string(i) + " = " + std::to_string(device) + ";";
+            clingInput += "CUcontext XCnvrtc_cuContext" + std::to_string(i) + " = (CUcontext)" + std::to_string(reinterpret_cast<std::uintptr_t>(context)) + "UL;";
         } 
+        if(m_interpreter.declare(clingInput)!=cling::Interpreter::CompilationResult::kSuccess)
+        {
+            std::cerr << "Could not declare CUDA devices" << std::endl;
+            return ERROR_CODE;
+        }
+        nvrtc_stream_pool::instance().setContexts(contexts);      //xcpp::cuda::stream and synchronize_all
+        if(foundCUDADevices>1)     //one thread per context for concurrent module loading and xcpp::cuda::launch_all
+        {
+            deviceWorkers->start(contexts);
+            nvrtc_stream_pool::instance().setWorkers(deviceWorkers);
+        }
+        compiler->setDevices(contexts, deviceWorkers);
+        if(foundCUDADevices>0) cu.cuCtxSetCurrent(contexts[0]);    //cells work with the first device by default
         return SUCCESS;
     }
 
     int nvrtc::getDeviceInfo()
     {
+        cuda_functions& cu = nvrtc_api::instance().cuda;
+        int maxVersion = 0, maxVersionIndex = 0;
+        int minVersion = 999, minVersionIndex = 999;
 
-        //for each device get infos and print them, the complete function is executed in cling context
-        cling::Value output;
-        std::string clingInput= "std::cout << \"Found CUDA capable devices: \"<< XCnvrtc_CUDAdeviceCount <<std::endl;"; 
-        m_interpreter.process(clingInput, &output);
-        clingInput = R"RawMarker( 
+        std::cout << "Found CUDA capable devices: "<< foundCUDADevices <<std::endl;
+        //for each device get infos and print them
+        for (int i = 0; i < foundCUDADevices; i++)
+        {
+            char gpuName[256];
+            int version = 0, versionIndex = 0;
+            if(SUCCESS!=checkCUDA(cu.cuDeviceGetName(gpuName, 256, devices[i]), "cuDeviceGetName")) return ERROR_CODE;
+            cu.cuDeviceGetAttribute(&version, CU_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, devices[i]);
+            cu.cuDeviceGetAttribute(&versionIndex, CU_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, devices[i]);
 
-            int XCnvrtc_maxVersion = 0, XCnvrtc_maxVersionIndex = 0;
-            int XCnvrtc_minVersion = 999, XCnvrtc_minVersionIndex = 999;
-            
-            for (int i = 0; i < XCnvrtc_CUDAdeviceCount; i++) {
-
-                cuDeviceGet(&XCnvrtc_deviceInfo, i);
-        
-                char XCnvrtc_gpuName[256];
-                cuDeviceGetName(XCnvrtc_gpuName, 256, XCnvrtc_deviceInfo);
-        
-                int XCnvrtc_version, XCnvrtc_versionIndex;
-                cuDeviceGetAttribute(&XCnvrtc_version, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, XCnvrtc_deviceInfo);
-                cuDeviceGetAttribute(&XCnvrtc_versionIndex, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, XCnvrtc_deviceInfo);
-        
-                std::cout << "GPU Number:" << i << ": " << XCnvrtc_gpuName << std::endl;
-                std::cout << "Compute Capability: " << XCnvrtc_version << "." << XCnvrtc_versionIndex << std::endl;
-                std::cout << "Recommended NVCC-Architecture: -arch=sm_" << XCnvrtc_version  <<  XCnvrtc_versionIndex << std::endl;
-        
-                
-                if (XCnvrtc_version > XCnvrtc_maxVersion || (XCnvrtc_version == XCnvrtc_maxVersion && XCnvrtc_versionIndex > XCnvrtc_maxVersionIndex)) {
-                    XCnvrtc_maxVersion = XCnvrtc_version;
-                    XCnvrtc_maxVersionIndex = XCnvrtc_versionIndex;
-                }
-        
-                if (XCnvrtc_version < XCnvrtc_minVersion || (XCnvrtc_version == XCnvrtc_minVersion && XCnvrtc_versionIndex < XCnvrtc_minVersionIndex)) {
-                    XCnvrtc_minVersion = XCnvrtc_version;
-                    XCnvrtc_minVersionIndex = XCnvrtc_versionIndex;
-                }
+            std::cout << "GPU Number:" << i << ": " << gpuName << std::endl;
+            std::cout << "Compute Capability: " << version << "." << versionIndex << std::endl;
+            std::cout << "Recommended NVCC-Architecture: -arch=sm_" << version  <<  versionIndex << std::endl;
+
+            if (version > maxVersion || (version == maxVersion && versionIndex > maxVersionIndex)) {
+                maxVersion = version;
+                maxVersionIndex = versionIndex;
             }
-            if(XCnvrtc_CUDAdeviceCount>1)
-            {
-                std::cout << "Max. Compute Capability: " << XCnvrtc_maxVersion << "." << XCnvrtc_maxVersionIndex << std::endl;
-                std::cout << "Min. Compute Capability: " << XCnvrtc_minVersion << "." << XCnvrtc_minVersionIndex << std::endl;
+            if (version < minVersion || (version == minVersion && versionIndex < minVersionIndex)) {
+                minVersion = version;
+                minVersionIndex = versionIndex;
             }
+        }
+        if(foundCUDADevices>1)
+        {
+            std::cout << "Max. Compute Capability: " << maxVersion << "." << maxVersionIndex << std::endl;
+            std::cout << "Min. Compute Capability: " << minVersion << "." << minVersionIndex << std::endl;
+        }
+        return SUCCESS;   
+    }
 
+    int nvrtc::bindKernelFunctions(const std::shared_ptr<nvrtc_loaded_program>& loaded, std::ostream& out)
+    {
+        const nvrtc_loaded_program& program = *loaded;
+        std::string declareInput;
 
-            )RawMarker";
-            if(m_interpreter.process(clingInput, &output)!=cling::Interpreter::CompilationResult::kSuccess)
+        // collect the names of new functions, they are declared in one step
+        for (const std::string& s: program.functionNames)
+        {
+            if (registeredFunctionNames.count(s) == 0)
             {
-                return ERROR_CODE;
-            } 
-        return SUCCESS;   
+                for (int i = 0; i < foundCUDADevices; i++)
+                {
+                    //if more then one GPU then add index _GPU + number
+                    declareInput += "CUfunction " + variableName(program, s) + (foundCUDADevices==1 ? "" : "_GPU" + std::to_string(i)) + ";";
+                }
+                registeredFunctionNames.insert(s);
+            }
+        }
+        if(!declareInput.empty() && m_interpreter.declare(declareInput)!=cling::Interpreter::CompilationResult::kSuccess)
+        {
+            std::cerr << "Could not declare kernel functions" << std::endl;
+            return ERROR_CODE;
+        }
+
+        // pass the handle of each function and GPU to cling
+        for (const std::string& s: program.functionNames)
+        { 
+            const std::vector<CUfunction>& functions = program.functions.at(s);
+            for (int i = 0; i < foundCUDADevices; i++)
+            {
+                if (functions[i] == nullptr) continue;
+                std::string variable = variableName(program, s) + (foundCUDADevices==1 ? "" : "_GPU" + std::to_string(i));
+                bindKernelHandle(variable, functions[i]);
+                out << variable << std::endl;
+            }
+            //the previous program of the variable is unloaded if no other variable uses it
+            boundPrograms[variableName(program, s)] = loaded;
+        } 
+
+        //forget unloaded programs
+        for (auto it = loadedPrograms.begin(); it != loadedPrograms.end();)
+        {
+            if (it->second.expired()) it = loadedPrograms.erase(it);
+            else ++it;
+        }
+        return declareLaunchers(program, out);
     }
 
-    int nvrtc::definePTX(const std::string& code)
+    int nvrtc::declareLaunchers(const nvrtc_loaded_program& program, std::ostream& out)
     {
-        cling::Value output;
-        std::string clingInput;
-        std::string clingInputBackup;
-        std::string clingInputIncludeNames;
-        std::string clingInputIncludeContent;
-        std::string generateProgVarName = "XCnvrtc_prog"; 
-        int headerIndex=0;
-        index++;
-
-        generateProgVarName += std::to_string(index); //add index to programm var name, making repeated execution possible
-        
-        std::string declareInput = "nvrtcProgram " +generateProgVarName + ";"; 
-        m_interpreter.declare(declareInput);
-        std::string declarePTXSizeInput = "size_t XCnvrtc_ptxSize" + std::to_string(index); //also add index
-        declarePTXSizeInput += ";";
-        m_interpreter.declare(declarePTXSizeInput);
-
-
-        clingInput= "const char *XCnvrtc_kernelCodeInCharArrey"+ std::to_string(index);
-        clingInput += "=R\"RawMarker(" + code + ")RawMarker\";";    //add string values from cell in string var in cling 
-        m_interpreter.process(clingInput, &output);
-
-        //create the nvrtcCreateProgramm function line
-        clingInput = "checkCudaError(nvrtcCreateProgram(&" + generateProgVarName; 
-        clingInput += ",XCnvrtc_kernelCodeInCharArrey"+ std::to_string(index);
-
-        if(foundHeaders.size()==0)
-        {
-            clingInput += ",\"xeus_cling.cu\",0,nullptr,nullptr));";    // finisch the command with nullptr when no header is used
-        } 
-        else
+        //typed launchers refer to the CUfunction variables, they are declared once
+        for (const std::string& s: program.functionNames)
         {
-            // if header files in use, then create const char* header names array
-            clingInputBackup = "const char* XCnvrtc_header_names[] = {";
-            
-            for (const auto& header : foundHeaders) { //add headernames to header names array for each header entry
-                clingInputIncludeNames  ="const char* XCnvrtc_header"+std::to_string(headerIndex) +"_name =\"" + header + "\";";    //header name
+            auto types = program.launcherTypes.find(s);
+            if (types == program.launcherTypes.end()) continue;
+
+            std::string launcherName = nvrtc_compiler::kernelName(s);
+            if (launcherName == variableName(program, s)) launcherName += "_launcher";  //extern "C" kernel, the name is used by the CUfunction
+            for (int i = 0; i < foundCUDADevices; i++)
+            {
+                std::string suffix = foundCUDADevices==1 ? "" : "_GPU" + std::to_string(i);
+                std::string launcher = launcherName + suffix;
+                auto declared = declaredLaunchers.find(launcher);
+                if (declared != declaredLaunchers.end())
+                {
+                    if (!declared->second.empty() && declared->second != types->second)
+                    {
+                        std::cerr << "Launcher " << launcher << " keeps the signature of its first declaration (" << declared->second << ")" << std::endl;
+                    }
+                    continue;
+                }
 
-                m_interpreter.process(clingInputIncludeNames, &output); //cling input
+                std::string declareInput = "xcpp::cuda::typed_kernel<" + types->second + "> " + launcher + "(" + variableName(program, s) + suffix + ");";
+                bool success = m_interpreter.declare(declareInput)==cling::Interpreter::CompilationResult::kSuccess;
+                declaredLaunchers[launcher] = success ? types->second : "";     //parameter types unknown in cling, not retried
+                if (success) out << launcher << ".launch(grid, block, stream" << (types->second.empty() ? "" : ", " + types->second) << ")" << std::endl;
+            }
+        }
+        return SUCCESS;
+    }
 
-                clingInputBackup += "XCnvrtc_header"+ std::to_string(headerIndex) +"_name,";    //add to array
-                headerIndex++;
+    int nvrtc::bindKernelHandle(const std::string& variable, CUfunction function)
+    {
+        //the address of the cling variable is resolved once, later runs write the handle
+        //directly and add nothing to the translation unit of the session
+        auto it = clingVariables.find(variable);
+        if (it == clingVariables.end())
+        {
+            void* address = m_interpreter.getAddressOfGlobal(variable);
+            if (address == nullptr)
+            {
+                //fallback: ask the interpreter once for the address
+                cling::Value output;
+                if(m_interpreter.process("(void*)&" + variable + ";", &output)!=cling::Interpreter::CompilationResult::kSuccess
+                   || output.getPtr() == nullptr)
+                {
+                    std::cerr << "Could not set kernel function: " << variable << std::endl;
+                    return ERROR_CODE;
+                }
+                address = output.getPtr();
             }
+            it = clingVariables.emplace(variable, address).first;
+        }
+        *static_cast<CUfunction*>(it->second) = function;
+        return SUCCESS;
+    }
 
-            clingInputBackup += "};";
-            m_interpreter.process(clingInputBackup, &output); //put array to cling
+    std::string nvrtc::compileFingerprint(const nvrtc_build& build)
+    {
+        //everything which changes the generated code is part of the key
+        int major = 0, minor = 0;
+        nvrtc_api::instance().nvrtc.nvrtcVersion(&major, &minor);
+        std::vector<std::string> parts = {build.code, std::to_string(major) + "." + std::to_string(minor), getTargetArchitecture(build.options)};
+        if (build.rdc) parts.push_back("-rdc");
+        for (std::size_t i = 0; i < build.headers.size(); i++)
+        {
+            parts.push_back(build.headers[i]);
+            parts.push_back(build.contents[i]);
+        }
+        parts.insert(parts.end(), build.options.begin(), build.options.end());
+        if (!build.nameExpressions.empty())
+        {
+            parts.push_back("-instantiate");
+            parts.insert(parts.end(), build.nameExpressions.begin(), build.nameExpressions.end());
+        }
+        return nvrtc_cache::fingerprint(parts);
+    }
 
+    std::string nvrtc::getTargetArchitecture(const std::vector<std::string>& options)
+    {
+        //architecture set with -co, otherwise the NVRTC default is used
+        for (const std::string& option : options)
+        {
+            if (option.rfind("-arch", 0) == 0 || option.rfind("--gpu-architecture", 0) == 0) return option;
+        }
+        return "default";
+    }
 
-            headerIndex=0;
-            //same procedure like the header name but with header content instead of names
-            clingInputBackup = "const char* XCnvrtc_headers[] = {";
-            for (const auto& content : foundContent) {
-                  clingInputIncludeContent  ="const char* XCnvrtc_header"+std::to_string(headerIndex) +"_content = R\"RawMarker(\n" + content + ")RawMarker\";";
-                  m_interpreter.process(clingInputIncludeContent, &output);
-  
-                  clingInputBackup += "XCnvrtc_header"+ std::to_string(headerIndex) +"_content,";
-                  headerIndex++;
-              }
-              clingInputBackup += "};";
-              m_interpreter.process(clingInputBackup, &output);
+    int nvrtc::checkCUDA(int result, const std::string& call)
+    {
+        if (result != CUDA_API_SUCCESS)
+        {
+            std::cerr << "CUDA Error:" << call << ": " << nvrtc_api::instance().cudaError(result) << std::endl;
+            return ERROR_CODE;
+        }
+        return SUCCESS;
+    }
 
+    std::vector<nvrtc_target> nvrtc::getTargets(const std::vector<std::string>& options)
+    {
+        std::vector<nvrtc_target> targets;
+        nvrtc_functions& rtc = nvrtc_api::instance().nvrtc;
 
-            clingInput += ",\"xeus_cling.cu\","+ std::to_string(foundHeaders.size()) +",XCnvrtc_headers,XCnvrtc_header_names));";
-        } 
-        
-        m_interpreter.process(clingInput, &output); //insert nvrtcCreateProgram instruction to cling
-        
+        //an architecture set with -co is used for all devices
+        std::string architecture = getTargetArchitecture(options);
+        if (architecture != "default")
+        {
+            nvrtc_target target = nvrtc_compiler::fixedTarget(options, architecture);
+            for (int i = 0; i < foundCUDADevices; i++) target.devices.push_back(i);
+            targets.push_back(target);
+            return targets;
+        }
 
-        //Add compiler options
-        if(compilerOptions.size()==0) clingInput = "XCnvrtc_result =nvrtcCompileProgram(" + generateProgVarName + ",0,nullptr);"; // no compiler options execute with nullptr
-        else
+        //devices newer than NVRTC get PTX, the driver compiles it for them
+        std::vector<int> supported;
+        if (rtc.nvrtcGetNumSupportedArchs != nullptr && rtc.nvrtcGetSupportedArchs != nullptr)
         {
-            //create array with options
-            std::string options = "const char* XCnvrtc_options[] = {\n";    
+            int count = 0;
+            rtc.nvrtcGetNumSupportedArchs(&count);
+            supported.resize(count);
+            if (count > 0) rtc.nvrtcGetSupportedArchs(supported.data());
+        }
 
-            for (const std::string& sopt : compilerOptions) {//add options to array
-                options += "\"" + sopt + "\",";
-            }
-            options += "};";
-            m_interpreter.process(options, &output);
+        //SASS for each distinct compute capability, devices of the same class share the image
+        for (int i = 0; i < foundCUDADevices; i++)
+        {
+            bool cubin = rtc.nvrtcGetCUBIN != nullptr
+                && (supported.empty() || std::find(supported.begin(), supported.end(), deviceArchitectures[i]) != supported.end());
+            std::vector<std::string> targetOptions = options;
+            if (cubin) targetOptions.push_back("-arch=sm_" + std::to_string(deviceArchitectures[i]));
 
-            clingInput = "XCnvrtc_result =nvrtcCompileProgram(" + generateProgVarName + "," + std::to_string(compilerOptions.size()) +",XCnvrtc_options);"; //execute with options 
-        }  
-    
-        m_interpreter.process(clingInput, &output); //insert compile instruction to cling
-
-        //print errors if compilation is not without errors or warnings
-        clingInput = R"RawMarker( 
-            if (XCnvrtc_result != NVRTC_SUCCESS) {
-                std::cerr << nvrtcGetErrorString(XCnvrtc_result) << std::endl;
-                size_t XCnvrtc_log_size;
-                nvrtcGetProgramLogSize()RawMarker" + generateProgVarName + R"RawMarker(, &XCnvrtc_log_size);
-                char* XCnvrtc_log = new char[XCnvrtc_log_size];
-                nvrtcGetProgramLog()RawMarker" + generateProgVarName + R"RawMarker(, XCnvrtc_log);
-                std::cerr  << XCnvrtc_log << std::endl; 
-                delete[] XCnvrtc_log;
-                return -1;
+            auto target = std::find_if(targets.begin(), targets.end(), [&targetOptions](const nvrtc_target& t) { return t.options == targetOptions; });
+            if (target == targets.end())
+            {
+                targets.emplace_back();
+                target = targets.end() - 1;
+                target->options = targetOptions;
+                target->cubin = cubin;
             }
-        )RawMarker";
-        m_interpreter.process(clingInput, &output);
-
-        // generate PTX Code 
-        clingInput = "checkCudaError(nvrtcGetPTXSize(" + generateProgVarName + ",&XCnvrtc_ptxSize" + std::to_string(index) + "));";
-        m_interpreter.process(clingInput, &output);
-        m_interpreter.declare("char* XCnvrtc_ptx" + std::to_string(index) + " = new char[XCnvrtc_ptxSize" + std::to_string(index) + "];");
-        clingInput = "checkCudaError(nvrtcGetPTX(" + generateProgVarName + ",XCnvrtc_ptx" + std::to_string(index) + "));";
-        m_interpreter.process(clingInput, &output);
-        // get PTX Code and get the output from cling
-        clingInput = "std::string ptxString(XCnvrtc_ptx" + std::to_string(index) + ", XCnvrtc_ptxSize"+ std::to_string(index) + ");";
-        m_interpreter.process(clingInput, &output);
-        nl::json pub_data = mime_repr(output);  //output from cling as string data
-
-        listOfNames.clear();                    //clear data before rerun                                                                
-        listOfNames = extractFunctionNames(pub_data["text/plain"].get<std::string>());  //search for function in PTX Code
- 
-        return SUCCESS;
-    } 
+            target->devices.push_back(i);
+        }
+        return targets;
+    }
 
-    int nvrtc::generateKernelFunction()
-    { 
-        cling::Value output;
-        std::string clingInput;
+    std::vector<nvrtc_target> nvrtc::getLinkTargets(const std::vector<std::string>& options)
+    {
+        //LTO-IR for the virtual architecture, nvJitLink generates the SASS of the real one
+        std::vector<nvrtc_target> targets;
+        std::string architecture = getTargetArchitecture(options);
+        std::vector<std::string> compileOptions;
+        for (const std::string& option : options)
+        {
+            if (option != architecture) compileOptions.push_back(option);
+        }
+        compileOptions.push_back("-dlto");
 
-        //for each GPU generate cotext and module with PTX
+        //an architecture set with -co is used for all devices
+        std::smatch number;
+        std::regex archNumber(R"(_(\d+)[a-z]?$)");
+        std::string fixed = architecture != "default" && std::regex_search(architecture, number, archNumber) ? number[1].str() : "";
         for (int i = 0; i < foundCUDADevices; i++)
         {
-            clingInput = "cuCtxSetCurrent(XCnvrtc_cuContext"+ std::to_string(i) + ");";
-            m_interpreter.process(clingInput, &output);
-            clingInput = "cuModuleLoadData(&XCnvrtc_cuModule" + std::to_string(i) + ", XCnvrtc_ptx" + std::to_string(index) + ");";
-            m_interpreter.process(clingInput, &output);
+            std::string version = fixed.empty() ? std::to_string(deviceArchitectures[i]) : fixed;
+            std::string linkArchitecture = "sm_" + version;
+            auto target = std::find_if(targets.begin(), targets.end(), [&linkArchitecture](const nvrtc_target& t) { return t.linkArchitecture == linkArchitecture; });
+            if (target == targets.end())
+            {
+                targets.emplace_back();
+                target = targets.end() - 1;
+                target->options = compileOptions;
+                target->options.push_back("-arch=compute_" + version);
+                target->linkArchitecture = linkArchitecture;
+                target->cubin = true;
+            }
+            target->devices.push_back(i);
         }
-        // for each function create a function 
-        for (std::string s: listOfNames)
-        { 
-            // if the function name is allready registered then the registration if the CU funciton name is not nessesary and only print the found function
-            if (std::find(registeredFunctionNames.begin(), registeredFunctionNames.end(), s) == registeredFunctionNames.end())
+        return targets;
+    }
+
+    int nvrtc::emulateCell(const std::string& cell, nvrtc_timings& timings)
+    {
+        nvrtc_emulator& emulator = nvrtc_emulator::instance();
+        if(!emulator.isActive())  //only at the first emulated cell, no CUDA library is needed
+        {
+            nvrtc_phase phase(&timings, "initialization");
+            for (const char* header : {"xcpp/xcuda.hpp", "xcpp/xcuda_emulation.hpp"})
             {
-                for (int i = 0; i < foundCUDADevices; i++)
+                if(m_interpreter.loadHeader(header)!=cling::Interpreter::CompilationResult::kSuccess)
                 {
-                    if(foundCUDADevices==1) 
-                    {
-                        clingInput = "CUfunction "+ demangle(s) +";";
-                        m_interpreter.declare(clingInput);
-                        std::cout << demangle(s) << std::endl;
-                    } 
-                    else //if more then one GPU then add index _GPU + number
-                    {
-                        clingInput = "CUfunction "+ demangle(s) +"_GPU"+ std::to_string(i) + ";";
-                        m_interpreter.declare(clingInput);
-                        std::cout << demangle(s) << "_GPU" << std::to_string(i)<< std::endl;
-                    } 
-                } 
-                registeredFunctionNames.push_back(s);  
+                    std::cerr << "Could not load header: " << header << std::endl;
+                    return ERROR_CODE;
+                }
             }
-            else
+            emulator.activate();
+            foundCUDADevices = 1;   //one CUfunction variable per kernel, without _GPU suffix
+            std::cout << "Emulating CUDA on " << emulator.workerCount() << " CPU threads" << std::endl;
+        }
+
+        //the headers of the cell are included by cling
+        for (const std::string& option : compilerOptions)
+        {
+            std::string path;
+            if (option.rfind("-I", 0) == 0) path = option.substr(2);
+            else if (option.rfind("--include-path=", 0) == 0) path = option.substr(15);
+            if (!path.empty() && emulatedIncludePaths.insert(path).second) m_interpreter.AddIncludePaths(path);
+        }
+
+        //each run of the cell gets its own namespace, the kernels can be redefined
+        std::string space = "xcpp_emulated_" + std::to_string(emulatedCells++);
+        nvrtc_build build;
+        build.code = cell;
+        nvrtc_loaded_program& program = build.program;
+        {
+            nvrtc_phase phase(&timings, "cling compile");
+            if(m_interpreter.declare(emulatedSource(cell, space))!=cling::Interpreter::CompilationResult::kSuccess)
             {
-                for (int i = 0; i < foundCUDADevices; i++)
-                {
-                    if(foundCUDADevices==1)
-                    {
-                        std::cout << demangle(s) << std::endl;
-                    } 
-                    else
-                    {
-                        std::cout << demangle(s) << "_GPU" << std::to_string(i)<< std::endl;
-                    } 
-                } 
-            }  
+                std::cerr << "Could not compile the emulated kernels" << std::endl;
+                return ERROR_CODE;
+            }
+        }
 
-            // load functions in the module for each GPU
-            for (int i = 0; i < foundCUDADevices; i++)
+        //kernels with __syncthreads run their threads as fibers, the others in a loop;
+        //a __device__ helper of an earlier cell may call it, so once a cell of the
+        //session used a barrier all later kernels run as fibers
+        if (cell.find("__syncthreads") != std::string::npos) emulatedBarriers = true;
+        for (const std::string& content : foundContent)
+        {
+            if (content.find("__syncthreads") != std::string::npos) emulatedBarriers = true;
+        }
+        bool barrier = emulatedBarriers;
+
+        nvrtc_phase phase(&timings, "cling");
+        std::unordered_map<std::string, int> overloads;
+        std::vector<std::string> names;
+        for (const nvrtc_kernel_declaration& kernel : scanSource(cell).kernels)
+        {
+            if (kernel.isTemplate) continue;
+            if (overloads[kernel.name]++ == 0) names.push_back(kernel.name);
+        }
+        for (const std::string& name : names)
+        {
+            //the address of an overloaded kernel is ambiguous
+            if (overloads[name] > 1)
+            {
+                std::cerr << "Overloaded kernel " << name << " can not be emulated" << std::endl;
+                continue;
+            }
+            CUfunction function = registerEmulatedKernel(name, space + "::" + name, barrier);
+            if (function == nullptr) continue;
+            program.functionNames.push_back(name);     //named like extern "C" kernels
+            program.functions[name] = {function};
+        }
+        for (const std::string& expression : instantiations)
+        {
+            CUfunction function = registerEmulatedKernel(expression, space + "::" + expression, barrier);
+            if (function == nullptr) continue;
+            program.functionNames.push_back(expression);
+            program.expressions[expression] = expression;
+            program.functions[expression] = {function};
+        }
+
+        compiler->collectLauncherTypes(build);
+        auto loaded = std::make_shared<nvrtc_loaded_program>(std::move(build.program));
+        registerKernels(*loaded);
+        return bindKernelFunctions(loaded, std::cout);
+    }
+
+    std::string nvrtc::emulatedSource(const std::string& cell, const std::string& space)
+    {
+        //comments are blanked, the line numbers of errors stay the same
+        std::string code = scanSource(cell).code;
+
+        //includes are moved in front of the namespace of the cell, the shim replaces the CUDA runtime headers
+        static const std::regex include(R"(^\s*#\s*include\s*[<"]([^>"]+)[>"].*$)");
+        std::string includes;
+        std::istringstream lines(code);
+        std::string body;
+        for (std::string line; std::getline(lines, line);)
+        {
+            std::smatch match;
+            if (std::regex_match(line, match, include))
             {
-                if(foundCUDADevices==1)
+                std::string header = match[1].str();
+                if (header.rfind("cuda_runtime", 0) != 0 && header != "device_launch_parameters.h" && header != "cuda.h") includes += line + "\n";
+                line.clear();
+            }
+            body += line + "\n";
+        }
+
+        //the kernels are found in the namespace, C linkage would collide with the reruns of the cell
+        static const std::regex externBlock(R"(extern\s+"C"\s*\{)");
+        std::smatch match;
+        while (std::regex_search(body, match, externBlock))
+        {
+            std::size_t open = match.position(0) + match.length(0) - 1;
+            int depth = 0;
+            for (std::size_t i = open; i < body.size(); i++)
+            {
+                if (body[i] == '{') depth++;
+                else if (body[i] == '}' && --depth == 0)
                 {
-                    clingInput = R"RawMarker(checkCudaError(cuModuleGetFunction(&)RawMarker"+ demangle(s) + R"RawMarker(, XCnvrtc_cuModule0, ")RawMarker"+ s +"\"));";
-                    m_interpreter.process(clingInput, &output);
+                    body[i] = ' ';
+                    break;
                 }
-                else // use function names with GPU index when multiple GPUs are used
-                {
-                    clingInput = "cuCtxSetCurrent(XCnvrtc_cuContext"+ std::to_string(i) + ");";
-                    m_interpreter.process(clingInput, &output);
-                    clingInput = R"RawMarker(checkCudaError(cuModuleGetFunction(&)RawMarker"+ demangle(s) +"_GPU"+ std::to_string(i) + R"RawMarker(, XCnvrtc_cuModule)RawMarker" + std::to_string(i)+ R"RawMarker(, ")RawMarker"+ s + "\"));";
-                    m_interpreter.process(clingInput, &output);
-                } 
-            } 
-            clingInput = "cuCtxSetCurrent(XCnvrtc_cuContext0);";
-            m_interpreter.process(clingInput, &output);
-        } 
+            }
+            body.replace(match.position(0), match.length(0), std::string(match.length(0), ' '));
+        }
+        body = std::regex_replace(body, std::regex(R"(extern\s+"C"\s+)"), "");
 
-        return SUCCESS;
-    } 
+        //dynamic shared memory of the launch
+        static const std::regex dynamicShared(R"(extern\s+__shared__\s+(?:__align__\s*\(\s*\d+\s*\)\s*)?([^;\[]*[^;\[\w])(\w+)\s*\[\s*\]\s*;)");
+        body = std::regex_replace(body, dynamicShared, "$1* $2 = static_cast<$1*>(::xcpp::cuda::emulation::dynamic_shared());");
+
+        //__shared__ variables are references to the storage of the worker running the block
+        static const std::regex staticShared(R"((?:static\s+)?__shared__\s+(?:__align__\s*\(\s*\d+\s*\)\s*)?([^;=\[]*[^;=\[\w])(\w+)\s*((?:\[[^\]]*\]\s*)*);)");
+        std::string result;
+        auto last = body.cbegin();
+        for (std::sregex_iterator i(body.begin(), body.end(), staticShared), end; i != end; ++i)
+        {
+            result.append(last, (*i)[0].first);
+            result += "auto& " + (*i)[2].str() + " = ::xcpp::cuda::emulation::shared<" + (*i)[1].str() + (*i)[3].str()
+                      + ">(" + std::to_string(emulatedSharedVariables++) + ");";
+            last = (*i)[0].second;
+        }
+        result.append(last, body.cend());
+
+        return includes + "namespace " + space + " {\n" + result + "\n}\n";
+    }
 
-    std::list<std::string> nvrtc::extractFunctionNames(const std::string& ptx)
+    CUfunction nvrtc::registerEmulatedKernel(const std::string& name, const std::string& address, bool barrier)
     {
-        std::list<std::string> listOfFunctions;
-        std::string singleFinding;
-        std::regex ptxFunctionName(R"(\/\/ .globl\s(\w*))"); // seraching for global function definition
-        auto words_begin =std::sregex_iterator(ptx.begin(),ptx.end(),ptxFunctionName);
-        auto words_end =std::sregex_iterator();
+        //the invoker unpacks the argument array of xcpp::cuda::launch for the parameter types of the kernel
+        cling::Value output;
+        std::string input = "(void*)xcpp::cuda::emulation::register_kernel(\"" + name + "\", &" + address + ", " + (barrier ? "true" : "false") + ");";
+        if(m_interpreter.process(input, &output)!=cling::Interpreter::CompilationResult::kSuccess || output.getPtr() == nullptr)
+        {
+            std::cerr << "Could not register emulated kernel: " << name << std::endl;
+            return nullptr;
+        }
+        return static_cast<CUfunction>(output.getPtr());
+    }
 
-        for(std::sregex_iterator i = words_begin; i != words_end; ++i){
-            std::smatch match = *i;
-            listOfFunctions.push_back(match[1].str());  // list all function names
+    std::vector<std::string> nvrtc::extractKernelNames(const nvrtc_build& build)
+    {
+        //names of the kernels of a build, known before the PTX exists
+        if (!build.nameExpressions.empty()) return build.nameExpressions;
+        std::vector<std::string> names;
+        for (const nvrtc_kernel_declaration& kernel : scanSource(build.code).kernels)
+        {
+            if (!kernel.isTemplate && std::find(names.begin(), names.end(), kernel.name) == names.end()) names.push_back(kernel.name);
         }
-        return listOfFunctions;
+        return names;
     }
 
     int nvrtc::printDeviceName()
     {
-        std::string clingInput;
-        cling::Value output;
+        cuda_functions& cu = nvrtc_api::instance().cuda;
         if(foundCUDADevices>1) // if more the one device was found print name of GPU and variable of device and context
         {
-            clingInput = 
-                R"RawMarker(
-                    for (int i = 0; i < XCnvrtc_CUDAdeviceCount; i++) {
-
-                        cuDeviceGet(&XCnvrtc_deviceInfo, i);
-                
-                        char XCnvrtc_gpuName[256];
-                        cuDeviceGetName(XCnvrtc_gpuName, 256, XCnvrtc_deviceInfo);
-        
-                        std::cout << "GPU: " << XCnvrtc_gpuName << " CUdevice: XCnvrtc_device"<< i << " CUcontext: XCnvrtc_cuContext"<< i <<std::endl;
-                    } 
-                )RawMarker";
-            if(m_interpreter.process(clingInput, &output)!=cling::Interpreter::CompilationResult::kSuccess)
+            for (int i = 0; i < foundCUDADevices; i++)
             {
-                return ERROR_CODE;
-            } 
-            
+                char gpuName[256];
+                if(SUCCESS!=checkCUDA(cu.cuDeviceGetName(gpuName, 256, devices[i]), "cuDeviceGetName")) return ERROR_CODE;
+                std::cout << "GPU: " << gpuName << " CUdevice: XCnvrtc_device"<< i << " CUcontext: XCnvrtc_cuContext"<< i <<std::endl;
+            }
         } 
         return SUCCESS;  
     } 
@@ -548,50 +1135,29 @@ namespace xcpp
         return "";
     } 
 
-    std::string nvrtc::readFileToString(const std::string& filePath) {
-        std::ifstream file(filePath);
-        if (!file) {
-            throw std::runtime_error("Could not open File: " + filePath);
-        }
-    
-        std::stringstream buffer;
-        buffer << file.rdbuf();  // file in stringstream
-        return buffer.str();
+    std::string nvrtc::demangle(const std::string& mangled) {
+        std::string name = nvrtc_compiler::kernelName(mangled);
+        if (name == mangled) return mangled;    //extern "C" kernels are not mangled
+        std::size_t prefix = 2 + std::to_string(name.size()).size() + name.size();   //_Z, length and name
+        return name + "__" + mangled.substr(std::min(prefix, mangled.size())); //return a short version of mangled function name
     }
 
-    std::string nvrtc::removeComments(const std::string& code){
-        //regex for single line comment
-        std::regex singleLineCommentPattern("//.*");
-        //regex for multi line comment
-        std::regex multiLineCommentPattern("/\\*[\\s\\S]*?\\*/");
-        //remove both pattern
-        std::string withoutSLComment= std::regex_replace(code,singleLineCommentPattern,"");
-        return std::regex_replace(withoutSLComment,multiLineCommentPattern,"");
-    }
-    
-    std::string nvrtc::demangle(const std::string& mangled) {
-        std::string result = mangled.substr(2); // remove _Z
-        
-        int lengthOfName=0,countNumbers =0;
-        while (true)
-        {
-            if (std::isdigit(result[0])) 
-            { 
-                countNumbers++;
-                result = result.substr(1);   //remove all numbers afer _Z
-            }
-            else break;
-        } 
-        try 
+    std::string nvrtc::variableName(const nvrtc_loaded_program& program, const std::string& function)
+    {
+        auto expression = program.expressions.find(function);
+        if (expression == program.expressions.end()) return demangle(function);
+
+        //identifier of the name expression, e.g. saxpy<float*> to saxpy_float_ptr
+        std::string name;
+        for (char c : expression->second)
         {
-            lengthOfName = std::stoi(mangled.substr(2,countNumbers));
-        } 
-        catch (const std::invalid_argument& e) {
-            std::cerr << "no number!" << std::endl;
-        } 
-        catch (const std::out_of_range& e) {
-            std::cerr << "out of range" << std::endl;
+            if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') name += c;
+            else if (c == '*') name += (name.empty() || name.back() == '_') ? "ptr" : "_ptr";
+            else if (c == '&' && name.empty()) continue;
+            else if (!name.empty() && name.back() != '_') name += '_';
         }
-        return mangled.substr(countNumbers +2 , lengthOfName) +"__"+ mangled.substr(countNumbers +2+lengthOfName); //return a short version of mangled function name
+        while (!name.empty() && name.back() == '_') name.pop_back();
+        if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) name = "kernel_" + name;
+        return name;
     }
 }
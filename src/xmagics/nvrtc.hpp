@@ -16,11 +16,25 @@
 #include "xeus-cling/xoptions.hpp"
 #include "xeus-cling/xinterpreter.hpp"
 
+#include "nvrtc_api.hpp"
+#include "nvrtc_compiler.hpp"
+#include "nvrtc_includes.hpp"
+#include "nvrtc_timings.hpp"
+#include "nvrtc_workers.hpp"
+
+#include <future>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace xcpp
 {
-    class nvrtc: public xmagic_cell
+    // The magic is owned by a shared_ptr of the magics manager, the results
+    // of -async builds are bound only while it exists.
+    class nvrtc: public xmagic_cell, public std::enable_shared_from_this<nvrtc>
     {
     public:
 
@@ -29,36 +43,76 @@ namespace xcpp
         
     private:
         void generateNVRTC(const std::string& line, const std::string& cell);
-        int loadLibrarys();
+        int loadLibrarys(const std::string includePath);
         int loadIncludes(const std::string includePath);
-        int defineCUDACheckError();
-        int declareNVRTCVar();
-        int definePTX(const std::string& code);
+        static int loadDriverHeaders(cling::Interpreter& interpreter, const std::string& includePath);
+        static int defineCUDACheckError(cling::Interpreter& interpreter);
+        static bool usesDriverAPI(const std::string& code);
         int initDevice();
         int getDeviceInfo();
         int printDeviceName();
         int getCompileOptions(const std::string& line);
         int getIncludePaths(const std::string& content);
-        int generateKernelFunction();
-        std::list<std::string> extractFunctionNames(const std::string& ptx);
-        std::string removeComments(const std::string& code);
-        std::string readFileToString(const std::string& filePath);
+        int bindKernelFunctions(const std::shared_ptr<nvrtc_loaded_program>& program, std::ostream& out);
+        int bindKernelHandle(const std::string& variable, CUfunction function);
+        int declareLaunchers(const nvrtc_loaded_program& program, std::ostream& out);
+        int checkCUDA(int result, const std::string& call);
+        static void registerKernels(const nvrtc_loaded_program& program);
+        void runBuild(nvrtc_build build);
+        void startAsyncBuild(nvrtc_build build);
+        void finishAsyncBuild(nvrtc_build& build, std::ostream& out);
+        static void reportTimings(const nvrtc_timings& timings, bool table, bool reply, std::ostream& out);
+        void reportResources(const nvrtc_loaded_program& program, bool display, std::ostream& out);
+        void reportPTXStats(const nvrtc_build& build, bool reply, std::ostream& out);
+        int analyzeCell(const std::string& line, const std::string& cell, const std::shared_ptr<nvrtc_timings>& timings);
+        std::string compileFingerprint(const nvrtc_build& build);
+        std::string getTargetArchitecture(const std::vector<std::string>& options);
+        std::vector<nvrtc_target> getTargets(const std::vector<std::string>& options);
+        std::vector<nvrtc_target> getLinkTargets(const std::vector<std::string>& options);
+        int emulateCell(const std::string& cell, nvrtc_timings& timings);
+        std::string emulatedSource(const std::string& cell, const std::string& space);
+        CUfunction registerEmulatedKernel(const std::string& name, const std::string& address, bool barrier);
+        std::vector<std::string> extractKernelNames(const nvrtc_build& build);
 
         std::string getCudaIncludePath(const std::string line);
-        std::string demangle(const std::string& mangled);
+        static std::string demangle(const std::string& mangled);
+        static std::string variableName(const nvrtc_loaded_program& program, const std::string& function);
 
         std::vector<std::string> compilerOptions;
+        std::vector<std::string> instantiations;
         std::vector<std::string> foundHeaders;
         std::vector<std::string> foundContent;
-        std::list<std::string> registeredFunctionNames;
-        std::list<std::string> listOfNames;
+        std::unordered_set<std::string> registeredFunctionNames;     //functions with a declared CUfunction variable
+        std::unordered_map<std::string, std::string> declaredLaunchers;    //launcher variable to parameter types, empty if the declaration failed
 
+        std::vector<CUdevice> devices;
+        std::vector<int> deviceArchitectures;   //compute capability as major * 10 + minor
+        std::vector<CUcontext> contexts;
+        std::unordered_map<std::string, std::weak_ptr<nvrtc_loaded_program>> loadedPrograms;    //compile fingerprint to loaded modules, for unchanged reruns
+        std::unordered_map<std::string, std::shared_ptr<nvrtc_loaded_program>> boundPrograms;   //cling variable to the program of its handle, superseded programs are unloaded
+        std::unordered_map<std::string, void*> clingVariables;  //address of the CUfunction variables in the cling session
+        nvrtc_include_resolver includeResolver;                 //header contents and include graph, validated by inode and mtime
+        std::shared_ptr<nvrtc_compiler> compiler = std::make_shared<nvrtc_compiler>();    //shared with the -async builds
+        std::shared_ptr<nvrtc_device_workers> deviceWorkers = std::make_shared<nvrtc_device_workers>();
+        std::shared_ptr<std::vector<std::future<void>>> backgroundBuilds = std::make_shared<std::vector<std::future<void>>>();   //-async builds, joined on destruction
 
         cling::Interpreter& m_interpreter;
         bool initializationDone=false;
-        int index=-1;
         int foundCUDADevices=0;
         bool printDeviceInfo=false;
+        bool useCache=true;
+        bool usePCH=true;
+        bool asyncBuild=false;
+        bool relocatableDeviceCode=false;
+        bool showTimings=false;
+        bool showReport=false;
+        bool showPTXStats=false;
+        bool compileOnly=false;     //no CUDA device, cells with -ptxstats are only compiled to PTX
+        bool emulate=false;
+        std::size_t emulatedCells=0;            //namespace of each emulated cell
+        bool emulatedBarriers=false;            //an emulated cell of the session used __syncthreads
+        std::size_t emulatedSharedVariables=0;  //ids of the __shared__ variables of emulated cells
+        std::unordered_set<std::string> emulatedIncludePaths;
 
     };
 }  
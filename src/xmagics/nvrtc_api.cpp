@@ -0,0 +1,378 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_api.hpp"
+
+#include <dlfcn.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#define ERROR_CODE -1
+#define SUCCESS 0
+
+namespace xcpp
+{
+    namespace
+    {
+        // open the first library of the list which can be found, RTLD_GLOBAL makes
+        // the symbols also visible for cling when the user calls the API in a cell
+        void* openLibrary(const std::vector<std::string>& candidates, std::string& openedPath)
+        {
+            for (const std::string& candidate : candidates)
+            {
+                if (candidate.empty()) continue;
+                void* handle = dlopen(candidate.c_str(), RTLD_NOW | RTLD_GLOBAL);
+                if (handle != nullptr)
+                {
+                    openedPath = candidate;
+                    return handle;
+                }
+            }
+            return nullptr;
+        }
+
+        template <class F>
+        bool loadSymbol(void* handle, const char* name, F& function)
+        {
+            function = reinterpret_cast<F>(dlsym(handle, name));
+            if (function == nullptr)
+            {
+                std::cerr << "Could not load symbol: " << name << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // symbols of newer library versions, the function stays nullptr if missing
+        template <class F>
+        void loadOptionalSymbol(void* handle, const char* name, F& function)
+        {
+            function = reinterpret_cast<F>(dlsym(handle, name));
+        }
+
+        // nvJitLink.h maps the API to symbols of the 12.0 ABI, e.g. __nvJitLinkCreate_12_0
+        template <class F>
+        bool loadLinkerSymbol(void* handle, const char* name, F& function)
+        {
+            function = reinterpret_cast<F>(dlsym(handle, name));
+            if (function != nullptr) return true;
+            return loadSymbol(handle, ("__" + std::string(name) + "_12_0").c_str(), function);
+        }
+
+        std::string environment(const char* name)
+        {
+            const char* value = std::getenv(name);
+            return value != nullptr ? std::string(value) : std::string();
+        }
+    }
+
+    nvrtc_api& nvrtc_api::instance()
+    {
+        static nvrtc_api api;
+        return api;
+    }
+
+    int nvrtc_api::load(const std::string& includePath)
+    {
+        if (isLoaded()) return SUCCESS;     //libraries are loaded only once per process
+        if (nvrtcHandle == nullptr && SUCCESS != loadNVRTC(includePath)) return ERROR_CODE;
+        if (SUCCESS != loadCUDA()) return ERROR_CODE;
+        return SUCCESS;
+    }
+
+    int nvrtc_api::loadCompiler(const std::string& includePath)
+    {
+        if (nvrtcHandle != nullptr) return SUCCESS;
+        return loadNVRTC(includePath);
+    }
+
+    bool nvrtc_api::isLoaded() const
+    {
+        return nvrtcHandle != nullptr && cudaHandle != nullptr;
+    }
+
+    bool nvrtc_api::hasDevice()
+    {
+        std::lock_guard<std::mutex> lock(probeMutex);
+        if (probedDevice >= 0) return probedDevice == 1;    //the driver is probed once per process
+        int count = 0;
+        if (cudaHandle != nullptr)
+        {
+            probedDevice = cuda.cuDeviceGetCount(&count) == CUDA_API_SUCCESS && count > 0 ? 1 : 0;
+            return probedDevice == 1;
+        }
+
+        //no error output, a missing driver is expected on build machines
+        std::string path;
+        void* handle = openLibrary({environment("XEUS_CLING_CUDA_LIBRARY"), "libcuda.so.1", "libcuda.so"}, path);
+        if (handle == nullptr)
+        {
+            probedDevice = 0;
+            return false;
+        }
+        auto init = reinterpret_cast<int (*)(unsigned int)>(dlsym(handle, "cuInit"));
+        auto deviceCount = reinterpret_cast<int (*)(int*)>(dlsym(handle, "cuDeviceGetCount"));
+        if (init == nullptr || deviceCount == nullptr)
+        {
+            dlclose(handle);
+            probedDevice = 0;
+            return false;
+        }
+        //the driver is not unloaded after cuInit, loadCUDA gets the same library again
+        probeHandle = handle;
+        bool found = init(0) == CUDA_API_SUCCESS && deviceCount(&count) == CUDA_API_SUCCESS && count > 0;
+        probedDevice = found ? 1 : 0;
+        return found;
+    }
+
+    int nvrtc_api::loadNVRTC(const std::string& includePath)
+    {
+        std::vector<std::string> candidates = {environment("XEUS_CLING_NVRTC_LIBRARY"), "libnvrtc.so", "libnvrtc.so.12", "libnvrtc.so.11.2"};
+        if (!includePath.empty()) candidates.push_back(includePath + "../lib64/libnvrtc.so");   //-cudaPath points to the include directory of the toolkit
+
+        nvrtcHandle = openLibrary(candidates, nvrtcLibrary);
+        if (nvrtcHandle == nullptr)
+        {
+            std::cerr << "Could not load library: libnvrtc.so" << std::endl;
+            return ERROR_CODE;
+        }
+        bool loaded = loadSymbol(nvrtcHandle, "nvrtcVersion", nvrtc.nvrtcVersion)
+            && loadSymbol(nvrtcHandle, "nvrtcGetErrorString", nvrtc.nvrtcGetErrorString)
+            && loadSymbol(nvrtcHandle, "nvrtcCreateProgram", nvrtc.nvrtcCreateProgram)
+            && loadSymbol(nvrtcHandle, "nvrtcDestroyProgram", nvrtc.nvrtcDestroyProgram)
+            && loadSymbol(nvrtcHandle, "nvrtcCompileProgram", nvrtc.nvrtcCompileProgram)
+            && loadSymbol(nvrtcHandle, "nvrtcGetPTXSize", nvrtc.nvrtcGetPTXSize)
+            && loadSymbol(nvrtcHandle, "nvrtcGetPTX", nvrtc.nvrtcGetPTX)
+            && loadSymbol(nvrtcHandle, "nvrtcGetProgramLogSize", nvrtc.nvrtcGetProgramLogSize)
+            && loadSymbol(nvrtcHandle, "nvrtcGetProgramLog", nvrtc.nvrtcGetProgramLog)
+            && loadSymbol(nvrtcHandle, "nvrtcAddNameExpression", nvrtc.nvrtcAddNameExpression)
+            && loadSymbol(nvrtcHandle, "nvrtcGetLoweredName", nvrtc.nvrtcGetLoweredName);
+        if (!loaded)
+        {
+            dlclose(nvrtcHandle);
+            nvrtcHandle = nullptr;
+            return ERROR_CODE;
+        }
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetCUBINSize", nvrtc.nvrtcGetCUBINSize);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetCUBIN", nvrtc.nvrtcGetCUBIN);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetNumSupportedArchs", nvrtc.nvrtcGetNumSupportedArchs);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetSupportedArchs", nvrtc.nvrtcGetSupportedArchs);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetPCHCreateStatus", nvrtc.nvrtcGetPCHCreateStatus);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetPCHHeapSizeRequired", nvrtc.nvrtcGetPCHHeapSizeRequired);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetPCHHeapSize", nvrtc.nvrtcGetPCHHeapSize);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcSetPCHHeapSize", nvrtc.nvrtcSetPCHHeapSize);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetLTOIRSize", nvrtc.nvrtcGetLTOIRSize);
+        loadOptionalSymbol(nvrtcHandle, "nvrtcGetLTOIR", nvrtc.nvrtcGetLTOIR);
+        return SUCCESS;
+    }
+
+    int nvrtc_api::loadCUDA()
+    {
+        std::vector<std::string> candidates = {environment("XEUS_CLING_CUDA_LIBRARY"), "libcuda.so.1", "libcuda.so"};
+
+        cudaHandle = openLibrary(candidates, cudaLibrary);
+        if (cudaHandle == nullptr)
+        {
+            std::cerr << "Could not load library: libcuda.so" << std::endl;
+            return ERROR_CODE;
+        }
+        // versioned symbol names are the ones the macros in cuda.h resolve to
+        bool loaded = loadSymbol(cudaHandle, "cuInit", cuda.cuInit)
+            && loadSymbol(cudaHandle, "cuGetErrorString", cuda.cuGetErrorString)
+            && loadSymbol(cudaHandle, "cuDeviceGetCount", cuda.cuDeviceGetCount)
+            && loadSymbol(cudaHandle, "cuDeviceGet", cuda.cuDeviceGet)
+            && loadSymbol(cudaHandle, "cuDeviceGetName", cuda.cuDeviceGetName)
+            && loadSymbol(cudaHandle, "cuDeviceGetAttribute", cuda.cuDeviceGetAttribute)
+            && loadSymbol(cudaHandle, "cuCtxCreate_v2", cuda.cuCtxCreate)
+            && loadSymbol(cudaHandle, "cuCtxSetCurrent", cuda.cuCtxSetCurrent)
+            && loadSymbol(cudaHandle, "cuCtxPushCurrent_v2", cuda.cuCtxPushCurrent)
+            && loadSymbol(cudaHandle, "cuCtxPopCurrent_v2", cuda.cuCtxPopCurrent)
+            && loadSymbol(cudaHandle, "cuModuleLoadData", cuda.cuModuleLoadData)
+            && loadSymbol(cudaHandle, "cuModuleUnload", cuda.cuModuleUnload)
+            && loadSymbol(cudaHandle, "cuModuleGetFunction", cuda.cuModuleGetFunction)
+            && loadSymbol(cudaHandle, "cuLaunchKernel", cuda.cuLaunchKernel)
+            && loadSymbol(cudaHandle, "cuCtxSynchronize", cuda.cuCtxSynchronize)
+            && loadSymbol(cudaHandle, "cuStreamCreate", cuda.cuStreamCreate)
+            && loadSymbol(cudaHandle, "cuStreamDestroy_v2", cuda.cuStreamDestroy)
+            && loadSymbol(cudaHandle, "cuStreamSynchronize", cuda.cuStreamSynchronize)
+            && loadSymbol(cudaHandle, "cuStreamWaitEvent", cuda.cuStreamWaitEvent)
+            && loadSymbol(cudaHandle, "cuEventCreate", cuda.cuEventCreate)
+            && loadSymbol(cudaHandle, "cuEventDestroy_v2", cuda.cuEventDestroy)
+            && loadSymbol(cudaHandle, "cuEventRecord", cuda.cuEventRecord)
+            && loadSymbol(cudaHandle, "cuEventSynchronize", cuda.cuEventSynchronize)
+            && loadSymbol(cudaHandle, "cuEventElapsedTime", cuda.cuEventElapsedTime)
+            && loadSymbol(cudaHandle, "cuMemAlloc_v2", cuda.cuMemAlloc)
+            && loadSymbol(cudaHandle, "cuMemFree_v2", cuda.cuMemFree)
+            && loadSymbol(cudaHandle, "cuMemHostAlloc", cuda.cuMemHostAlloc)
+            && loadSymbol(cudaHandle, "cuMemFreeHost", cuda.cuMemFreeHost)
+            && loadSymbol(cudaHandle, "cuMemcpyHtoD_v2", cuda.cuMemcpyHtoD)
+            && loadSymbol(cudaHandle, "cuMemcpyDtoH_v2", cuda.cuMemcpyDtoH)
+            && loadSymbol(cudaHandle, "cuMemcpyHtoDAsync_v2", cuda.cuMemcpyHtoDAsync)
+            && loadSymbol(cudaHandle, "cuMemcpyDtoHAsync_v2", cuda.cuMemcpyDtoHAsync);
+        if (!loaded)
+        {
+            dlclose(cudaHandle);
+            cudaHandle = nullptr;
+            return ERROR_CODE;
+        }
+        loadOptionalSymbol(cudaHandle, "cuCtxGetDevice", cuda.cuCtxGetDevice);
+        loadOptionalSymbol(cudaHandle, "cuFuncGetAttribute", cuda.cuFuncGetAttribute);
+        loadOptionalSymbol(cudaHandle, "cuOccupancyMaxPotentialBlockSize", cuda.cuOccupancyMaxPotentialBlockSize);
+        loadOptionalSymbol(cudaHandle, "cuOccupancyMaxActiveBlocksPerMultiprocessor", cuda.cuOccupancyMaxActiveBlocksPerMultiprocessor);
+        loadOptionalSymbol(cudaHandle, "cuStreamBeginCapture_v2", cuda.cuStreamBeginCapture);
+        loadOptionalSymbol(cudaHandle, "cuStreamEndCapture", cuda.cuStreamEndCapture);
+        loadOptionalSymbol(cudaHandle, "cuGraphInstantiateWithFlags", cuda.cuGraphInstantiateWithFlags);
+        loadOptionalSymbol(cudaHandle, "cuGraphLaunch", cuda.cuGraphLaunch);
+        loadOptionalSymbol(cudaHandle, "cuGraphGetNodes", cuda.cuGraphGetNodes);
+        loadOptionalSymbol(cudaHandle, "cuGraphExecDestroy", cuda.cuGraphExecDestroy);
+        loadOptionalSymbol(cudaHandle, "cuGraphDestroy", cuda.cuGraphDestroy);
+        loadOptionalSymbol(cudaHandle, "cuGraphExecUpdate_v2", cuda.cuGraphExecUpdate_v2);
+        loadOptionalSymbol(cudaHandle, "cuGraphExecUpdate", cuda.cuGraphExecUpdate);
+        return SUCCESS;
+    }
+
+    int nvrtc_api::loadNVJitLink()
+    {
+        std::lock_guard<std::mutex> lock(nvjitlinkMutex);
+        if (nvjitlinkHandle != nullptr) return SUCCESS;
+        std::vector<std::string> candidates = {environment("XEUS_CLING_NVJITLINK_LIBRARY"), "libnvJitLink.so", "libnvJitLink.so.12"};
+        if (!nvrtcLibrary.empty() && nvrtcLibrary.find('/') != std::string::npos)
+        {
+            candidates.push_back(nvrtcLibrary.substr(0, nvrtcLibrary.rfind('/') + 1) + "libnvJitLink.so");  //next to libnvrtc
+        }
+
+        void* handle = openLibrary(candidates, nvjitlinkLibrary);
+        if (handle == nullptr)
+        {
+            std::cerr << "Could not load library: libnvJitLink.so" << std::endl;
+            return ERROR_CODE;
+        }
+        bool loaded = loadLinkerSymbol(handle, "nvJitLinkCreate", nvjitlink.nvJitLinkCreate)
+            && loadLinkerSymbol(handle, "nvJitLinkDestroy", nvjitlink.nvJitLinkDestroy)
+            && loadLinkerSymbol(handle, "nvJitLinkAddData", nvjitlink.nvJitLinkAddData)
+            && loadLinkerSymbol(handle, "nvJitLinkComplete", nvjitlink.nvJitLinkComplete)
+            && loadLinkerSymbol(handle, "nvJitLinkGetLinkedCubinSize", nvjitlink.nvJitLinkGetLinkedCubinSize)
+            && loadLinkerSymbol(handle, "nvJitLinkGetLinkedCubin", nvjitlink.nvJitLinkGetLinkedCubin)
+            && loadLinkerSymbol(handle, "nvJitLinkGetErrorLogSize", nvjitlink.nvJitLinkGetErrorLogSize)
+            && loadLinkerSymbol(handle, "nvJitLinkGetErrorLog", nvjitlink.nvJitLinkGetErrorLog);
+        if (!loaded)
+        {
+            dlclose(handle);
+            nvjitlink = {};
+            return ERROR_CODE;
+        }
+        nvjitlinkHandle = handle;
+        return SUCCESS;
+    }
+
+    std::string nvrtc_api::nvrtcError(int result) const
+    {
+        if (nvrtc.nvrtcGetErrorString == nullptr) return "NVRTC error " + std::to_string(result);
+        return nvrtc.nvrtcGetErrorString(result);
+    }
+
+    std::string nvrtc_api::cudaError(int result) const
+    {
+        const char* errorStr = nullptr;
+        if (cuda.cuGetErrorString == nullptr || cuda.cuGetErrorString(result, &errorStr) != CUDA_API_SUCCESS || errorStr == nullptr)
+        {
+            return "CUDA error " + std::to_string(result);
+        }
+        return errorStr;
+    }
+
+    bool nvrtc_api::hasGraphs() const
+    {
+        return cuda.cuStreamBeginCapture != nullptr && cuda.cuStreamEndCapture != nullptr && cuda.cuGraphInstantiateWithFlags != nullptr
+            && cuda.cuGraphLaunch != nullptr && cuda.cuGraphExecDestroy != nullptr && cuda.cuGraphDestroy != nullptr;
+    }
+
+    int nvrtc_api::updateGraph(CUgraphExec exec, CUgraph graph) const
+    {
+        //layout of CUgraphExecUpdateResultInfo
+        struct update_result_info
+        {
+            int result;
+            void* errorNode;
+            void* errorFromNode;
+        };
+        if (cuda.cuGraphExecUpdate_v2 != nullptr)
+        {
+            update_result_info info = {};
+            return cuda.cuGraphExecUpdate_v2(exec, graph, &info);
+        }
+        if (cuda.cuGraphExecUpdate != nullptr)
+        {
+            void* errorNode = nullptr;
+            int result = 0;
+            return cuda.cuGraphExecUpdate(exec, graph, &errorNode, &result);
+        }
+        return CUDA_API_ERROR_NOT_SUPPORTED;
+    }
+
+    const std::string& nvrtc_api::nvrtcLibraryPath() const
+    {
+        return nvrtcLibrary;
+    }
+
+    const std::string& nvrtc_api::cudaLibraryPath() const
+    {
+        return cudaLibrary;
+    }
+
+    void nvrtc_program_deleter::operator()(nvrtcProgram program) const
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+        api.nvrtc.nvrtcDestroyProgram(&program);
+        api.resources.nvrtcPrograms--;
+    }
+
+    int createProgram(nvrtc_program_ptr& program, const char* src, const char* name, int numHeaders,
+                      const char* const* headers, const char* const* includeNames)
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+        nvrtcProgram created = nullptr;
+        int result = api.nvrtc.nvrtcCreateProgram(&created, src, name, numHeaders, headers, includeNames);
+        if (result == NVRTC_API_SUCCESS)
+        {
+            api.resources.nvrtcPrograms++;
+            program.reset(created);
+        }
+        return result;
+    }
+
+    nvrtc_module::nvrtc_module(CUmodule module, CUcontext context, std::size_t imageSize)
+        : m_module(module), m_context(context), m_imageSize(imageSize)
+    {
+        nvrtc_resources& resources = nvrtc_api::instance().resources;
+        resources.modules++;
+        resources.imageBytes += static_cast<long long>(m_imageSize);
+    }
+
+    nvrtc_module::~nvrtc_module()
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+        CUcontext previous = nullptr;
+        if (api.cuda.cuCtxPushCurrent(m_context) == CUDA_API_SUCCESS)
+        {
+            api.cuda.cuModuleUnload(m_module);
+            api.cuda.cuCtxPopCurrent(&previous);
+        }
+        api.resources.modules--;
+        api.resources.imageBytes -= static_cast<long long>(m_imageSize);
+        api.resources.unloadedModules++;
+    }
+
+    CUmodule nvrtc_module::get() const
+    {
+        return m_module;
+    }
+}
@@ -0,0 +1,240 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_API_HPP
+#define XMAGICS_NVRTC_API_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "xcpp/xcuda.hpp"
+
+// Opaque NVRTC and nvJitLink types, identical to the declarations in nvrtc.h
+// and nvJitLink.h. The CUDA driver types are declared in xcpp/xcuda.hpp.
+typedef struct _nvrtcProgram* nvrtcProgram;
+typedef struct nvJitLink* nvJitLinkHandle;
+
+namespace xcpp
+{
+    // result codes and enum values used from cuda.h and nvrtc.h
+    constexpr int CUDA_API_SUCCESS = 0;
+    constexpr int NVRTC_API_SUCCESS = 0;
+    constexpr int NVRTC_API_ERROR_NO_PCH_CREATE_ATTEMPTED = 13;
+    constexpr int NVRTC_API_ERROR_PCH_CREATE_HEAP_EXHAUSTED = 14;
+    constexpr int NVJITLINK_API_SUCCESS = 0;
+    constexpr int NVJITLINK_API_INPUT_LTOIR = 3;
+    constexpr unsigned int CU_STREAM_API_NON_BLOCKING = 1;
+    constexpr unsigned int CU_EVENT_API_DISABLE_TIMING = 2;
+    constexpr unsigned int CU_MEMHOSTALLOC_API_PORTABLE = 1;
+    constexpr int CUDA_API_ERROR_OUT_OF_MEMORY = 2;
+    constexpr int CUDA_API_ERROR_NOT_SUPPORTED = 801;
+    constexpr int CU_STREAM_API_CAPTURE_MODE_THREAD_LOCAL = 1;
+    constexpr int CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK = 0;
+    constexpr int CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES = 1;
+    constexpr int CU_FUNC_ATTRIBUTE_CONST_SIZE_BYTES = 2;
+    constexpr int CU_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES = 3;
+    constexpr int CU_FUNC_ATTRIBUTE_NUM_REGS = 4;
+    constexpr int CU_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR = 39;
+    constexpr int CU_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR = 75;
+    constexpr int CU_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR = 76;
+
+    // function table of libnvrtc, enum results are passed as int
+    struct nvrtc_functions
+    {
+        int (*nvrtcVersion)(int* major, int* minor);
+        const char* (*nvrtcGetErrorString)(int result);
+        int (*nvrtcCreateProgram)(nvrtcProgram* prog, const char* src, const char* name, int numHeaders, const char* const* headers, const char* const* includeNames);
+        int (*nvrtcDestroyProgram)(nvrtcProgram* prog);
+        int (*nvrtcCompileProgram)(nvrtcProgram prog, int numOptions, const char* const* options);
+        int (*nvrtcGetPTXSize)(nvrtcProgram prog, std::size_t* ptxSize);
+        int (*nvrtcGetPTX)(nvrtcProgram prog, char* ptx);
+        int (*nvrtcGetProgramLogSize)(nvrtcProgram prog, std::size_t* logSize);
+        int (*nvrtcGetProgramLog)(nvrtcProgram prog, char* log);
+        int (*nvrtcAddNameExpression)(nvrtcProgram prog, const char* nameExpression);
+        int (*nvrtcGetLoweredName)(nvrtcProgram prog, const char* nameExpression, const char** loweredName);
+        // optional, nullptr for NVRTC versions without direct CUBIN output
+        int (*nvrtcGetCUBINSize)(nvrtcProgram prog, std::size_t* cubinSize);
+        int (*nvrtcGetCUBIN)(nvrtcProgram prog, char* cubin);
+        int (*nvrtcGetNumSupportedArchs)(int* numArchs);
+        int (*nvrtcGetSupportedArchs)(int* supportedArchs);
+        // optional, automatic precompiled headers (NVRTC 12.4)
+        int (*nvrtcGetPCHCreateStatus)(nvrtcProgram prog);
+        int (*nvrtcGetPCHHeapSizeRequired)(nvrtcProgram prog, std::size_t* size);
+        int (*nvrtcGetPCHHeapSize)(std::size_t* size);
+        int (*nvrtcSetPCHHeapSize)(std::size_t size);
+        // optional, LTO-IR output of -dlto (NVRTC 12.0)
+        int (*nvrtcGetLTOIRSize)(nvrtcProgram prog, std::size_t* size);
+        int (*nvrtcGetLTOIR)(nvrtcProgram prog, char* ltoir);
+    };
+
+    // function table of libnvJitLink, only loaded for -rdc
+    struct nvjitlink_functions
+    {
+        int (*nvJitLinkCreate)(nvJitLinkHandle* handle, std::uint32_t numOptions, const char** options);
+        int (*nvJitLinkDestroy)(nvJitLinkHandle* handle);
+        int (*nvJitLinkAddData)(nvJitLinkHandle handle, int inputType, const void* data, std::size_t size, const char* name);
+        int (*nvJitLinkComplete)(nvJitLinkHandle handle);
+        int (*nvJitLinkGetLinkedCubinSize)(nvJitLinkHandle handle, std::size_t* size);
+        int (*nvJitLinkGetLinkedCubin)(nvJitLinkHandle handle, void* cubin);
+        int (*nvJitLinkGetErrorLogSize)(nvJitLinkHandle handle, std::size_t* size);
+        int (*nvJitLinkGetErrorLog)(nvJitLinkHandle handle, char* log);
+    };
+
+    // function table of libcuda (driver API)
+    struct cuda_functions
+    {
+        int (*cuInit)(unsigned int flags);
+        int (*cuGetErrorString)(int result, const char** str);
+        int (*cuDeviceGetCount)(int* count);
+        int (*cuDeviceGet)(CUdevice* device, int ordinal);
+        int (*cuDeviceGetName)(char* name, int len, CUdevice device);
+        int (*cuDeviceGetAttribute)(int* value, int attribute, CUdevice device);
+        int (*cuCtxCreate)(CUcontext* context, unsigned int flags, CUdevice device);
+        int (*cuCtxSetCurrent)(CUcontext context);
+        int (*cuCtxPushCurrent)(CUcontext context);
+        int (*cuCtxPopCurrent)(CUcontext* context);
+        int (*cuModuleLoadData)(CUmodule* module, const void* image);
+        int (*cuModuleUnload)(CUmodule module);
+        int (*cuModuleGetFunction)(CUfunction* function, CUmodule module, const char* name);
+        int (*cuLaunchKernel)(CUfunction function, unsigned int gridDimX, unsigned int gridDimY, unsigned int gridDimZ,
+                              unsigned int blockDimX, unsigned int blockDimY, unsigned int blockDimZ,
+                              unsigned int sharedMemBytes, CUstream stream, void** kernelParams, void** extra);
+        int (*cuCtxSynchronize)();
+        int (*cuStreamCreate)(CUstream* stream, unsigned int flags);
+        int (*cuStreamDestroy)(CUstream stream);
+        int (*cuStreamSynchronize)(CUstream stream);
+        int (*cuStreamWaitEvent)(CUstream stream, CUevent event, unsigned int flags);
+        int (*cuEventCreate)(CUevent* event, unsigned int flags);
+        int (*cuEventDestroy)(CUevent event);
+        int (*cuEventRecord)(CUevent event, CUstream stream);
+        int (*cuEventSynchronize)(CUevent event);
+        int (*cuEventElapsedTime)(float* milliseconds, CUevent start, CUevent end);
+        int (*cuMemAlloc)(CUdeviceptr* pointer, std::size_t bytes);
+        int (*cuMemFree)(CUdeviceptr pointer);
+        int (*cuMemHostAlloc)(void** pointer, std::size_t bytes, unsigned int flags);
+        int (*cuMemFreeHost)(void* pointer);
+        int (*cuMemcpyHtoD)(CUdeviceptr destination, const void* source, std::size_t bytes);
+        int (*cuMemcpyDtoH)(void* destination, CUdeviceptr source, std::size_t bytes);
+        int (*cuMemcpyHtoDAsync)(CUdeviceptr destination, const void* source, std::size_t bytes, CUstream stream);
+        int (*cuMemcpyDtoHAsync)(void* destination, CUdeviceptr source, std::size_t bytes, CUstream stream);
+        // optional, occupancy and function attributes, nullptr for stub libraries without them
+        int (*cuCtxGetDevice)(CUdevice* device);
+        int (*cuFuncGetAttribute)(int* value, int attribute, CUfunction function);
+        int (*cuOccupancyMaxPotentialBlockSize)(int* minGridSize, int* blockSize, CUfunction function, void* blockSizeToSharedMemory, std::size_t sharedMemory, int blockSizeLimit);
+        int (*cuOccupancyMaxActiveBlocksPerMultiprocessor)(int* blocks, CUfunction function, int blockSize, std::size_t sharedMemory);
+        // optional, CUDA graphs (CUDA 11.4), nullptr if the driver is older
+        int (*cuStreamBeginCapture)(CUstream stream, int mode);
+        int (*cuStreamEndCapture)(CUstream stream, CUgraph* graph);
+        int (*cuGraphInstantiateWithFlags)(CUgraphExec* exec, CUgraph graph, unsigned long long flags);
+        int (*cuGraphLaunch)(CUgraphExec exec, CUstream stream);
+        int (*cuGraphGetNodes)(CUgraph graph, void** nodes, std::size_t* count);
+        int (*cuGraphExecDestroy)(CUgraphExec exec);
+        int (*cuGraphDestroy)(CUgraph graph);
+        // cuGraphExecUpdate of CUDA 12 writes the CUgraphExecUpdateResultInfo, the one of CUDA 11 the error node and result
+        int (*cuGraphExecUpdate_v2)(CUgraphExec exec, CUgraph graph, void* resultInfo);
+        int (*cuGraphExecUpdate)(CUgraphExec exec, CUgraph graph, void** errorNode, int* result);
+    };
+
+    // live resources of the magic, reported by %nvrtc_stats
+    struct nvrtc_resources
+    {
+        std::atomic<long long> nvrtcPrograms{0};
+        std::atomic<long long> modules{0};
+        std::atomic<long long> imageBytes{0};       //size of the PTX/CUBIN images of the loaded modules
+        std::atomic<long long> unloadedModules{0};
+    };
+
+    // Loads libnvrtc and libcuda with dlopen and resolves the function tables.
+    // The library names can be overwritten with XEUS_CLING_NVRTC_LIBRARY,
+    // XEUS_CLING_CUDA_LIBRARY and XEUS_CLING_NVJITLINK_LIBRARY, e.g. to run the
+    // magic against stub libraries.
+    class nvrtc_api
+    {
+    public:
+
+        static nvrtc_api& instance();
+
+        int load(const std::string& includePath);
+        int loadCompiler(const std::string& includePath);   //only libnvrtc, for -ptxstats without a GPU
+        bool isLoaded() const;
+        bool hasDevice();           //libcuda can be loaded and reports a device, probed once without error output
+        int loadNVJitLink();    //on first use, not needed without -rdc
+
+        std::string nvrtcError(int result) const;
+        std::string cudaError(int result) const;
+        bool hasGraphs() const;
+        int updateGraph(CUgraphExec exec, CUgraph graph) const;  //parameters of a graph with the same topology, returns the CUresult
+
+        const std::string& nvrtcLibraryPath() const;
+        const std::string& cudaLibraryPath() const;
+
+        nvrtc_functions nvrtc = {};
+        cuda_functions cuda = {};
+        nvjitlink_functions nvjitlink = {};
+        nvrtc_resources resources;
+
+    private:
+
+        nvrtc_api() = default;
+        nvrtc_api(const nvrtc_api&) = delete;
+        nvrtc_api& operator=(const nvrtc_api&) = delete;
+
+        int loadNVRTC(const std::string& includePath);
+        int loadCUDA();
+
+        void* nvrtcHandle = nullptr;
+        void* cudaHandle = nullptr;
+        void* nvjitlinkHandle = nullptr;
+        std::string nvrtcLibrary;
+        std::string cudaLibrary;
+        std::string nvjitlinkLibrary;
+        std::mutex nvjitlinkMutex;
+        std::mutex probeMutex;
+        int probedDevice = -1;      //result of hasDevice, -1 before the probe
+        void* probeHandle = nullptr;    //libcuda opened by hasDevice
+    };
+
+    // owns an nvrtcProgram, destroyed with nvrtcDestroyProgram
+    struct nvrtc_program_deleter
+    {
+        void operator()(nvrtcProgram program) const;
+    };
+    using nvrtc_program_ptr = std::unique_ptr<struct _nvrtcProgram, nvrtc_program_deleter>;
+
+    // Creates an nvrtcProgram, the result is the nvrtcResult of nvrtcCreateProgram.
+    int createProgram(nvrtc_program_ptr& program, const char* src, const char* name, int numHeaders,
+                      const char* const* headers, const char* const* includeNames);
+
+    // A module loaded in a context. The module is unloaded with the last reference,
+    // the context is pushed for the unload, so any thread can release it.
+    class nvrtc_module
+    {
+    public:
+
+        nvrtc_module(CUmodule module, CUcontext context, std::size_t imageSize);
+        ~nvrtc_module();
+
+        nvrtc_module(const nvrtc_module&) = delete;
+        nvrtc_module& operator=(const nvrtc_module&) = delete;
+
+        CUmodule get() const;
+
+    private:
+
+        CUmodule m_module;
+        CUcontext m_context;
+        std::size_t m_imageSize;
+    };
+}
+
+#endif
@@ -0,0 +1,156 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_autotune.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+#include "cling/Interpreter/Value.h"
+#include "xeus/xinterpreter.hpp"
+
+#include "nvrtc_emulator.hpp"
+#include "nvrtc_session.hpp"
+#include "nvrtc_streams.hpp"
+#include "nvrtc_tuner.hpp"
+
+namespace nl = nlohmann;
+
+#define ERROR_CODE -1
+#define SUCCESS 0
+
+namespace xcpp
+{
+    void nvrtc_autotune::operator()(const std::string& line)
+    {
+        if(SUCCESS!=getOptions(line)) return;
+        if(nvrtc_stream_pool::instance().deviceCount()==0 && !nvrtc_emulator::instance().isActive())
+        {
+            std::cerr << "Run a %%nvrtc cell before %nvrtc_autotune" << std::endl;
+            return;
+        }
+
+        std::ostringstream variantList;
+        for (std::size_t i = 0; i < variants.size(); i++) variantList << (i == 0 ? "" : ", ") << "\"" << variants[i] << "\"";
+        std::ostringstream blockList;
+        for (std::size_t i = 0; i < blocks.size(); i++) blockList << (i == 0 ? "" : ", ") << blocks[i];
+
+        //the arguments are evaluated once in the session, the lambda launches every candidate with them
+        std::string input = "(long long)xcpp::cuda::autotune(" + launcher + ".function(), {" + variantList.str() + "}, (std::size_t)(" + problemSize + "), {"
+                          + blockList.str() + "}, " + std::to_string(repeat) + ", " + launcher + ".shared_memory(), "
+                          + "[&](CUfunction xcpp_function, xcpp::cuda::dim3 xcpp_grid, xcpp::cuda::dim3 xcpp_block, CUstream xcpp_stream) { return "
+                          + launcher + ".launch_function(xcpp_function, xcpp_grid, xcpp_block, xcpp_stream" + (arguments.empty() ? "" : ", " + arguments) + "); }).size();";
+        cling::Value output;
+        if(m_interpreter.process(input, &output)!=cling::Interpreter::CompilationResult::kSuccess || !output.hasValue())
+        {
+            std::cerr << "Could not autotune: " << launcher << std::endl;
+            return;
+        }
+        if(output.getLL()==0)
+        {
+            std::cerr << "No configuration of " << launcher << " could be launched" << std::endl;
+            return;
+        }
+        publish(nvrtc_tuner::instance().lastCandidates());
+    }
+
+    int nvrtc_autotune::getOptions(const std::string& line)
+    {
+        std::smatch match;
+        std::string rest = line;
+        //block sizes of the sweep instead of the powers of two
+        blocks.clear();
+        std::regex blocksOption(R"(-blocks\s+([\d,]+))");
+        if(std::regex_search(rest, match, blocksOption))
+        {
+            std::istringstream list(match[1].str());
+            std::string block;
+            while (std::getline(list, block, ',')) if (!block.empty()) blocks.push_back(static_cast<unsigned int>(std::stoul(block)));
+        }
+        rest = std::regex_replace(rest, blocksOption, " ");
+        //kernels with the same parameters, e.g. other -instantiate expressions of a template
+        variants.clear();
+        std::regex variantsOption(R"(-variants\s+(?:\"([^\"]*)\"|(\S+)))");
+        if(std::regex_search(rest, match, variantsOption))
+        {
+            std::istringstream list(match[1].matched ? match[1].str() : match[2].str());
+            std::string variant;
+            while (std::getline(list, variant, ','))
+            {
+                variant = std::regex_replace(variant, std::regex(R"(^\s+|\s+$)"), "");
+                if (!variant.empty()) variants.push_back(variant);
+            }
+        }
+        rest = std::regex_replace(rest, variantsOption, " ");
+        //timed launches per candidate
+        std::regex repeatOption(R"(-repeat\s+(\d+))");
+        repeat = std::regex_search(rest, match, repeatOption) ? std::max(1, std::stoi(match[1].str())) : 10;
+        rest = std::regex_replace(rest, repeatOption, " ");
+
+        //launcher, problem size and the kernel arguments as written in C++
+        std::istringstream words(rest);
+        launcher.clear();
+        problemSize.clear();
+        words >> launcher >> problemSize;
+        std::getline(words, arguments);
+        arguments = std::regex_replace(arguments, std::regex(R"(^\s+|\s+$)"), "");
+        if(!std::regex_match(launcher, std::regex(R"([A-Za-z_]\w*)")) || problemSize.empty())
+        {
+            std::cerr << "Usage: %nvrtc_autotune launcher size arg1, arg2, ... [-blocks 64,128,...] [-variants \"kernel<1>,kernel<2>\"] [-repeat N]" << std::endl;
+            return ERROR_CODE;
+        }
+        return SUCCESS;
+    }
+
+    void nvrtc_autotune::publish(const std::vector<cuda::tuning_candidate>& candidates)
+    {
+        std::string kernel = nvrtc_tuner::instance().lastKernel();
+        std::ostringstream text;
+        std::ostringstream html;
+        text << std::fixed << std::setprecision(4);
+        html << std::fixed << std::setprecision(4);
+        text << "Autotune " << kernel << " (" << repeat << (repeat == 1 ? " launch" : " launches") << " per candidate)" << std::endl;
+        text << std::left << std::setw(32) << "kernel" << std::right << std::setw(8) << "block" << std::setw(12) << "ms" << std::setw(12) << "occupancy" << std::endl;
+        html << "<table><thead><tr><th>kernel</th><th>block</th><th>ms</th><th>occupancy</th></tr></thead><tbody>";
+        nl::json rows = nl::json::array();
+        for (const cuda::tuning_candidate& candidate : candidates)
+        {
+            std::string name = candidate.kernel + (candidate.suggested ? " *" : "");
+            std::ostringstream time;
+            std::ostringstream occupancy;
+            time << std::fixed << std::setprecision(4) << candidate.milliseconds;
+            occupancy << std::fixed << std::setprecision(2) << candidate.occupancy;
+            std::string timeText = candidate.milliseconds < 0 ? "failed" : time.str();
+            std::string occupancyText = candidate.occupancy > 0 ? occupancy.str() : "-";
+            text << std::left << std::setw(32) << name << std::right << std::setw(8) << candidate.block << std::setw(12) << timeText
+                 << std::setw(12) << occupancyText << std::endl;
+
+            //template arguments of variants are escaped for the html table
+            std::string escaped = std::regex_replace(std::regex_replace(std::regex_replace(name, std::regex("&"), "&amp;"), std::regex("<"), "&lt;"), std::regex(">"), "&gt;");
+            html << "<tr><td>" << escaped << "</td><td>" << candidate.block << "</td><td>" << timeText << "</td><td>" << occupancyText << "</td></tr>";
+            rows.push_back({{"kernel", candidate.kernel}, {"block", candidate.block}, {"ms", candidate.milliseconds},
+                            {"occupancy", candidate.occupancy}, {"suggested", candidate.suggested}});
+        }
+        html << "</tbody></table>";
+        text << "* block size of the occupancy calculator, the first row is used by " << launcher << ".launch_n" << std::endl;
+        html << "<p>* block size of the occupancy calculator, the first row is used by <code>" << launcher << ".launch_n</code></p>";
+
+        xeus::get_interpreter().display_data(nl::json::object({{"text/plain", text.str()}, {"text/html", html.str()}}), nl::json::object(), nl::json::object());
+        nl::json autotune = {
+            {"kernel", kernel},
+            {"launcher", launcher},
+            {"repeat", repeat},
+            {"candidates", rows}
+        };
+        nvrtc_session::instance().setReplyMetadata(nl::json::object({{"nvrtc", {{"autotune", autotune}}}}));
+    }
+}
@@ -0,0 +1,48 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_AUTOTUNE_HPP
+#define XMAGICS_NVRTC_AUTOTUNE_HPP
+
+#include <string>
+#include <vector>
+
+#include "cling/Interpreter/Interpreter.h"
+#include "xeus-cling/xmagics.hpp"
+
+#include "xcpp/xcuda.hpp"
+
+namespace xcpp
+{
+    // %nvrtc_autotune launcher size args... times the block sizes and variants
+    // of a kernel declared by %%nvrtc with the arguments of the line. The
+    // winner is used by launcher.launch_n for problems of the same size class.
+    class nvrtc_autotune: public xmagic_line
+    {
+    public:
+
+        nvrtc_autotune(cling::Interpreter& i) : m_interpreter(i){}
+        virtual void operator()(const std::string& line) override;
+
+    private:
+
+        int getOptions(const std::string& line);
+        void publish(const std::vector<cuda::tuning_candidate>& candidates);
+
+        cling::Interpreter& m_interpreter;
+        std::string launcher;
+        std::string problemSize;
+        std::string arguments;
+        std::vector<std::string> variants;
+        std::vector<unsigned int> blocks;
+        int repeat=10;
+    };
+}
+
+#endif
@@ -0,0 +1,314 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_cache.hpp"
+#include "nvrtc_sha256.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace xcpp
+{
+    // running size of a cache directory, valid after the first scan
+    struct nvrtc_cache_usage
+    {
+        std::mutex mutex;
+        std::uintmax_t bytes = 0;
+        bool known = false;
+        std::unordered_map<std::string, int> leases;    //directory entries used by a compile of the process
+    };
+
+    namespace
+    {
+        constexpr std::uintmax_t DEFAULT_CACHE_SIZE_MB = 512;
+        constexpr auto STALE_TEMPORARY = std::chrono::hours(1);  //left behind by a crashed writer
+
+        nvrtc_cache_usage& usageOf(const std::string& directory)
+        {
+            static std::mutex mutex;
+            static std::unordered_map<std::string, std::unique_ptr<nvrtc_cache_usage>> usages;
+            std::lock_guard<std::mutex> lock(mutex);
+            std::unique_ptr<nvrtc_cache_usage>& usage = usages[directory];
+            if (!usage) usage = std::make_unique<nvrtc_cache_usage>();
+            return *usage;
+        }
+
+        bool isTemporary(const fs::path& path)
+        {
+            return path.extension() == ".tmp";
+        }
+
+        // writes the file, which must not exist yet, returns false on any error
+        bool writeNewFile(const fs::path& path, const std::string& content)
+        {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd < 0) return false;
+            const char* data = content.data();
+            std::size_t remaining = content.size();
+            while (remaining > 0)
+            {
+                ssize_t written = ::write(fd, data, remaining);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0)
+                {
+                    ::close(fd);
+                    return false;
+                }
+                data += written;
+                remaining -= static_cast<std::size_t>(written);
+            }
+            return ::close(fd) == 0;
+        }
+
+        std::string environment(const char* name)
+        {
+            const char* value = std::getenv(name);
+            return value != nullptr ? std::string(value) : std::string();
+        }
+
+        // size of a file or of all files of a directory entry
+        std::uintmax_t entrySize(const fs::directory_entry& entry)
+        {
+            std::error_code ec;
+            if (entry.is_regular_file(ec)) return entry.file_size(ec);
+            std::uintmax_t size = 0;
+            if (entry.is_directory(ec))
+            {
+                for (const fs::directory_entry& file : fs::recursive_directory_iterator(entry.path(), ec))
+                {
+                    if (file.is_regular_file(ec)) size += file.file_size(ec);
+                }
+            }
+            return size;
+        }
+    }
+
+    nvrtc_cache::nvrtc_cache()
+        : maxSize(DEFAULT_CACHE_SIZE_MB << 20)
+        , enabled(true)
+    {
+        cacheDirectory = environment("XEUS_CLING_NVRTC_CACHE_DIR");
+        if (cacheDirectory.empty() && !environment("XDG_CACHE_HOME").empty())
+        {
+            cacheDirectory = environment("XDG_CACHE_HOME") + "/xeus-cling/nvrtc";
+        }
+        if (cacheDirectory.empty() && !environment("HOME").empty())
+        {
+            cacheDirectory = environment("HOME") + "/.cache/xeus-cling/nvrtc";
+        }
+
+        std::string size = environment("XEUS_CLING_NVRTC_CACHE_SIZE");
+        if (!size.empty())
+        {
+            try
+            {
+                maxSize = std::stoull(size) << 20;
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "Invalid XEUS_CLING_NVRTC_CACHE_SIZE: " << size << std::endl;
+            }
+        }
+
+        std::error_code ec;
+        if (cacheDirectory.empty() || maxSize == 0 || (fs::create_directories(cacheDirectory, ec), ec))
+        {
+            enabled = false;    //without a writable directory the magic compiles every time
+        }
+        if (enabled) usage = &usageOf(cacheDirectory);
+    }
+
+    std::string nvrtc_cache::fingerprint(const std::vector<std::string>& parts)
+    {
+        nvrtc_sha256 hash;
+        for (const std::string& part : parts)
+        {
+            hash.update(std::to_string(part.size()) + ":");
+            hash.update(part);
+        }
+        return hash.hexdigest();
+    }
+
+    bool nvrtc_cache::load(const std::string& key, const std::string& kind, std::string& image)
+    {
+        if (!enabled) return false;
+        fs::path path = fs::path(cacheDirectory) / (key + "." + kind);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        image = buffer.str();
+
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);    //mark as recently used
+        return true;
+    }
+
+    void nvrtc_cache::store(const std::string& key, const std::string& kind, const std::string& image)
+    {
+        if (!enabled) return;
+        fs::path path = fs::path(cacheDirectory) / (key + "." + kind);
+        //each writer has its own temporary file, e.g. two background builds of the same entry
+        static std::atomic<unsigned long> counter{0};
+        fs::path temporary = path;
+        temporary += "." + std::to_string(::getpid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+                   + "." + std::to_string(counter++) + ".tmp";
+        std::error_code ec;
+        if (!writeNewFile(temporary, image))
+        {
+            fs::remove(temporary, ec);
+            return;
+        }
+        //an overwritten entry is replaced, its size is no longer used
+        std::uintmax_t previous = fs::file_size(path, ec);
+        if (ec) previous = 0;
+        // rename is atomic, concurrent kernels never read a partial entry
+        fs::rename(temporary, path, ec);
+        if (ec)
+        {
+            fs::remove(temporary, ec);
+            return;
+        }
+        account(image.size(), previous);
+    }
+
+    nvrtc_cache_lease::~nvrtc_cache_lease()
+    {
+        if (usage == nullptr) return;
+        std::lock_guard<std::mutex> lock(usage->mutex);
+        auto lease = usage->leases.find(path);
+        if (lease != usage->leases.end() && --lease->second == 0) usage->leases.erase(lease);
+    }
+
+    bool nvrtc_cache::directoryEntry(const std::string& key, const std::string& kind, std::string& path, nvrtc_cache_lease& lease)
+    {
+        if (!enabled) return false;
+        fs::path entry = fs::path(cacheDirectory) / (key + "." + kind);
+        {
+            //leased before it is created, a concurrent eviction can not remove it anymore
+            std::lock_guard<std::mutex> lock(usage->mutex);
+            if (lease.usage == nullptr)
+            {
+                lease.usage = usage;
+                lease.path = entry.string();
+                usage->leases[lease.path]++;
+            }
+        }
+        std::error_code ec;
+        fs::create_directories(entry, ec);
+        if (ec) return false;
+        path = entry.string();
+
+        bool filled = !fs::is_empty(entry, ec) && !ec;
+        fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);   //mark as recently used
+        return filled;
+    }
+
+    void nvrtc_cache::trim(const std::string& path)
+    {
+        if (!enabled) return;
+        std::error_code ec;
+        account(entrySize(fs::directory_entry(path, ec)), 0);
+    }
+
+    void nvrtc_cache::account(std::uintmax_t added, std::uintmax_t removed)
+    {
+        std::lock_guard<std::mutex> lock(usage->mutex);
+        if (usage->known) usage->bytes = usage->bytes + added - std::min(removed, usage->bytes + added);
+        //other processes write to the directory as well, the scan corrects the count
+        if (!usage->known || usage->bytes > maxSize) evict();
+    }
+
+    void nvrtc_cache::evict()
+    {
+        struct entry
+        {
+            fs::path path;
+            std::uintmax_t size;
+            fs::file_time_type lastUse;
+        };
+        std::vector<entry> entries;
+        std::uintmax_t totalSize = 0;
+        std::error_code ec;
+        auto now = fs::file_time_type::clock::now();
+
+        for (const fs::directory_entry& file : fs::directory_iterator(cacheDirectory, ec))
+        {
+            fs::file_time_type lastUse = file.last_write_time(ec);
+            if (isTemporary(file.path()))
+            {
+                //written right now by another thread or process, unless it is old
+                if (!ec && now - lastUse > STALE_TEMPORARY) fs::remove(file.path(), ec);
+                continue;
+            }
+            entry e{file.path(), entrySize(file), lastUse};
+            totalSize += e.size;
+            entries.push_back(e);
+        }
+        usage->bytes = totalSize;
+        usage->known = true;
+        if (totalSize <= maxSize) return;
+
+        //remove least recently used entries until the cache fits the limit, also recently used
+        //ones, an open file of another reader stays readable and a miss only compiles again
+        std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) { return a.lastUse < b.lastUse; });
+        for (const entry& e : entries)
+        {
+            if (totalSize <= maxSize) break;
+            if (usage->leases.count(e.path.string()) > 0) continue;     //e.g. the PCH directory of a running compile
+            if (fs::remove_all(e.path, ec) > 0) totalSize -= e.size;
+        }
+        usage->bytes = totalSize;
+    }
+
+    bool nvrtc_cache::isEnabled() const
+    {
+        return enabled;
+    }
+
+    const std::string& nvrtc_cache::directory() const
+    {
+        return cacheDirectory;
+    }
+
+    std::uintmax_t nvrtc_cache::sizeLimit() const
+    {
+        return maxSize;
+    }
+
+    std::uintmax_t nvrtc_cache::size() const
+    {
+        std::uintmax_t totalSize = 0;
+        std::error_code ec;
+        if (!enabled) return 0;
+        for (const fs::directory_entry& file : fs::directory_iterator(cacheDirectory, ec))
+        {
+            if (!isTemporary(file.path())) totalSize += entrySize(file);
+        }
+        return totalSize;
+    }
+}
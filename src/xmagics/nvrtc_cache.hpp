@@ -0,0 +1,86 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_CACHE_HPP
+#define XMAGICS_NVRTC_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xcpp
+{
+    struct nvrtc_cache_usage;
+
+    // keeps a directory entry from being evicted while a compile uses it,
+    // e.g. the precompiled headers of a background build
+    class nvrtc_cache_lease
+    {
+    public:
+
+        nvrtc_cache_lease() = default;
+        ~nvrtc_cache_lease();
+
+        nvrtc_cache_lease(const nvrtc_cache_lease&) = delete;
+        nvrtc_cache_lease& operator=(const nvrtc_cache_lease&) = delete;
+
+    private:
+
+        friend class nvrtc_cache;
+
+        nvrtc_cache_usage* usage = nullptr;
+        std::string path;
+    };
+
+    // Content addressed cache for PTX/CUBIN images of the %%nvrtc magic.
+    // Entries are stored as <key>.<kind> files in the cache directory, the
+    // modification time is used as last access time for the LRU eviction.
+    // The size of the directory is counted along with the writes of the
+    // process, the directory is only scanned when the limit is exceeded.
+    // Directory entries (<key>.<kind>/) are filled by the compiler itself,
+    // e.g. precompiled headers, and are evicted as a whole. Only entries leased
+    // by a running compile of the process may keep the cache above the limit.
+    //
+    // The directory is XEUS_CLING_NVRTC_CACHE_DIR, $XDG_CACHE_HOME/xeus-cling/nvrtc
+    // or ~/.cache/xeus-cling/nvrtc, the size limit in MB XEUS_CLING_NVRTC_CACHE_SIZE.
+    class nvrtc_cache
+    {
+    public:
+
+        nvrtc_cache();
+
+        // SHA-256 over all parts, each part is prefixed with its length
+        static std::string fingerprint(const std::vector<std::string>& parts);
+
+        bool load(const std::string& key, const std::string& kind, std::string& image);
+        void store(const std::string& key, const std::string& kind, const std::string& image);
+
+        // creates the directory entry if needed, returns false if it is missing or empty;
+        // the entry is not evicted until the lease is destroyed
+        bool directoryEntry(const std::string& key, const std::string& kind, std::string& path, nvrtc_cache_lease& lease);
+        void trim(const std::string& path);    //counts a directory entry after it was filled
+
+        bool isEnabled() const;
+        const std::string& directory() const;
+        std::uintmax_t sizeLimit() const;
+        std::uintmax_t size() const;    //bytes used by the entries
+
+    private:
+
+        void account(std::uintmax_t added, std::uintmax_t removed);
+        void evict();   //with the lock of the usage
+
+        std::string cacheDirectory;
+        nvrtc_cache_usage* usage = nullptr;     //shared by all instances of the process with the same directory
+        std::uintmax_t maxSize;
+        bool enabled;
+    };
+}
+
+#endif
@@ -0,0 +1,610 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_compiler.hpp"
+#include "nvrtc_lexer.hpp"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <regex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_set>
+
+#define ERROR_CODE -1
+#define SUCCESS 0
+
+namespace xcpp
+{
+    namespace
+    {
+        // the PCH heap of NVRTC is global to the process, it is resized only
+        // while no compilation of any build runs (shared by the compilations)
+        std::shared_mutex& pchHeapMutex()
+        {
+            static std::shared_mutex mutex;
+            return mutex;
+        }
+    }
+
+    void nvrtc_compiler::setDevices(const std::vector<CUcontext>& deviceContexts, const std::shared_ptr<nvrtc_device_workers>& workers)
+    {
+        contexts = deviceContexts;
+        deviceCount = static_cast<int>(contexts.size());
+        deviceWorkers = workers;
+    }
+
+    nvrtc_target nvrtc_compiler::fixedTarget(const std::vector<std::string>& options, const std::string& architecture)
+    {
+        nvrtc_target target;
+        target.options = options;
+        target.cubin = architecture.find("sm_") != std::string::npos && nvrtc_api::instance().nvrtc.nvrtcGetCUBIN != nullptr;
+        return target;
+    }
+
+    void nvrtc_compiler::setTargetKeys(nvrtc_build& build)
+    {
+        for (nvrtc_target& target : build.targets)
+        {
+            std::vector<std::string> parts = {build.cacheKey, target.cubin ? "cubin" : "ptx"};
+            parts.insert(parts.end(), target.options.begin(), target.options.end());
+            target.cacheKey = nvrtc_cache::fingerprint(parts);
+        }
+    }
+
+    int nvrtc_compiler::buildProgram(nvrtc_build& build)
+    {
+        //does not use cling or the cell output, can run on any thread
+        setTargetKeys(build);
+
+        //a larger PCH heap was requested by the last compilation
+        nvrtc_api& api = nvrtc_api::instance();
+        std::size_t heapSize = 0;
+        std::size_t required = pchHeapRequired.exchange(0);
+        if (required > 0 && api.nvrtc.nvrtcGetPCHHeapSize != nullptr && api.nvrtc.nvrtcSetPCHHeapSize != nullptr)
+        {
+            std::unique_lock<std::shared_mutex> lock(pchHeapMutex());
+            if (api.nvrtc.nvrtcGetPCHHeapSize(&heapSize) == NVRTC_API_SUCCESS && required > heapSize) api.nvrtc.nvrtcSetPCHHeapSize(required);
+        }
+
+        //the architectures are compiled concurrently, NVRTC programs are independent
+        std::vector<std::future<int>> compilations;
+        for (std::size_t i = 1; i < build.targets.size(); i++)
+        {
+            compilations.push_back(std::async(std::launch::async, [this, &build, i]() { return definePTX(build, build.targets[i]); }));
+        }
+        int result = build.targets.empty() ? SUCCESS : definePTX(build, build.targets[0]);
+        for (std::future<int>& compilation : compilations)
+        {
+            if (compilation.get() != SUCCESS) result = ERROR_CODE;
+        }
+        for (std::size_t i = 0; i < build.targets.size(); i++)
+        {
+            //a source error is reported once, not for each architecture
+            if (i == 0 || build.targets[i].errors != build.targets[i - 1].errors) build.errors += build.targets[i].errors;
+        }
+        if (result != SUCCESS) return ERROR_CODE;
+        if (build.rdc && SUCCESS != linkTargets(build)) return ERROR_CODE;
+
+        //the kernels are the same for all architectures
+        if (!build.targets.empty())
+        {
+            build.program.functionNames = build.targets[0].functionNames;
+            build.program.expressions = build.targets[0].expressions;
+        }
+        build.program.compilerLogs.assign(deviceCount, "");
+        for (const nvrtc_target& target : build.targets)
+        {
+            for (int device : target.devices) build.program.compilerLogs[device] = target.log;
+        }
+        build.program.reported = build.showReport;
+        if(SUCCESS!=generateKernelFunction(build)) return ERROR_CODE;
+        collectLauncherTypes(build);
+        return SUCCESS;
+    }
+
+    int nvrtc_compiler::definePTX(const nvrtc_build& build, nvrtc_target& target)
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+
+        //same source, headers, options and compiler version, skip NVRTC
+        std::string loweredNames;
+        bool ltoir = !target.linkArchitecture.empty();
+        std::string kind = ltoir ? "ltoir" : (target.cubin ? "cubin" : "ptx");
+        bool ptxasLog = build.showReport && target.cubin && !ltoir;    //ptxas runs in NVRTC only for CUBIN
+        bool ptxText = build.showPTXStats && target.cubin && !ltoir;   //the image of a PTX target is the text itself
+        std::string label = kind;
+        for (const std::string& option : target.options)
+        {
+            if (option.rfind("-arch=", 0) == 0) label = option.substr(6);
+        }
+        bool cached;
+        {
+            nvrtc_phase phase(build.timings.get(), "cache lookup");
+            cached = build.useCache && diskCache.load(target.cacheKey, kind, target.image)
+                && (build.nameExpressions.empty() || diskCache.load(target.cacheKey, "names", loweredNames))
+                && (!ptxasLog || diskCache.load(target.cacheKey, "ptxas", target.log))      //else compiled again for the log
+                && (!ptxText || diskCache.load(target.cacheKey, "ptx", target.ptx));
+        }
+        if (cached)
+        {
+            if (build.nameExpressions.empty())
+            {
+                //the kernels of LTO-IR are known after the link
+                if (!ltoir) target.functionNames = target.cubin ? extractCubinFunctionNames(target.image) : extractFunctionNames(target.image);
+                return SUCCESS;
+            }
+            //one line with the name expression and one with the lowered name per instantiation
+            std::istringstream names(loweredNames);
+            std::string expression, lowered;
+            while (std::getline(names, expression) && std::getline(names, lowered))
+            {
+                target.functionNames.push_back(lowered);
+                target.expressions[lowered] = expression;
+            }
+            return SUCCESS;
+        }
+
+        if (ltoir && (api.nvrtc.nvrtcGetLTOIRSize == nullptr || api.nvrtc.nvrtcGetLTOIR == nullptr))
+        {
+            target.errors += "NVRTC Error: -rdc needs NVRTC 12.0 or newer\n";
+            return ERROR_CODE;
+        }
+
+        std::vector<const char*> headerNames;
+        std::vector<const char*> headerContents;
+        std::vector<const char*> options;
+
+        //the strings are passed directly to NVRTC, no copy in the cling context is needed
+        for (std::size_t i = 0; i < build.headers.size(); i++)
+        {
+            headerNames.push_back(build.headers[i].c_str());
+            headerContents.push_back(build.contents[i].c_str());
+        }
+        for (const std::string& sopt : target.options)
+        {
+            options.push_back(sopt.c_str());
+        }
+        int major = 0, minor = 0;
+        api.nvrtc.nvrtcVersion(&major, &minor);
+        //resource usage of each function in the program log, not part of the cache key
+        if (ptxasLog) options.push_back("--ptxas-options=-v");
+        //precompiled headers (NVRTC 12.4), shared by all cells with the same headers and options
+        std::string pchDir;
+        std::string pchPath;
+        nvrtc_cache_lease pchLease;     //the directory is not evicted during the compile
+        bool pchFound = false;
+        if (build.usePCH && !build.headers.empty() && api.nvrtc.nvrtcGetPCHCreateStatus != nullptr)
+        {
+            std::vector<std::string> parts = {"pch", std::to_string(major) + "." + std::to_string(minor)};
+            parts.insert(parts.end(), build.headers.begin(), build.headers.end());
+            parts.insert(parts.end(), build.contents.begin(), build.contents.end());
+            parts.insert(parts.end(), target.options.begin(), target.options.end());
+            pchFound = diskCache.directoryEntry(nvrtc_cache::fingerprint(parts), "pch", pchPath, pchLease);
+            if (!pchPath.empty())
+            {
+                pchDir = "-pch-dir=" + pchPath;
+                options.push_back("-pch");
+                options.push_back(pchDir.c_str());
+            }
+        }
+
+        nvrtc_program_ptr program;     //destroyed on every return
+        int result = createProgram(program, build.code.c_str(), "xeus_cling.cu", static_cast<int>(build.headers.size()),
+                                                  headerContents.empty() ? nullptr : headerContents.data(),
+                                                  headerNames.empty() ? nullptr : headerNames.data());
+        if (result != NVRTC_API_SUCCESS)
+        {
+            target.errors += "NVRTC Error:" + api.nvrtcError(result) + "\n";
+            return ERROR_CODE;
+        }
+
+        for (const std::string& expression : build.nameExpressions)
+        {
+            result = api.nvrtc.nvrtcAddNameExpression(program.get(), expression.c_str());
+            if (result != NVRTC_API_SUCCESS)
+            {
+                target.errors += "NVRTC Error:" + expression + ": " + api.nvrtcError(result) + "\n";
+                return ERROR_CODE;
+            }
+        }
+
+        //NVRTC reports the time of its own phases (since 12.1), not part of the cache key; a file
+        //of its own, concurrent builds of the same target may run in this or another process
+        std::string timeFile;
+        if (build.showTimings && (major > 12 || (major == 12 && minor >= 1)))
+        {
+            std::string path = (std::filesystem::temp_directory_path() / "xeus_cling_nvrtc_XXXXXX.csv").string();
+            int fd = ::mkstemps(&path[0], 4);
+            if (fd >= 0)
+            {
+                ::close(fd);
+                timeFile = "-time=" + path;
+                options.push_back(timeFile.c_str());
+            }
+        }
+        {
+            std::shared_lock<std::shared_mutex> lock(pchHeapMutex());
+            nvrtc_phase phase(build.timings.get(), "compile " + label);
+            result = api.nvrtc.nvrtcCompileProgram(program.get(), static_cast<int>(options.size()), options.empty() ? nullptr : options.data());
+        }
+        if (!timeFile.empty())
+        {
+            std::string path = timeFile.substr(6);
+            std::ifstream file(path);
+            std::stringstream report;
+            report << file.rdbuf();
+            if (!report.str().empty()) build.timings->addCompilerReport("[" + label + "]\n" + report.str());
+            std::remove(path.c_str());
+        }
+        //keep errors if compilation is not without errors
+        if (result != NVRTC_API_SUCCESS)
+        {
+            target.errors += api.nvrtcError(result) + "\n" + getProgramLog(program.get()) + "\n";
+            return ERROR_CODE;
+        }
+        if (ptxasLog) target.log = getProgramLog(program.get());
+        std::size_t ptxSize = 0;
+        if (ptxText && api.nvrtc.nvrtcGetPTXSize(program.get(), &ptxSize) == NVRTC_API_SUCCESS && ptxSize > 1)
+        {
+            target.ptx.assign(ptxSize, '\0');
+            if (api.nvrtc.nvrtcGetPTX(program.get(), &target.ptx[0]) == NVRTC_API_SUCCESS) target.ptx.resize(ptxSize - 1);
+            else target.ptx.clear();
+        }
+        if (!pchDir.empty())
+        {
+            //no creation is attempted if a precompiled header of the directory was used
+            int created = api.nvrtc.nvrtcGetPCHCreateStatus(program.get());
+            std::size_t heap = 0;
+            std::string status = created == NVRTC_API_SUCCESS ? "created" : "failed";
+            if (created == NVRTC_API_ERROR_NO_PCH_CREATE_ATTEMPTED) status = pchFound ? "hit" : "not used";
+            if (created == NVRTC_API_ERROR_PCH_CREATE_HEAP_EXHAUSTED && api.nvrtc.nvrtcGetPCHHeapSizeRequired != nullptr
+                && api.nvrtc.nvrtcGetPCHHeapSizeRequired(program.get(), &heap) == NVRTC_API_SUCCESS)
+            {
+                status = "heap exhausted";
+                std::size_t previous = pchHeapRequired.load();
+                while (previous < heap && !pchHeapRequired.compare_exchange_weak(previous, heap)) {}
+            }
+            if (created == NVRTC_API_SUCCESS) diskCache.trim(pchPath);
+            build.timings->setStatus("pch " + label, status);
+        }
+
+        // generate PTX Code, the size contains the terminating null character
+        nvrtc_phase extraction(build.timings.get(), "image extraction " + label);
+        std::size_t imageSize = 0;
+        if (ltoir) result = api.nvrtc.nvrtcGetLTOIRSize(program.get(), &imageSize);
+        else result = target.cubin ? api.nvrtc.nvrtcGetCUBINSize(program.get(), &imageSize) : api.nvrtc.nvrtcGetPTXSize(program.get(), &imageSize);
+        if (result == NVRTC_API_SUCCESS)
+        {
+            target.image.assign(imageSize, '\0');
+            if (ltoir) result = api.nvrtc.nvrtcGetLTOIR(program.get(), &target.image[0]);
+            else result = target.cubin ? api.nvrtc.nvrtcGetCUBIN(program.get(), &target.image[0]) : api.nvrtc.nvrtcGetPTX(program.get(), &target.image[0]);
+        }
+        //the lowered (mangled) names of the instantiations, valid until the program is destroyed
+        for (std::size_t i = 0; i < build.nameExpressions.size() && result == NVRTC_API_SUCCESS; i++)
+        {
+            const char* lowered = nullptr;
+            result = api.nvrtc.nvrtcGetLoweredName(program.get(), build.nameExpressions[i].c_str(), &lowered);
+            if (result == NVRTC_API_SUCCESS)
+            {
+                target.functionNames.push_back(lowered);
+                target.expressions[lowered] = build.nameExpressions[i];
+                loweredNames += build.nameExpressions[i] + "\n" + lowered + "\n";
+            }
+        }
+        program.reset();
+        if (result != NVRTC_API_SUCCESS)
+        {
+            target.errors += "NVRTC Error:" + api.nvrtcError(result) + "\n";
+            return ERROR_CODE;
+        }
+        if (build.useCache)
+        {
+            diskCache.store(target.cacheKey, kind, target.image);
+            if (!build.nameExpressions.empty()) diskCache.store(target.cacheKey, "names", loweredNames);
+            if (ptxasLog) diskCache.store(target.cacheKey, "ptxas", target.log);
+            if (ptxText && !target.ptx.empty()) diskCache.store(target.cacheKey, "ptx", target.ptx);
+        }
+
+        //kernels of instantiations are known by their lowered name, otherwise search for function in PTX Code
+        if (build.nameExpressions.empty() && !ltoir) target.functionNames = target.cubin ? extractCubinFunctionNames(target.image) : extractFunctionNames(target.image);
+        return SUCCESS;
+    }
+
+    int nvrtc_compiler::generateKernelFunction(nvrtc_build& build)
+    { 
+        nvrtc_api& api = nvrtc_api::instance();
+        nvrtc_loaded_program& program = build.program;
+        std::vector<std::vector<CUfunction>> deviceFunctions(deviceCount);
+        std::vector<std::string> errors(deviceCount);
+        program.modules.assign(deviceCount, nullptr);
+        std::vector<CUmodule> modules(deviceCount, nullptr);
+
+        //image of each device, shared by all devices of the same architecture
+        std::vector<const std::string*> images(deviceCount, nullptr);
+        for (const nvrtc_target& target : build.targets)
+        {
+            for (int device : target.devices) images[device] = &target.image;
+        }
+
+        //load the image in a module of the device context and get the functions,
+        //runs on the thread of the device, output is collected for the cell
+        auto loadModule = [&](int device)
+        {
+            nvrtc_phase phase(build.timings.get(), "module load GPU" + std::to_string(device));
+            int result = api.cuda.cuModuleLoadData(&modules[device], images[device]->data());
+            if (result != CUDA_API_SUCCESS)
+            {
+                errors[device] = "cuModuleLoadData: " + api.cudaError(result);
+                return;
+            }
+            //owned by the program from here, also if loading on another device fails
+            program.modules[device] = std::make_shared<nvrtc_module>(modules[device], contexts[device], images[device]->size());
+            for (const std::string& s: program.functionNames)
+            {
+                CUfunction function = nullptr;
+                result = api.cuda.cuModuleGetFunction(&function, modules[device], s.c_str());
+                if (result != CUDA_API_SUCCESS) errors[device] += "cuModuleGetFunction: " + s + ": " + api.cudaError(result) + "\n";
+                deviceFunctions[device].push_back(function);
+            }
+        };
+
+        if(deviceCount==1) //no thread switch for a single device
+        {
+            api.cuda.cuCtxSetCurrent(contexts[0]);
+            loadModule(0);
+        }
+        else if(deviceCount>1)   //the driver JIT of all devices runs concurrently
+        {
+            deviceWorkers->runOnAll(loadModule);
+        }
+
+        bool loaded = true;
+        for (int i = 0; i < deviceCount; i++)
+        {
+            //a missing function fails the build, no null handle is bound
+            if (!errors[i].empty()) build.errors += "CUDA Error: GPU" + std::to_string(i) + ": " + errors[i] + "\n";
+            if (program.modules[i] == nullptr || !errors[i].empty()) loaded = false;
+        }
+        if (!loaded) return ERROR_CODE;
+
+        //the handles of each device are in the order of the function names
+        for (std::size_t k = 0; k < program.functionNames.size(); k++)
+        {
+            std::vector<CUfunction>& functions = program.functions[program.functionNames[k]];
+            for (int i = 0; i < deviceCount; i++)
+            {
+                functions.push_back(deviceFunctions[i][k]);
+            }
+        }
+        return SUCCESS;
+    }
+
+    int nvrtc_compiler::linkTargets(nvrtc_build& build)
+    {
+        //the cell is identified by the kernels and device functions it defines
+        nvrtc_link_unit unit;
+        nvrtc_source source = scanSource(build.code);
+        for (const nvrtc_kernel_declaration& kernel : source.kernels) unit.kernels.push_back(kernel.name);
+        unit.symbols = unit.kernels;
+        unit.symbols.insert(unit.symbols.end(), source.deviceFunctions.begin(), source.deviceFunctions.end());
+        if (unit.symbols.empty()) unit.symbols.push_back(build.cacheKey);
+        for (nvrtc_target& target : build.targets)
+        {
+            unit.ltoir[target.linkArchitecture] = std::move(target.image);
+            unit.keys[target.linkArchitecture] = target.cacheKey;
+            unit.expressions.insert(target.expressions.begin(), target.expressions.end());
+        }
+
+        //only the link runs again for the unchanged cells
+        std::vector<nvrtc_link_unit> units = linkSet.with(unit);
+        std::unordered_set<std::string> kernels;
+        for (const nvrtc_link_unit& u : units) kernels.insert(u.kernels.begin(), u.kernels.end());
+        std::vector<std::string> programParts = {"link"};
+        for (nvrtc_target& target : build.targets)
+        {
+            nvrtc_phase phase(build.timings.get(), "link " + target.linkArchitecture);
+            std::vector<std::string> parts = {"link", target.linkArchitecture};
+            for (const nvrtc_link_unit& u : units)
+            {
+                auto key = u.keys.find(target.linkArchitecture);
+                parts.push_back(key != u.keys.end() ? key->second : "");
+            }
+            target.cacheKey = nvrtc_cache::fingerprint(parts);
+            target.image.clear();
+            if (!(build.useCache && diskCache.load(target.cacheKey, "cubin", target.image)))
+            {
+                if (SUCCESS != linkUnits(units, target.linkArchitecture, target.image, target.errors))
+                {
+                    build.errors += target.errors;
+                    return ERROR_CODE;
+                }
+                if (build.useCache) diskCache.store(target.cacheKey, "cubin", target.image);
+            }
+            target.expressions.clear();
+            for (const nvrtc_link_unit& u : units) target.expressions.insert(u.expressions.begin(), u.expressions.end());
+            //device functions which are not inlined are global symbols of the image as well
+            target.functionNames.clear();
+            for (const std::string& s : extractCubinFunctionNames(target.image))
+            {
+                if (target.expressions.count(s) > 0 || kernels.count(kernelName(s)) > 0) target.functionNames.push_back(s);
+            }
+            programParts.push_back(target.cacheKey);
+        }
+        linkSet.add(unit);
+        build.cacheKey = nvrtc_cache::fingerprint(programParts);   //the loaded program belongs to the linked image
+        return SUCCESS;
+    }
+
+    void nvrtc_compiler::collectLauncherTypes(nvrtc_build& build)
+    {
+        //signatures of the kernels in the source, overloaded kernels get no launcher
+        std::unordered_map<std::string, std::string> parameters;
+        std::unordered_map<std::string, bool> unique;
+        for (const nvrtc_kernel_declaration& kernel : scanSource(build.code).kernels)
+        {
+            if (kernel.isTemplate) continue;
+            auto found = parameters.find(kernel.name);
+            if (found == parameters.end())
+            {
+                parameters[kernel.name] = kernel.parameters;
+                unique[kernel.name] = true;
+            }
+            else if (found->second != kernel.parameters) unique[kernel.name] = false;
+        }
+
+        for (const std::string& s: build.program.functionNames)
+        {
+            if (build.program.expressions.count(s)) continue;   //template instantiations
+            std::string name = kernelName(s);
+            std::string types;
+            if (unique.count(name) && unique[name] && getLauncherTypes(parameters[name], types)) build.program.launcherTypes[s] = types;
+        }
+    }
+
+    bool nvrtc_compiler::getLauncherTypes(const std::string& parameters, std::string& types)
+    {
+        static const std::unordered_set<std::string> qualifiers = {"const", "volatile", "register", "__restrict__", "__restrict", "__grid_constant__"};
+        static const std::unordered_set<std::string> builtinTypes = {"bool", "char", "short", "int", "long", "float", "double", "signed", "unsigned", "wchar_t", "char16_t", "char32_t"};
+
+        //split at the commas outside of template arguments and parentheses
+        std::vector<std::string> split(1);
+        int depth = 0;
+        for (char c : parameters)
+        {
+            if (c == '<' || c == '(' || c == '[') depth++;
+            else if (c == '>' || c == ')' || c == ']') depth--;
+            if (c == ',' && depth == 0) split.emplace_back();
+            else split.back() += c;
+        }
+
+        types.clear();
+        for (std::string parameter : split)
+        {
+            std::size_t defaultValue = parameter.find('=');
+            if (defaultValue != std::string::npos) parameter.erase(defaultValue);
+
+            //pointers and arrays are passed as device pointer, references can not be kernel parameters
+            if (parameter.find('&') != std::string::npos) return false;
+            bool pointer = parameter.find('*') != std::string::npos || parameter.find('[') != std::string::npos;
+
+            //words of the type, template arguments stay with their template name
+            std::vector<std::string> words;
+            std::string word;
+            depth = 0;
+            for (char c : parameter + " ")
+            {
+                if (c == '<') depth++;
+                else if (c == '>') depth--;
+                if (depth == 0 && (std::isspace(static_cast<unsigned char>(c)) || c == '*'))
+                {
+                    if (!word.empty() && !qualifiers.count(word)) words.push_back(word);
+                    word.clear();
+                }
+                else word += c;
+            }
+            if (words.size() == 1 && words[0] == "void" && split.size() == 1) break;    //f(void)
+            if (words.empty())
+            {
+                if (split.size() == 1) break;   //no parameters
+                return false;
+            }
+
+            //remove the parameter name
+            if (words.size() > 1 && !builtinTypes.count(words.back())) words.pop_back();
+
+            std::string type;
+            for (const std::string& w : words) type += (type.empty() ? "" : " ") + w;
+            if (pointer) type = "CUdeviceptr";
+            types += (types.empty() ? "" : ", ") + type;
+        }
+        return true;
+    }
+
+    std::string nvrtc_compiler::getProgramLog(nvrtcProgram program)
+    {
+        nvrtc_functions& rtc = nvrtc_api::instance().nvrtc;
+        std::size_t logSize = 0;
+        if (rtc.nvrtcGetProgramLogSize(program, &logSize) != NVRTC_API_SUCCESS || logSize <= 1) return "";
+        std::string log(logSize, '\0');
+        rtc.nvrtcGetProgramLog(program, &log[0]);
+        log.resize(logSize - 1);    //remove terminating null character
+        return log;
+    }
+
+    std::vector<std::string> nvrtc_compiler::extractCubinFunctionNames(const std::string& cubin)
+    {
+        //global functions of the ELF symbol table, the same as the .globl entries of the PTX
+        std::vector<std::string> listOfFunctions;
+        auto read = [&cubin](std::size_t offset, std::size_t size) -> std::uint64_t
+        {
+            std::uint64_t value = 0;
+            if (offset + size <= cubin.size()) std::memcpy(&value, cubin.data() + offset, size);   //ELF of the devices is little endian
+            return value;
+        };
+        if (cubin.size() < 64 || cubin.compare(0, 4, "\x7f" "ELF") != 0 || cubin[4] != 2) return listOfFunctions;
+
+        std::uint64_t sectionOffset = read(0x28, 8);
+        std::uint64_t sectionSize = read(0x3A, 2);
+        std::uint64_t sectionCount = read(0x3C, 2);
+        for (std::uint64_t i = 0; i < sectionCount; i++)
+        {
+            std::uint64_t section = sectionOffset + i * sectionSize;
+            if (read(section + 4, 4) != 2) continue;    //SHT_SYMTAB
+            std::uint64_t symbols = read(section + 24, 8);
+            std::uint64_t symbolsSize = read(section + 32, 8);
+            std::uint64_t symbolSize = read(section + 56, 8);
+            std::uint64_t strings = read(sectionOffset + read(section + 40, 4) * sectionSize + 24, 8);
+            if (symbolSize == 0) continue;
+
+            for (std::uint64_t symbol = symbols; symbol + symbolSize <= symbols + symbolsSize; symbol += symbolSize)
+            {
+                std::uint64_t info = read(symbol + 4, 1);
+                std::uint64_t sectionIndex = read(symbol + 6, 2);
+                if ((info >> 4) != 1 || (info & 0xf) != 2 || sectionIndex == 0) continue;  //STB_GLOBAL, STT_FUNC, defined
+                std::size_t name = static_cast<std::size_t>(strings + read(symbol, 4));
+                if (name < cubin.size()) listOfFunctions.push_back(std::string(cubin.c_str() + name));
+            }
+        }
+        return listOfFunctions;
+    }
+
+    std::vector<std::string> nvrtc_compiler::extractFunctionNames(const std::string& ptx)
+    {
+        std::vector<std::string> listOfFunctions;
+        std::string singleFinding;
+        std::regex ptxFunctionName(R"(\/\/ .globl\s(\w*))"); // seraching for global function definition
+        auto words_begin =std::sregex_iterator(ptx.begin(),ptx.end(),ptxFunctionName);
+        auto words_end =std::sregex_iterator();
+
+        for(std::sregex_iterator i = words_begin; i != words_end; ++i){
+            std::smatch match = *i;
+            listOfFunctions.push_back(match[1].str());  // list all function names
+        }
+        return listOfFunctions;
+    }
+
+    std::string nvrtc_compiler::kernelName(const std::string& mangled)
+    {
+        //name of the kernel in the source, _Z<length><name><parameters>
+        if (mangled.size() < 3 || mangled.compare(0, 2, "_Z") != 0 || !std::isdigit(static_cast<unsigned char>(mangled[2]))) return mangled;
+        std::size_t countNumbers = 0;
+        while (2 + countNumbers < mangled.size() && std::isdigit(static_cast<unsigned char>(mangled[2 + countNumbers]))) countNumbers++;
+        return mangled.substr(countNumbers + 2, std::stoul(mangled.substr(2, countNumbers)));
+    }
+}
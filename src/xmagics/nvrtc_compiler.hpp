@@ -0,0 +1,124 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_COMPILER_HPP
+#define XMAGICS_NVRTC_COMPILER_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_cache.hpp"
+#include "nvrtc_link.hpp"
+#include "nvrtc_timings.hpp"
+#include "nvrtc_workers.hpp"
+
+namespace xcpp
+{
+    // modules and function handles of one compilation, per device. The modules
+    // are unloaded when the last reference to the program is released.
+    struct nvrtc_loaded_program
+    {
+        std::vector<std::shared_ptr<nvrtc_module>> modules;
+        std::vector<std::string> functionNames;
+        std::unordered_map<std::string, std::vector<CUfunction>> functions;
+        std::unordered_map<std::string, std::string> expressions;  //lowered name to -instantiate name expression
+        std::unordered_map<std::string, std::string> launcherTypes;    //function to parameter types of its typed launcher
+        std::vector<std::string> compilerLogs;  //ptxas -v output per device, compiled with -report
+        bool reported = false;
+    };
+
+    // one NVRTC compilation of a build, shared by all devices with the same architecture
+    struct nvrtc_target
+    {
+        std::vector<std::string> options;   //compile options of the build and the architecture
+        std::vector<int> devices;
+        bool cubin = false;                 //compiled for a real architecture, else PTX
+        std::string linkArchitecture;       //-rdc: LTO-IR, linked by nvJitLink for this architecture
+        std::string cacheKey;
+        std::string image;
+        std::vector<std::string> functionNames;
+        std::unordered_map<std::string, std::string> expressions;
+        std::string errors;
+        std::string log;                    //ptxas -v output of -report, only for CUBIN
+        std::string ptx;                    //PTX of a CUBIN target for -ptxstats
+    };
+
+    // input and result of one compilation, owned by the build so it can run
+    // on a background thread while the cell input of the magic changes
+    struct nvrtc_build
+    {
+        std::string code;
+        std::string cacheKey;
+        std::vector<std::string> headers;
+        std::vector<std::string> contents;
+        std::vector<std::string> options;
+        std::vector<std::string> nameExpressions;   //template instantiations of -instantiate
+        bool useCache = true;
+        bool usePCH = true;     //automatic precompiled headers, stored in the cache
+        bool rdc = false;       //linked with the other -rdc cells of the session
+
+        std::vector<nvrtc_target> targets;
+        std::shared_ptr<nvrtc_timings> timings = std::make_shared<nvrtc_timings>();
+        bool showTimings = false;
+        bool showReport = false;
+        bool showPTXStats = false;
+        nvrtc_loaded_program program;
+        std::string errors;     //compile and load errors, reported by the caller
+    };
+
+    // Compiles builds with NVRTC and loads them on the devices. Uses neither
+    // cling nor the frontend, the magic shares it with its -async builds
+    // through a shared_ptr, so a background build does not depend on the magic.
+    class nvrtc_compiler
+    {
+    public:
+
+        nvrtc_compiler() = default;
+
+        nvrtc_compiler(const nvrtc_compiler&) = delete;
+        nvrtc_compiler& operator=(const nvrtc_compiler&) = delete;
+
+        // contexts of the devices, set once before the first build
+        void setDevices(const std::vector<CUcontext>& deviceContexts, const std::shared_ptr<nvrtc_device_workers>& workers);
+
+        int buildProgram(nvrtc_build& build);
+        int definePTX(const nvrtc_build& build, nvrtc_target& target);
+        void collectLauncherTypes(nvrtc_build& build);
+
+        // target of all devices for an architecture set with -co, or of the NVRTC
+        // default: CUBIN for a real architecture (sm_), else PTX
+        static nvrtc_target fixedTarget(const std::vector<std::string>& options, const std::string& architecture);
+        // cache keys of the targets, from the key of the build and the options of each target
+        static void setTargetKeys(nvrtc_build& build);
+
+        static bool getLauncherTypes(const std::string& parameters, std::string& types);
+        static std::string getProgramLog(nvrtcProgram program);
+        static std::vector<std::string> extractFunctionNames(const std::string& ptx);
+        static std::vector<std::string> extractCubinFunctionNames(const std::string& cubin);
+        static std::string kernelName(const std::string& mangled);
+
+    private:
+
+        int generateKernelFunction(nvrtc_build& build);
+        int linkTargets(nvrtc_build& build);
+
+        std::vector<CUcontext> contexts;
+        int deviceCount = 0;
+        std::shared_ptr<nvrtc_device_workers> deviceWorkers;
+        nvrtc_cache diskCache;                          //persistent PTX cache, shared between kernel restarts
+        std::atomic<std::size_t> pchHeapRequired{0};    //PCH heap size, set before the next build
+        nvrtc_link_set linkSet;                         //-rdc cells of the session
+    };
+}
+
+#endif
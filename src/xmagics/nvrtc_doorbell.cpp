@@ -0,0 +1,120 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_doorbell.hpp"
+#include "nvrtc_sha256.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <random>
+
+#include "nlohmann/json.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        std::string randomId()
+        {
+            static std::mutex mutex;
+            static std::mt19937_64 generator(std::random_device{}());
+            std::lock_guard<std::mutex> lock(mutex);
+            static const char* digits = "0123456789abcdef";
+            std::string id;
+            for (int i = 0; i < 32; i++) id += digits[generator() & 0xf];
+            return id;
+        }
+
+        std::string isoDate()
+        {
+            std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            char text[32];
+            std::tm utc;
+            gmtime_r(&now, &utc);
+            std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+            return text;
+        }
+    }
+
+    nvrtc_doorbell& nvrtc_doorbell::instance()
+    {
+        //never destroyed, a background build may ring during the exit
+        static nvrtc_doorbell* doorbell = new nvrtc_doorbell();
+        return *doorbell;
+    }
+
+    void nvrtc_doorbell::configure(const std::string& transport, const std::string& ip, const std::string& shellPort,
+                                   const std::string& signatureScheme, const std::string& signatureKey)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        socket.reset();
+        endpoint.clear();
+        if (!signatureKey.empty() && signatureScheme != "hmac-sha256")
+        {
+            std::clog << "The %%nvrtc doorbell does not support the signature scheme " << signatureScheme
+                      << ", results of -async builds are shown with the next request" << std::endl;
+            return;
+        }
+        //the endpoints of the wire protocol, ipc uses the ip as path, a wildcard address is reached locally
+        std::string host = transport == "tcp" && (ip == "*" || ip == "0.0.0.0") ? "127.0.0.1" : ip;
+        endpoint = transport + "://" + host + (transport == "tcp" ? ":" : "-") + shellPort;
+        key = signatureKey;
+        session = randomId();
+    }
+
+    void nvrtc_doorbell::ring()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (endpoint.empty()) return;
+        try
+        {
+            if (!socket)
+            {
+                socket = std::make_unique<zmq::socket_t>(context, zmq::socket_type::dealer);
+                socket->set(zmq::sockopt::linger, 0);
+                socket->connect(endpoint);
+            }
+            //the replies of earlier rings are not needed
+            zmq::message_t reply;
+            while (socket->recv(reply, zmq::recv_flags::dontwait)) {}
+
+            std::vector<std::string> frames = message(key, session);
+            for (std::size_t i = 0; i < frames.size(); i++)
+            {
+                zmq::send_flags flags = i + 1 < frames.size() ? zmq::send_flags::sndmore : zmq::send_flags::none;
+                socket->send(zmq::buffer(frames[i]), flags | zmq::send_flags::dontwait);
+            }
+        }
+        catch (const zmq::error_t& e)
+        {
+            //the posted tasks run with the next request instead
+            std::clog << "The %%nvrtc doorbell failed: " << e.what() << std::endl;
+            socket.reset();
+        }
+    }
+
+    std::vector<std::string> nvrtc_doorbell::message(const std::string& key, const std::string& session)
+    {
+        nlohmann::json header = {
+            {"msg_id", randomId()},
+            {"session", session},
+            {"username", "xeus-cling"},
+            {"date", isoDate()},
+            {"msg_type", "is_complete_request"},
+            {"version", "5.3"}
+        };
+        std::string headerText = header.dump();
+        std::string parentHeader = "{}";
+        std::string metadata = "{}";
+        std::string content = nlohmann::json({{"code", ""}}).dump();
+        std::string signature = key.empty() ? "" : nvrtc_sha256::hmac(key, {headerText, parentHeader, metadata, content});
+        return {"<IDS|MSG>", signature, headerText, parentHeader, metadata, content};
+    }
+}
@@ -0,0 +1,57 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_DOORBELL_HPP
+#define XMAGICS_NVRTC_DOORBELL_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <zmq.hpp>
+
+namespace xcpp
+{
+    // Wakes the shell thread of the kernel from another thread. The xeus-zmq
+    // server blocks the shell thread in a poll of its sockets until the next
+    // request, so the results of background builds would wait for the user.
+    // ring() sends a signed is_complete_request to the shell socket of the
+    // kernel itself, its handler runs the posted tasks and the reply is dropped.
+    class nvrtc_doorbell
+    {
+    public:
+
+        static nvrtc_doorbell& instance();
+
+        // connection of the kernel, as in the connection file; without it or
+        // with an unsupported signature scheme ring does nothing
+        void configure(const std::string& transport, const std::string& ip, const std::string& shellPort,
+                       const std::string& signatureScheme, const std::string& key);
+
+        // can be called from any thread
+        void ring();
+
+    private:
+
+        nvrtc_doorbell() = default;
+
+        // the delimiter and the signed frames of a request of the wire protocol
+        static std::vector<std::string> message(const std::string& key, const std::string& session);
+
+        std::mutex mutex;
+        std::string endpoint;
+        std::string key;
+        std::string session;
+        zmq::context_t context{1};
+        std::unique_ptr<zmq::socket_t> socket;
+    };
+}
+
+#endif
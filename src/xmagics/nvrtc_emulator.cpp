@@ -0,0 +1,401 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_emulator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define XCPP_CUDA_EMULATION_DECLARATIONS_ONLY
+#include "xcpp/xcuda_emulation.hpp"
+
+#include "nvrtc_api.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        using cuda::emulation::thread_state;
+
+        constexpr int CUDA_API_ERROR_INVALID_VALUE = 1;
+        constexpr int CUDA_API_ERROR_LAUNCH_FAILED = 719;
+        constexpr std::size_t MAX_BLOCK_THREADS = 1024;
+
+        void freeAligned(void* pointer)
+        {
+            std::free(pointer);
+        }
+
+        // stack of a CUDA thread of a block with barriers, the lowest page is a
+        // guard which turns an overflow into a segmentation fault
+        struct fiber
+        {
+            ucontext_t context;
+            char* stack = nullptr;
+            std::size_t stackSize = 0;
+            bool done = false;
+        };
+
+        // state of a worker thread, __shared__ variables are kept between launches
+        struct worker_state
+        {
+            std::unordered_map<std::size_t, std::unique_ptr<void, void(*)(void*)>> sharedVariables;
+            std::vector<std::max_align_t> dynamicShared;
+            std::vector<fiber> fibers;
+            std::vector<thread_state> threads;
+            ucontext_t scheduler;
+            std::size_t running = 0;
+            std::function<void(void**)>* invoke = nullptr;
+            void** arguments = nullptr;
+            bool barrier = false;
+            std::exception_ptr error;
+        };
+
+        thread_local worker_state* currentWorker = nullptr;
+        thread_local const thread_state* currentThread = nullptr;
+
+        std::size_t stackSize()
+        {
+            std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            std::size_t size = 64 * 1024;
+            if (const char* env = std::getenv("XEUS_CLING_EMULATION_STACK")) size = std::max<std::size_t>(std::strtoull(env, nullptr, 10), 4 * page);
+            return (size + page - 1) / page * page + page;
+        }
+
+        void fiberEntry()
+        {
+            worker_state& worker = *currentWorker;
+            try
+            {
+                (*worker.invoke)(worker.arguments);
+            }
+            catch (...)
+            {
+                if (!worker.error) worker.error = std::current_exception();
+            }
+            worker.fibers[worker.running].done = true;
+            //returns to the scheduler through uc_link
+        }
+
+        void runFibers(worker_state& worker, std::size_t count)
+        {
+            static const std::size_t size = stackSize();
+            while (worker.fibers.size() < count)
+            {
+                //reserved address space, pages are committed when a thread touches them
+                void* stack = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                if (stack == MAP_FAILED) throw std::runtime_error("Could not allocate the stack of an emulated thread");
+                mprotect(stack, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)), PROT_NONE);
+                worker.fibers.emplace_back();
+                worker.fibers.back().stack = static_cast<char*>(stack);
+                worker.fibers.back().stackSize = size;
+            }
+            for (std::size_t t = 0; t < count; t++)
+            {
+                fiber& f = worker.fibers[t];
+                getcontext(&f.context);
+                f.context.uc_stack.ss_sp = f.stack;
+                f.context.uc_stack.ss_size = f.stackSize;
+                f.context.uc_link = &worker.scheduler;
+                makecontext(&f.context, fiberEntry, 0);
+                f.done = false;
+            }
+
+            //each pass runs every thread to its next __syncthreads or to its end
+            std::size_t remaining = count;
+            while (remaining > 0)
+            {
+                for (std::size_t t = 0; t < count; t++)
+                {
+                    if (worker.fibers[t].done) continue;
+                    worker.running = t;
+                    currentThread = &worker.threads[t];
+                    swapcontext(&worker.scheduler, &worker.fibers[t].context);
+                    if (worker.fibers[t].done) remaining--;
+                }
+            }
+        }
+    }
+
+    namespace cuda
+    {
+        namespace emulation
+        {
+            const thread_state& current()
+            {
+                static const thread_state host = {{0, 0, 0}, {0, 0, 0}, dim3(), dim3()};
+                return currentThread != nullptr ? *currentThread : host;
+            }
+
+            void syncthreads()
+            {
+                worker_state* worker = currentWorker;
+                if (worker == nullptr || worker->threads.size() < 2) return;
+                if (!worker->barrier) throw std::logic_error("__syncthreads in a kernel which was registered without barriers");
+                swapcontext(&worker->fibers[worker->running].context, &worker->scheduler);
+            }
+
+            void* dynamic_shared()
+            {
+                return currentWorker != nullptr ? currentWorker->dynamicShared.data() : nullptr;
+            }
+
+            void* shared_variable(std::size_t id, std::size_t size, std::size_t alignment)
+            {
+                if (currentWorker == nullptr) throw std::logic_error("__shared__ variable used outside of an emulated kernel");
+                auto& variables = currentWorker->sharedVariables;
+                auto found = variables.find(id);
+                if (found != variables.end()) return found->second.get();
+                alignment = std::max(alignment, alignof(std::max_align_t));
+                void* pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+                if (pointer == nullptr) throw std::bad_alloc();
+                variables.emplace(id, std::unique_ptr<void, void(*)(void*)>(pointer, freeAligned));
+                return pointer;
+            }
+
+            CUfunction register_invoker(const std::string& name, std::function<void(void**)> invoke, bool barrier)
+            {
+                return nvrtc_emulator::instance().registerKernel(name, std::move(invoke), barrier);
+            }
+        }
+    }
+
+    nvrtc_emulator& nvrtc_emulator::instance()
+    {
+        //never destroyed, the workers wait until the process exits
+        static nvrtc_emulator* emulator = new nvrtc_emulator();
+        return *emulator;
+    }
+
+    void nvrtc_emulator::activate()
+    {
+        active = true;
+    }
+
+    bool nvrtc_emulator::isActive() const
+    {
+        return active;
+    }
+
+    std::size_t nvrtc_emulator::workerCount()
+    {
+        std::lock_guard<std::mutex> lock(launchMutex);
+        start();
+        return ranges.size();
+    }
+
+    CUfunction nvrtc_emulator::registerKernel(const std::string& name, std::function<void(void**)> invoke, bool barrier)
+    {
+        //handles of earlier registrations stay valid, cling variables may still refer to them
+        auto entry = std::make_unique<kernel_entry>(kernel_entry{name, std::move(invoke), barrier});
+        CUfunction handle = reinterpret_cast<CUfunction>(entry.get());
+        std::lock_guard<std::mutex> lock(kernelMutex);
+        kernels.emplace(handle, std::move(entry));
+        return handle;
+    }
+
+    bool nvrtc_emulator::isKernel(CUfunction function)
+    {
+        std::lock_guard<std::mutex> lock(kernelMutex);
+        return kernels.count(function) > 0;
+    }
+
+    void nvrtc_emulator::start()
+    {
+        if (!ranges.empty()) return;
+        std::size_t count = std::thread::hardware_concurrency();
+        if (const char* env = std::getenv("XEUS_CLING_EMULATION_THREADS")) count = std::strtoull(env, nullptr, 10);
+        count = std::max<std::size_t>(count, 1);
+        for (std::size_t i = 0; i < count; i++) ranges.push_back(std::make_unique<block_range>());
+
+        //the launching thread is worker 0
+        for (std::size_t i = 1; i < count; i++)
+        {
+            workers.emplace_back([this, i]()
+            {
+                std::size_t seen = 0;
+                while (true)
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        condition.wait(lock, [this, seen]() { return generation != seen; });
+                        seen = generation;
+                    }
+                    run(i);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished++;
+                    condition.notify_all();
+                }
+            });
+        }
+    }
+
+    int nvrtc_emulator::launch(CUfunction function, cuda::dim3 grid, cuda::dim3 block, unsigned int sharedMemory, void** arguments)
+    {
+        const kernel_entry* entry = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(kernelMutex);
+            auto found = kernels.find(function);
+            if (found != kernels.end()) entry = found->second.get();
+        }
+        std::size_t threads = static_cast<std::size_t>(block.x) * block.y * block.z;
+        std::size_t blocks = static_cast<std::size_t>(grid.x) * grid.y * grid.z;
+        if (entry == nullptr || threads == 0 || threads > MAX_BLOCK_THREADS || blocks == 0)
+        {
+            std::cerr << "Emulated launch: " << (entry == nullptr ? "unknown kernel handle" : "invalid grid or block size") << std::endl;
+            return CUDA_API_ERROR_INVALID_VALUE;
+        }
+
+        std::lock_guard<std::mutex> launchLock(launchMutex);
+        start();
+        kernel = entry;
+        gridSize = grid;
+        blockSize = block;
+        sharedBytes = sharedMemory;
+        gridArguments = arguments;
+        error = nullptr;
+
+        //contiguous block ranges, idle workers steal from the others
+        std::size_t count = ranges.size();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::lock_guard<std::mutex> lock(ranges[i]->mutex);
+            ranges[i]->begin = blocks * i / count;
+            ranges[i]->end = blocks * (i + 1) / count;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            generation++;
+            finished = 0;
+        }
+        condition.notify_all();
+        run(0);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return finished == workers.size(); });
+        }
+
+        if (error)
+        {
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Emulated kernel " << entry->name << ": " << e.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << "Emulated kernel " << entry->name << ": unknown exception" << std::endl;
+            }
+            return CUDA_API_ERROR_LAUNCH_FAILED;
+        }
+        return CUDA_API_SUCCESS;
+    }
+
+    bool nvrtc_emulator::nextBlock(std::size_t worker, std::size_t& block)
+    {
+        {
+            block_range& own = *ranges[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (own.begin < own.end)
+            {
+                block = own.begin++;
+                return true;
+            }
+        }
+        //steal the upper half of the first worker with blocks left, only the owner grows its range
+        for (std::size_t i = 1; i < ranges.size(); i++)
+        {
+            block_range& other = *ranges[(worker + i) % ranges.size()];
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            {
+                std::lock_guard<std::mutex> lock(other.mutex);
+                if (other.begin >= other.end) continue;
+                begin = other.begin + (other.end - other.begin) / 2;
+                end = other.end;
+                other.end = begin;
+            }
+            block_range& own = *ranges[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin + 1;
+            own.end = end;
+            block = begin;
+            return true;
+        }
+        return false;
+    }
+
+    void nvrtc_emulator::run(std::size_t worker)
+    {
+        thread_local worker_state state;
+        currentWorker = &state;
+        state.error = nullptr;
+        state.barrier = kernel->barrier;
+        state.invoke = const_cast<std::function<void(void**)>*>(&kernel->invoke);
+        state.arguments = gridArguments;
+        std::size_t sharedWords = (sharedBytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        if (state.dynamicShared.size() < sharedWords) state.dynamicShared.resize(sharedWords);
+
+        std::size_t threads = static_cast<std::size_t>(blockSize.x) * blockSize.y * blockSize.z;
+        state.threads.resize(threads);
+        for (std::size_t t = 0; t < threads; t++)
+        {
+            thread_state& thread = state.threads[t];
+            thread.threadIdx = {static_cast<unsigned int>(t % blockSize.x), static_cast<unsigned int>(t / blockSize.x % blockSize.y),
+                                static_cast<unsigned int>(t / (static_cast<std::size_t>(blockSize.x) * blockSize.y))};
+            thread.blockDim = blockSize;
+            thread.gridDim = gridSize;
+        }
+
+        std::size_t block = 0;
+        while (!state.error && nextBlock(worker, block))
+        {
+            uint3 index = {static_cast<unsigned int>(block % gridSize.x), static_cast<unsigned int>(block / gridSize.x % gridSize.y),
+                           static_cast<unsigned int>(block / (static_cast<std::size_t>(gridSize.x) * gridSize.y))};
+            for (thread_state& thread : state.threads) thread.blockIdx = index;
+            try
+            {
+                if (state.barrier && threads > 1)
+                {
+                    runFibers(state, threads);
+                }
+                else
+                {
+                    for (std::size_t t = 0; t < threads; t++)
+                    {
+                        state.running = t;
+                        currentThread = &state.threads[t];
+                        (*state.invoke)(state.arguments);
+                    }
+                }
+            }
+            catch (...)
+            {
+                if (!state.error) state.error = std::current_exception();
+            }
+        }
+        currentThread = nullptr;
+        currentWorker = nullptr;
+
+        if (state.error)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = state.error;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_EMULATOR_HPP
+#define XMAGICS_NVRTC_EMULATOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "xcpp/xcuda.hpp"
+
+namespace xcpp
+{
+    // CPU backend of %%nvrtc -emulate. Kernels are compiled by cling with the
+    // shim xcpp/xcuda_emulation.hpp and registered here, their handles are
+    // launched through xcpp::cuda::launch like the ones of the GPU.
+    //
+    // The blocks of a grid are distributed over one thread per core, a worker
+    // which finished its blocks steals the upper half of the remaining blocks
+    // of another worker. The threads of a block run on the worker one after
+    // another; kernels using __syncthreads run them as fibers which switch at
+    // the barrier.
+    class nvrtc_emulator
+    {
+    public:
+
+        static nvrtc_emulator& instance();
+
+        void activate();
+        bool isActive() const;
+        std::size_t workerCount();
+
+        CUfunction registerKernel(const std::string& name, std::function<void(void**)> invoke, bool barrier);
+        bool isKernel(CUfunction function);
+
+        // runs the grid to completion, returns a CUresult
+        int launch(CUfunction function, cuda::dim3 grid, cuda::dim3 block, unsigned int sharedMemory, void** arguments);
+
+    private:
+
+        struct kernel_entry
+        {
+            std::string name;
+            std::function<void(void**)> invoke;
+            bool barrier;
+        };
+
+        // blocks [begin, end) of a worker, the owner takes from the front, thieves from the back
+        struct block_range
+        {
+            std::mutex mutex;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+        };
+
+        nvrtc_emulator() = default;
+
+        void start();
+        void run(std::size_t worker);
+        bool nextBlock(std::size_t worker, std::size_t& block);
+        void runBlock(std::size_t block);
+
+        std::atomic<bool> active{false};
+        std::mutex kernelMutex;
+        std::unordered_map<CUfunction, std::unique_ptr<kernel_entry>> kernels;
+
+        std::mutex launchMutex;     //one grid at a time
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<block_range>> ranges;
+        std::size_t generation = 0;
+        std::size_t finished = 0;
+
+        // the current grid
+        const kernel_entry* kernel = nullptr;
+        cuda::dim3 gridSize;
+        cuda::dim3 blockSize;
+        unsigned int sharedBytes = 0;
+        void** gridArguments = nullptr;
+        std::exception_ptr error;
+    };
+}
+
+#endif
@@ -0,0 +1,182 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_graph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+#include "cling/Interpreter/Value.h"
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_emulator.hpp"
+#include "nvrtc_session.hpp"
+#include "nvrtc_streams.hpp"
+
+namespace nl = nlohmann;
+
+#define ERROR_CODE -1
+#define SUCCESS 0
+
+namespace xcpp
+{
+    void nvrtc_graph::operator()(const std::string& line, const std::string& cell)
+    {
+        if(SUCCESS!=getOptions(line)) return;
+        if(nvrtc_emulator::instance().isActive())
+        {
+            std::cerr << "%%cuda_graph is not available with -emulate" << std::endl;
+            return;
+        }
+        int devices = nvrtc_stream_pool::instance().deviceCount();
+        if(devices==0)
+        {
+            std::cerr << "Run a %%nvrtc cell before %%cuda_graph" << std::endl;
+            return;
+        }
+        if(device>=devices)
+        {
+            std::cerr << "No CUDA device " << device << std::endl;
+            return;
+        }
+        nvrtc_api& api = nvrtc_api::instance();
+        if(!api.hasGraphs())
+        {
+            std::cerr << "The CUDA driver does not support graphs, CUDA 11.4 or newer is needed" << std::endl;
+            return;
+        }
+        if(SUCCESS!=declareGraph(graphName)) return;
+
+        //an unchanged cell is only replayed, the parameters of the last capture are used
+        graph_cell& entry = graphs[graphName];
+        std::string action = "replayed";
+        if(forceUpdate || !entry.graph->ready() || entry.code != cell)
+        {
+            std::size_t instantiations = entry.graph->statistics().instantiations;
+            if(SUCCESS!=captureGraph(graphName, cell)) return;
+            entry.code = cell;
+            action = entry.graph->statistics().instantiations > instantiations ? "captured and instantiated" : "captured and updated in place";
+        }
+
+        //the capture only recorded the launches, the graph runs them
+        auto start = std::chrono::steady_clock::now();
+        int result = CUDA_API_SUCCESS;
+        for (int i = 0; i < repeat && result == CUDA_API_SUCCESS; i++) result = entry.graph->launch();
+        std::chrono::duration<double, std::micro> launches = std::chrono::steady_clock::now() - start;
+        if(result==CUDA_API_SUCCESS) result = entry.graph->synchronize();
+        if(result!=CUDA_API_SUCCESS)
+        {
+            std::cerr << "CUDA Error: graph " << graphName << ": " << api.cudaError(result) << std::endl;
+            return;
+        }
+        report(graphName, action, launches.count() / repeat);
+    }
+
+    int nvrtc_graph::getOptions(const std::string& line)
+    {
+        //the graph on another device than 0
+        std::smatch match;
+        std::regex deviceOption(R"(-device\s+(\d+))");
+        device = std::regex_search(line, match, deviceOption) ? std::stoi(match[1].str()) : 0;
+        //number of replays of the cell
+        std::regex repeatOption(R"(-repeat\s+(\d+))");
+        repeat = std::regex_search(line, match, repeatOption) ? std::max(1, std::stoi(match[1].str())) : 1;
+        //capture again although the cell did not change, e.g. for new values of host variables
+        std::regex updateOption(R"(-update(\s|$))");
+        forceUpdate = std::regex_search(line, updateOption);
+
+        //the name is the word which is no option or option value
+        std::string clean = std::regex_replace(line, std::regex(R"(-(device|repeat)\s+\d+|-update(\s|$))"), " ");
+        std::istringstream words(clean);
+        graphName.clear();
+        words >> graphName;
+        if(!std::regex_match(graphName, std::regex(R"([A-Za-z_]\w*)")))
+        {
+            std::cerr << "Usage: %%cuda_graph name [-device N] [-repeat N] [-update]" << std::endl;
+            return ERROR_CODE;
+        }
+        return SUCCESS;
+    }
+
+    int nvrtc_graph::declareGraph(const std::string& name)
+    {
+        auto found = graphs.find(name);
+        if(found != graphs.end())
+        {
+            if(found->second.graph->device() != device)
+            {
+                std::cerr << "Graph " << name << " keeps device " << found->second.graph->device() << " of its declaration" << std::endl;
+            }
+            return SUCCESS;
+        }
+
+        //the variable can be launched from host code, e.g. in a loop
+        if(m_interpreter.declare("xcpp::cuda::graph " + name + "(" + std::to_string(device) + ");")!=cling::Interpreter::CompilationResult::kSuccess)
+        {
+            std::cerr << "Could not declare graph: " << name << std::endl;
+            return ERROR_CODE;
+        }
+        cling::Value output;
+        if(m_interpreter.process("(void*)&" + name + ";", &output)!=cling::Interpreter::CompilationResult::kSuccess
+           || output.getPtr() == nullptr)
+        {
+            std::cerr << "Could not find graph: " << name << std::endl;
+            return ERROR_CODE;
+        }
+        graphs[name].graph = static_cast<cuda::graph*>(output.getPtr());
+        return SUCCESS;
+    }
+
+    int nvrtc_graph::captureGraph(const std::string& name, const std::string& cell)
+    {
+        //the cell is the body of the capture, the capture stream is available as stream
+        nvrtc_session::instance().prepareHostCell(cell);
+        std::string input = "(long long)" + name + ".capture([&](CUstream stream) {\n" + cell + "\n});";
+        cling::Value output;
+        if(m_interpreter.process(input, &output)!=cling::Interpreter::CompilationResult::kSuccess || !output.hasValue())
+        {
+            std::cerr << "Could not capture graph: " << name << std::endl;
+            return ERROR_CODE;
+        }
+        int result = static_cast<int>(output.getLL());
+        if(result!=CUDA_API_SUCCESS)
+        {
+            std::cerr << "CUDA Error: capture of graph " << name << ": " << nvrtc_api::instance().cudaError(result) << std::endl;
+            return ERROR_CODE;
+        }
+        return SUCCESS;
+    }
+
+    void nvrtc_graph::report(const std::string& name, const std::string& action, double replayMicroseconds)
+    {
+        //the launch calls of the capture cost about as much host time as launching the kernels one by one
+        cuda::graph_statistics statistics = graphs[name].graph->statistics();
+        std::cout << "Graph " << name << ": " << statistics.nodes << " nodes, " << action << ", "
+                  << repeat << (repeat == 1 ? " launch" : " launches") << std::endl;
+        std::cout << std::fixed << std::setprecision(1)
+                  << "Host time per replay: " << replayMicroseconds << " us for the graph, "
+                  << statistics.capture_us << " us for the launch calls of the last capture" << std::endl;
+
+        nl::json graph = {
+            {"name", name},
+            {"nodes", statistics.nodes},
+            {"action", action},
+            {"launches", repeat},
+            {"launch_us", replayMicroseconds},
+            {"capture_us", statistics.capture_us},
+            {"instantiations", statistics.instantiations},
+            {"updates", statistics.updates}
+        };
+        nvrtc_session::instance().setReplyMetadata(nl::json::object({{"nvrtc", {{"graph", graph}}}}));
+    }
+}
@@ -0,0 +1,56 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_GRAPH_HPP
+#define XMAGICS_NVRTC_GRAPH_HPP
+
+#include <string>
+#include <unordered_map>
+
+#include "cling/Interpreter/Interpreter.h"
+#include "xeus-cling/xmagics.hpp"
+
+#include "xcpp/xcuda.hpp"
+
+namespace xcpp
+{
+    // %%cuda_graph name captures the launches of the cell into the
+    // xcpp::cuda::graph variable name and replays it. The cell is captured
+    // again when its code changed or with -update; the executable graph is
+    // then updated in place.
+    class nvrtc_graph: public xmagic_cell
+    {
+    public:
+
+        nvrtc_graph(cling::Interpreter& i) : m_interpreter(i){}
+        virtual void operator()(const std::string& line, const std::string& cell) override;
+
+    private:
+
+        struct graph_cell
+        {
+            cuda::graph* graph = nullptr;   //the variable in the cling session
+            std::string code;               //code of the last capture
+        };
+
+        int getOptions(const std::string& line);
+        int declareGraph(const std::string& name);
+        int captureGraph(const std::string& name, const std::string& cell);
+        void report(const std::string& name, const std::string& action, double replayMicroseconds);
+
+        cling::Interpreter& m_interpreter;
+        std::unordered_map<std::string, graph_cell> graphs;
+        std::string graphName;
+        int device=0;
+        int repeat=1;
+        bool forceUpdate=false;
+    };
+}
+
+#endif
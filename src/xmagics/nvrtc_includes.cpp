@@ -0,0 +1,101 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_includes.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+namespace xcpp
+{
+    void nvrtc_include_resolver::setSearchPaths(const std::vector<std::string>& paths)
+    {
+        searchPaths.clear();
+        for (std::string path : paths)
+        {
+            if (path.empty()) continue;
+            if (path.back() != '/') path += "/";
+            searchPaths.push_back(path);
+        }
+    }
+
+    void nvrtc_include_resolver::resolve(const std::string& code, std::vector<std::string>& names, std::vector<std::string>& contents)
+    {
+        std::unordered_set<std::string> seen;
+        collect(scanSource(code).includes, "", seen, names, contents);    //the cell is relative to the working directory
+    }
+
+    void nvrtc_include_resolver::collect(const std::vector<nvrtc_include>& includes, const std::string& directory,
+                                         std::unordered_set<std::string>& seen, std::vector<std::string>& names, std::vector<std::string>& contents)
+    {
+        for (const nvrtc_include& include : includes)
+        {
+            //NVRTC matches headers by the name in the directive, the first one wins
+            if (!seen.insert(include.name).second) continue;
+
+            std::string path = find(include, directory);
+            if (path.empty()) continue;
+            const header* h = load(path);
+            if (h == nullptr) continue;
+
+            names.push_back(include.name);
+            contents.push_back(h->content);
+            collect(h->includes, h->directory, seen, names, contents);
+        }
+    }
+
+    std::string nvrtc_include_resolver::find(const nvrtc_include& include, const std::string& directory) const
+    {
+        struct stat info;
+        auto exists = [&info](const std::string& path) { return ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode); };
+
+        if (!include.name.empty() && include.name.front() == '/') return exists(include.name) ? include.name : "";
+        if (include.quoted && exists(directory + include.name)) return directory + include.name;
+        for (const std::string& path : searchPaths)
+        {
+            if (exists(path + include.name)) return path + include.name;
+        }
+        if (!include.quoted && exists(include.name)) return include.name;
+        return "";
+    }
+
+    const nvrtc_include_resolver::header* nvrtc_include_resolver::load(const std::string& path)
+    {
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0) return nullptr;
+
+        header& h = headers[path];
+        if (h.device == static_cast<unsigned long long>(info.st_dev) && h.inode == static_cast<unsigned long long>(info.st_ino)
+            && h.size == static_cast<long long>(info.st_size)
+            && h.modified.tv_sec == info.st_mtim.tv_sec && h.modified.tv_nsec == info.st_mtim.tv_nsec)
+        {
+            return &h;  //unchanged file
+        }
+
+        std::ifstream file(path);
+        if (!file)
+        {
+            headers.erase(path);
+            return nullptr;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+
+        h.device = static_cast<unsigned long long>(info.st_dev);
+        h.inode = static_cast<unsigned long long>(info.st_ino);
+        h.size = static_cast<long long>(info.st_size);
+        h.modified = info.st_mtim;
+        h.directory = path.substr(0, path.find_last_of('/') + 1);
+        h.content = buffer.str();
+        h.includes = scanSource(h.content).includes;
+        return &h;
+    }
+}
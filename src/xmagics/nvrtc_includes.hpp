@@ -0,0 +1,64 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_INCLUDES_HPP
+#define XMAGICS_NVRTC_INCLUDES_HPP
+
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "nvrtc_lexer.hpp"
+
+namespace xcpp
+{
+    // Resolves the #include directives of a cell to files and collects the
+    // headers which are passed to NVRTC. The content and the directives of
+    // every header are cached, an entry is only read and scanned again when
+    // device, inode, size or modification time of the file changed.
+    //
+    // "" includes are searched relative to the including file, then in the
+    // search paths. <> includes are searched in the search paths, then in the
+    // working directory. Headers which are not found are left to NVRTC, e.g.
+    // its builtin headers.
+    class nvrtc_include_resolver
+    {
+    public:
+
+        void setSearchPaths(const std::vector<std::string>& paths);
+
+        // headers of the code and all nested headers, each include name once
+        void resolve(const std::string& code, std::vector<std::string>& names, std::vector<std::string>& contents);
+
+    private:
+
+        struct header
+        {
+            unsigned long long device = 0;
+            unsigned long long inode = 0;
+            long long size = -1;
+            std::timespec modified{};
+            std::string directory;
+            std::string content;
+            std::vector<nvrtc_include> includes;
+        };
+
+        const header* load(const std::string& path);
+        std::string find(const nvrtc_include& include, const std::string& directory) const;
+        void collect(const std::vector<nvrtc_include>& includes, const std::string& directory,
+                     std::unordered_set<std::string>& seen, std::vector<std::string>& names, std::vector<std::string>& contents);
+
+        std::vector<std::string> searchPaths;
+        std::unordered_map<std::string, header> headers;    //path to cached header
+    };
+}
+
+#endif
@@ -0,0 +1,280 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_lexer.hpp"
+
+#include <cctype>
+
+namespace xcpp
+{
+    namespace
+    {
+        bool isIdentifierStart(char c)
+        {
+            return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+        }
+
+        bool isIdentifierChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        }
+
+        // Every input character produces exactly one output character, comments
+        // are replaced by spaces. Offsets and lines are therefore the same in
+        // the input and in the stripped code.
+        class lexer
+        {
+        public:
+
+            explicit lexer(const std::string& code)
+                : in(code)
+            {
+                out.code.reserve(in.size());
+                out.lineOffsets.push_back(0);
+            }
+
+            nvrtc_source run()
+            {
+                while (pos < in.size())
+                {
+                    char c = in[pos];
+                    char next = peek(1);
+                    if (c == '\n')
+                    {
+                        copy();
+                        lineStart = true;
+                        inDirective = false;
+                    }
+                    else if (c == '\\' && next == '\n')    //line splice, the directive continues
+                    {
+                        copy();
+                        copy();
+                    }
+                    else if (c == '/' && next == '/') lineComment();
+                    else if (c == '/' && next == '*') blockComment();
+                    else if (std::isspace(static_cast<unsigned char>(c))) copy();
+                    else if (c == '#' && lineStart) directive();
+                    else
+                    {
+                        lineStart = false;
+                        if (c == '"') stringLiteral('"');
+                        else if (c == '\'') stringLiteral('\'');
+                        else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && std::isdigit(static_cast<unsigned char>(next)))) number();
+                        else if (isIdentifierStart(c)) identifier();
+                        else punctuation(c);
+                    }
+                }
+                return std::move(out);
+            }
+
+        private:
+
+            enum class kernel_state { none, declaration, attribute, parameters, body };
+
+            char peek(std::size_t offset) const
+            {
+                return pos + offset < in.size() ? in[pos + offset] : '\0';
+            }
+
+            void copy()
+            {
+                put(in[pos]);
+            }
+
+            void blank()
+            {
+                put(in[pos] == '\n' ? '\n' : ' ');
+            }
+
+            void put(char c)
+            {
+                out.code.push_back(c);
+                if (in[pos++] == '\n')
+                {
+                    line++;
+                    out.lineOffsets.push_back(pos);
+                }
+            }
+
+            void lineComment()
+            {
+                while (pos < in.size() && in[pos] != '\n')
+                {
+                    if (in[pos] == '\\' && peek(1) == '\n') blank(); //the comment continues on the next line
+                    blank();
+                }
+            }
+
+            void blockComment()
+            {
+                std::size_t end = in.find("*/", pos + 2);
+                end = end == std::string::npos ? in.size() : end + 2;
+                while (pos < end) blank();
+            }
+
+            void stringLiteral(char quote)
+            {
+                copy();
+                while (pos < in.size() && in[pos] != quote && in[pos] != '\n')
+                {
+                    if (in[pos] == '\\' && pos + 1 < in.size()) copy();
+                    copy();
+                }
+                if (pos < in.size() && in[pos] == quote) copy();
+            }
+
+            void rawStringLiteral()
+            {
+                //R"delimiter( ... )delimiter"
+                copy();
+                std::size_t open = in.find('(', pos);
+                if (open == std::string::npos) return;
+                std::string terminator = ")" + in.substr(pos, open - pos) + "\"";
+                std::size_t end = in.find(terminator, open);
+                end = end == std::string::npos ? in.size() : end + terminator.size();
+                while (pos < end) copy();
+            }
+
+            void number()
+            {
+                //pp-number, the ' digit separator is not a character literal
+                while (pos < in.size())
+                {
+                    char c = in[pos];
+                    if ((c == '+' || c == '-') && pos > 0 && (in[pos - 1] == 'e' || in[pos - 1] == 'E' || in[pos - 1] == 'p' || in[pos - 1] == 'P')) copy();
+                    else if (isIdentifierChar(c) || c == '.' || (c == '\'' && isIdentifierChar(peek(1)))) copy();
+                    else break;
+                }
+            }
+
+            void identifier()
+            {
+                std::size_t start = pos;
+                while (pos < in.size() && isIdentifierChar(in[pos])) copy();
+                std::string word = in.substr(start, pos - start);
+
+                if (pos < in.size() && in[pos] == '"' && (word == "R" || word == "LR" || word == "uR" || word == "UR" || word == "u8R"))
+                {
+                    rawStringLiteral();
+                    return;
+                }
+                if (inDirective) return;
+
+                if (word == "template") templateDeclaration = true;
+                else if (word == "__global__" || (word == "__device__" && kernel == kernel_state::none))
+                {
+                    kernel = kernel_state::declaration;
+                    kernelGlobal = word == "__global__";
+                    kernelTemplate = templateDeclaration;
+                    kernelLine = line;
+                    lastIdentifier.clear();
+                }
+                else if (kernel == kernel_state::declaration) lastIdentifier = word;
+            }
+
+            void directive()
+            {
+                inDirective = true;
+                lineStart = false;
+                copy();     //#
+                while (pos < in.size() && (in[pos] == ' ' || in[pos] == '\t')) copy();
+                std::size_t start = pos;
+                while (pos < in.size() && isIdentifierChar(in[pos])) copy();
+                if (in.compare(start, pos - start, "include") != 0) return;
+
+                while (pos < in.size() && (in[pos] == ' ' || in[pos] == '\t')) copy();
+                char close = peek(0) == '<' ? '>' : (peek(0) == '"' ? '"' : '\0');
+                if (close == '\0') return;  //macro include, left to NVRTC
+                std::size_t includeLine = line;
+                copy();
+                start = pos;
+                while (pos < in.size() && in[pos] != close && in[pos] != '\n') copy();
+                if (pos < in.size() && in[pos] == close)
+                {
+                    out.includes.push_back({in.substr(start, pos - start), close == '"', includeLine});
+                    copy();
+                }
+            }
+
+            void punctuation(char c)
+            {
+                copy();
+                if (inDirective) return;
+
+                if (c == ';' || c == '{' || c == '}')
+                {
+                    templateDeclaration = false;
+                    //a __device__ function is defined if its parameters are followed by a body
+                    if (kernel == kernel_state::body && c == '{') out.deviceFunctions.push_back(lastIdentifier);
+                    if (kernel == kernel_state::declaration || kernel == kernel_state::body) kernel = kernel_state::none;
+                }
+                if (kernel == kernel_state::declaration && c == '(')
+                {
+                    //attributes like __launch_bounds__(256) are between __global__ and the name
+                    if (lastIdentifier == "__launch_bounds__" || lastIdentifier == "__attribute__" || lastIdentifier == "__declspec" || lastIdentifier == "alignas")
+                    {
+                        kernel = kernel_state::attribute;
+                    }
+                    else
+                    {
+                        kernel = kernel_state::parameters;
+                        parametersStart = pos;
+                    }
+                    depth = 1;
+                }
+                else if ((kernel == kernel_state::attribute || kernel == kernel_state::parameters) && c == '(') depth++;
+                else if ((kernel == kernel_state::attribute || kernel == kernel_state::parameters) && c == ')' && --depth == 0)
+                {
+                    if (kernel == kernel_state::attribute)
+                    {
+                        kernel = kernel_state::declaration;
+                        lastIdentifier.clear();
+                        return;
+                    }
+                    if (!lastIdentifier.empty() && !kernelGlobal)
+                    {
+                        kernel = kernel_state::body;
+                        return;
+                    }
+                    if (!lastIdentifier.empty())
+                    {
+                        std::string parameters = out.code.substr(parametersStart, pos - 1 - parametersStart);
+                        std::size_t first = parameters.find_first_not_of(" \t\r\n");
+                        std::size_t last = parameters.find_last_not_of(" \t\r\n");
+                        parameters = first == std::string::npos ? "" : parameters.substr(first, last - first + 1);
+                        out.kernels.push_back({lastIdentifier, parameters, kernelTemplate, kernelLine});
+                    }
+                    kernel = kernel_state::none;
+                }
+            }
+
+            const std::string& in;
+            std::size_t pos = 0;
+            std::size_t line = 1;
+            nvrtc_source out;
+
+            bool lineStart = true;      //only whitespace and comments since the last newline
+            bool inDirective = false;
+            bool templateDeclaration = false;
+
+            kernel_state kernel = kernel_state::none;
+            bool kernelGlobal = false;
+            bool kernelTemplate = false;
+            std::size_t kernelLine = 0;
+            std::size_t parametersStart = 0;
+            int depth = 0;
+            std::string lastIdentifier;
+        };
+    }
+
+    nvrtc_source scanSource(const std::string& code)
+    {
+        return lexer(code).run();
+    }
+}
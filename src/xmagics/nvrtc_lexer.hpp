@@ -0,0 +1,51 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_LEXER_HPP
+#define XMAGICS_NVRTC_LEXER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace xcpp
+{
+    // one #include directive, quoted is true for the "" notation
+    struct nvrtc_include
+    {
+        std::string name;
+        bool quoted;
+        std::size_t line;
+    };
+
+    // a __global__ function declaration or definition
+    struct nvrtc_kernel_declaration
+    {
+        std::string name;
+        std::string parameters;     //text between the parentheses, without comments
+        bool isTemplate;
+        std::size_t line;
+    };
+
+    struct nvrtc_source
+    {
+        std::string code;                           //source with comments replaced by spaces, newlines are kept
+        std::vector<std::size_t> lineOffsets;       //offset of the first character of each line
+        std::vector<nvrtc_include> includes;
+        std::vector<nvrtc_kernel_declaration> kernels;
+        std::vector<std::string> deviceFunctions;   //names of __device__ function definitions, not prototypes
+    };
+
+    // Scans CUDA source in one linear pass. Comments, string, character and raw
+    // string literals are recognized, so their content is never taken as an
+    // include directive or a kernel declaration. Lines start at 1.
+    nvrtc_source scanSource(const std::string& code);
+}
+
+#endif
@@ -0,0 +1,144 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_link.hpp"
+
+#include <algorithm>
+
+#include "nvrtc_api.hpp"
+
+#define ERROR_CODE -1
+#define SUCCESS 0
+
+namespace xcpp
+{
+    namespace
+    {
+        // owns an nvJitLinkHandle, destroyed on every return
+        class linker
+        {
+        public:
+
+            explicit linker(nvjitlink_functions& functions)
+                : f(functions)
+            {
+            }
+
+            ~linker()
+            {
+                if (handle != nullptr) f.nvJitLinkDestroy(&handle);
+            }
+
+            linker(const linker&) = delete;
+            linker& operator=(const linker&) = delete;
+
+            std::string errorLog() const
+            {
+                std::size_t size = 0;
+                if (handle == nullptr || f.nvJitLinkGetErrorLogSize(handle, &size) != NVJITLINK_API_SUCCESS || size <= 1) return "";
+                std::string log(size, '\0');
+                f.nvJitLinkGetErrorLog(handle, &log[0]);
+                log.resize(size - 1);   //terminating null character
+                return log;
+            }
+
+            nvjitlink_functions& f;
+            nvJitLinkHandle handle = nullptr;
+        };
+    }
+
+    std::vector<nvrtc_link_unit> nvrtc_link_set::with(const nvrtc_link_unit& unit)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<nvrtc_link_unit> result = replaced(unit);
+        result.push_back(unit);
+        return result;
+    }
+
+    void nvrtc_link_set::add(const nvrtc_link_unit& unit)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        units = replaced(unit);
+        units.push_back(unit);
+    }
+
+    std::size_t nvrtc_link_set::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return units.size();
+    }
+
+    std::vector<nvrtc_link_unit> nvrtc_link_set::replaced(const nvrtc_link_unit& unit) const
+    {
+        //units sharing a symbol with the new one are older versions of the same cell
+        std::vector<nvrtc_link_unit> result;
+        for (const nvrtc_link_unit& u : units)
+        {
+            bool shared = std::any_of(u.symbols.begin(), u.symbols.end(), [&unit](const std::string& symbol)
+            {
+                return std::find(unit.symbols.begin(), unit.symbols.end(), symbol) != unit.symbols.end();
+            });
+            if (!shared) result.push_back(u);
+        }
+        return result;
+    }
+
+    int linkUnits(const std::vector<nvrtc_link_unit>& units, const std::string& architecture, std::string& cubin, std::string& errors)
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+        if (SUCCESS != api.loadNVJitLink())
+        {
+            errors += "-rdc needs libnvJitLink\n";
+            return ERROR_CODE;
+        }
+
+        std::string archOption = "-arch=" + architecture;
+        const char* options[] = {archOption.c_str(), "-lto"};
+        linker link(api.nvjitlink);
+        int result = api.nvjitlink.nvJitLinkCreate(&link.handle, 2, options);
+        if (result != NVJITLINK_API_SUCCESS)
+        {
+            link.handle = nullptr;
+            errors += "nvJitLink Error: could not create a linker for " + architecture + " (" + std::to_string(result) + ")\n";
+            return ERROR_CODE;
+        }
+
+        for (std::size_t i = 0; i < units.size(); i++)
+        {
+            auto ir = units[i].ltoir.find(architecture);
+            std::string name = "cell_" + std::to_string(i) + (units[i].symbols.empty() ? "" : "_" + units[i].symbols.front());
+            if (ir == units[i].ltoir.end())
+            {
+                errors += "nvJitLink Error: " + name + " was not compiled for " + architecture + ", run the cell again\n";
+                return ERROR_CODE;
+            }
+            result = api.nvjitlink.nvJitLinkAddData(link.handle, NVJITLINK_API_INPUT_LTOIR, ir->second.data(), ir->second.size(), name.c_str());
+            if (result != NVJITLINK_API_SUCCESS)
+            {
+                errors += "nvJitLink Error: " + name + "\n" + link.errorLog() + "\n";
+                return ERROR_CODE;
+            }
+        }
+
+        result = api.nvjitlink.nvJitLinkComplete(link.handle);
+        std::size_t size = 0;
+        if (result == NVJITLINK_API_SUCCESS) result = api.nvjitlink.nvJitLinkGetLinkedCubinSize(link.handle, &size);
+        if (result == NVJITLINK_API_SUCCESS)
+        {
+            cubin.assign(size, '\0');
+            result = api.nvjitlink.nvJitLinkGetLinkedCubin(link.handle, &cubin[0]);
+        }
+        if (result != NVJITLINK_API_SUCCESS)
+        {
+            errors += "nvJitLink Error:\n" + link.errorLog() + "\n";
+            return ERROR_CODE;
+        }
+        return SUCCESS;
+    }
+}
@@ -0,0 +1,56 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_LINK_HPP
+#define XMAGICS_NVRTC_LINK_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xcpp
+{
+    // one cell compiled with -rdc, the LTO-IR per link architecture (e.g. sm_80)
+    struct nvrtc_link_unit
+    {
+        std::vector<std::string> symbols;   //kernels and __device__ functions defined by the cell
+        std::vector<std::string> kernels;
+        std::unordered_map<std::string, std::string> ltoir;
+        std::unordered_map<std::string, std::string> keys;     //cache key of the LTO-IR per architecture
+        std::unordered_map<std::string, std::string> expressions;  //lowered name to -instantiate name expression
+    };
+
+    // The -rdc cells of the session. A cell replaces the cells which define one
+    // of its symbols, so a changed cell is linked instead of its old version.
+    class nvrtc_link_set
+    {
+    public:
+
+        // the units of the set if unit is added, the set itself is not changed
+        std::vector<nvrtc_link_unit> with(const nvrtc_link_unit& unit);
+        void add(const nvrtc_link_unit& unit);     //after the link succeeded
+
+        std::size_t size();
+
+    private:
+
+        std::vector<nvrtc_link_unit> replaced(const nvrtc_link_unit& unit) const;
+
+        std::mutex mutex;
+        std::vector<nvrtc_link_unit> units;
+    };
+
+    // Links the LTO-IR of the units for a real architecture with nvJitLink,
+    // link time optimization runs across all units. Returns SUCCESS or ERROR_CODE.
+    int linkUnits(const std::vector<nvrtc_link_unit>& units, const std::string& architecture, std::string& cubin, std::string& errors);
+}
+
+#endif
@@ -0,0 +1,211 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_memory.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_streams.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        constexpr std::size_t MIN_BLOCK_SIZE = 256;
+        constexpr std::size_t POWER_OF_TWO_LIMIT = std::size_t(32) << 20;
+        constexpr std::size_t LARGE_BLOCK_GRANULARITY = std::size_t(2) << 20;
+
+        // the context of the device is current while the object lives
+        class context_scope
+        {
+        public:
+
+            explicit context_scope(int device)
+            {
+                result = nvrtc_api::instance().cuda.cuCtxPushCurrent(nvrtc_stream_pool::instance().context(device));
+            }
+
+            ~context_scope()
+            {
+                CUcontext previous = nullptr;
+                if (result == CUDA_API_SUCCESS) nvrtc_api::instance().cuda.cuCtxPopCurrent(&previous);
+            }
+
+            context_scope(const context_scope&) = delete;
+            context_scope& operator=(const context_scope&) = delete;
+
+            int result;
+        };
+    }
+
+    nvrtc_memory_pool& nvrtc_memory_pool::instance()
+    {
+        //never destroyed, like the stream pool, the blocks belong to the contexts
+        static nvrtc_memory_pool* pool = new nvrtc_memory_pool();
+        return *pool;
+    }
+
+    std::size_t nvrtc_memory_pool::sizeClass(std::size_t bytes)
+    {
+        if (bytes > POWER_OF_TWO_LIMIT) return (bytes + LARGE_BLOCK_GRANULARITY - 1) / LARGE_BLOCK_GRANULARITY * LARGE_BLOCK_GRANULARITY;
+        std::size_t size = MIN_BLOCK_SIZE;
+        while (size < bytes) size <<= 1;
+        return size;
+    }
+
+    CUdeviceptr nvrtc_memory_pool::allocateDevice(int device, std::size_t bytes, CUstream stream)
+    {
+        std::size_t size = sizeClass(bytes);
+        context_scope scope(device);    //throws for unknown devices
+        nvrtc_api& api = nvrtc_api::instance();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (deviceBlocks.size() <= static_cast<std::size_t>(device)) deviceBlocks.resize(device + 1);
+        stats.allocations++;
+
+        //a block of the same stream or one which is idle since the last synchronization,
+        //the null stream does not order against the non-blocking streams of the pool
+        std::vector<device_block>& blocks = deviceBlocks[device][size];
+        auto block = std::find_if(blocks.begin(), blocks.end(), [stream](const device_block& b) { return b.synchronized || (stream != nullptr && b.stream == stream); });
+        if (block != blocks.end())
+        {
+            CUdeviceptr pointer = block->pointer;
+            blocks.erase(block);
+            stats.cache_hits++;
+            stats.bytes_cached -= size;
+            stats.bytes_in_use += size;
+            stats.peak_bytes_in_use = std::max(stats.peak_bytes_in_use, stats.bytes_in_use);
+            return pointer;
+        }
+
+        if (scope.result != CUDA_API_SUCCESS) throw std::runtime_error("Could not activate CUDA device " + std::to_string(device) + ": " + api.cudaError(scope.result));
+        CUdeviceptr pointer = 0;
+        int result = api.cuda.cuMemAlloc(&pointer, size);
+        if (result == CUDA_API_ERROR_OUT_OF_MEMORY)
+        {
+            //the cached blocks of other size classes may be enough
+            releaseCached(device);
+            result = api.cuda.cuMemAlloc(&pointer, size);
+        }
+        if (result != CUDA_API_SUCCESS)
+        {
+            throw std::runtime_error("Could not allocate " + std::to_string(bytes) + " bytes on CUDA device " + std::to_string(device) + ": " + api.cudaError(result));
+        }
+        stats.driver_allocations++;
+        stats.bytes_in_use += size;
+        stats.peak_bytes_in_use = std::max(stats.peak_bytes_in_use, stats.bytes_in_use);
+        return pointer;
+    }
+
+    void nvrtc_memory_pool::freeDevice(int device, CUdeviceptr pointer, std::size_t bytes, CUstream stream)
+    {
+        std::size_t size = sizeClass(bytes);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (deviceBlocks.size() <= static_cast<std::size_t>(device)) deviceBlocks.resize(device + 1);
+        deviceBlocks[device][size].push_back({pointer, stream, false});
+        stats.bytes_in_use -= size;
+        stats.bytes_cached += size;
+    }
+
+    void* nvrtc_memory_pool::allocateHost(std::size_t bytes)
+    {
+        std::size_t size = sizeClass(bytes);
+        nvrtc_api& api = nvrtc_api::instance();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            //only blocks without pending asynchronous copies
+            std::vector<host_block>& blocks = hostBlocks[size];
+            auto block = std::find_if(blocks.begin(), blocks.end(), [](const host_block& b) { return b.synchronized; });
+            if (block != blocks.end())
+            {
+                void* pointer = block->pointer;
+                blocks.erase(block);
+                stats.host_bytes_cached -= size;
+                stats.host_bytes_in_use += size;
+                return pointer;
+            }
+        }
+
+        //portable memory is pinned for all contexts
+        context_scope scope(0);
+        void* pointer = nullptr;
+        int result = scope.result == CUDA_API_SUCCESS ? api.cuda.cuMemHostAlloc(&pointer, size, CU_MEMHOSTALLOC_API_PORTABLE) : scope.result;
+        if (result != CUDA_API_SUCCESS)
+        {
+            throw std::runtime_error("Could not allocate " + std::to_string(bytes) + " bytes of pinned host memory: " + api.cudaError(result));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.host_bytes_in_use += size;
+        return pointer;
+    }
+
+    void nvrtc_memory_pool::freeHost(void* pointer, std::size_t bytes, CUstream stream)
+    {
+        std::size_t size = sizeClass(bytes);
+        std::lock_guard<std::mutex> lock(mutex);
+        hostBlocks[size].push_back({pointer, stream == nullptr});
+        stats.host_bytes_in_use -= size;
+        stats.host_bytes_cached += size;
+    }
+
+    void nvrtc_memory_pool::markSynchronized()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& device : deviceBlocks)
+        {
+            for (auto& blocks : device)
+            {
+                for (device_block& block : blocks.second) block.synchronized = true;
+            }
+        }
+        for (auto& blocks : hostBlocks)
+        {
+            for (host_block& block : blocks.second) block.synchronized = true;
+        }
+    }
+
+    void nvrtc_memory_pool::releaseCached()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t device = 0; device < deviceBlocks.size(); device++)
+        {
+            context_scope scope(static_cast<int>(device));
+            releaseCached(static_cast<int>(device));
+        }
+
+        nvrtc_api& api = nvrtc_api::instance();
+        for (auto& blocks : hostBlocks)
+        {
+            for (const host_block& block : blocks.second) api.cuda.cuMemFreeHost(block.pointer);
+            stats.host_bytes_cached -= blocks.first * blocks.second.size();
+        }
+        hostBlocks.clear();
+    }
+
+    void nvrtc_memory_pool::releaseCached(int device)
+    {
+        //cuMemFree waits for the work using the block, also for unsynchronized blocks
+        nvrtc_api& api = nvrtc_api::instance();
+        for (auto& blocks : deviceBlocks[device])
+        {
+            for (const device_block& block : blocks.second) api.cuda.cuMemFree(block.pointer);
+            stats.bytes_cached -= blocks.first * blocks.second.size();
+        }
+        deviceBlocks[device].clear();
+    }
+
+    cuda::memory_statistics nvrtc_memory_pool::statistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+}
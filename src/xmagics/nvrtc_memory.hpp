@@ -0,0 +1,80 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_MEMORY_HPP
+#define XMAGICS_NVRTC_MEMORY_HPP
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "xcpp/xcuda.hpp"
+
+namespace xcpp
+{
+    // Caching allocator for device memory per context and pinned host memory.
+    // Requests are rounded to a size class: powers of two up to 32 MB, larger
+    // blocks to multiples of 2 MB. Freed blocks are kept in a free list of their
+    // class instead of being returned to the driver.
+    //
+    // A freed device block can be used again at once on the stream it was freed
+    // on, stream order protects the previous work. Other streams get it after
+    // the next synchronizeAll of the stream pool, and so do blocks freed without
+    // a stream: the pool streams are non-blocking, a kernel on one of them may
+    // still use the block. A pinned host block freed on a
+    // stream waits for the synchronization also for that stream, the host may
+    // write it before the pending copies have read it. Blocks freed without a
+    // stream were only used by synchronous copies and can be used at once.
+    class nvrtc_memory_pool
+    {
+    public:
+
+        static nvrtc_memory_pool& instance();
+
+        // throw std::runtime_error if the driver cannot allocate the memory
+        CUdeviceptr allocateDevice(int device, std::size_t bytes, CUstream stream);
+        void freeDevice(int device, CUdeviceptr pointer, std::size_t bytes, CUstream stream);
+        void* allocateHost(std::size_t bytes);
+        void freeHost(void* pointer, std::size_t bytes, CUstream stream);
+
+        void markSynchronized();    //all streams are idle, cached blocks are free for any stream
+        void releaseCached();       //returns the free lists to the driver
+
+        cuda::memory_statistics statistics();
+
+        static std::size_t sizeClass(std::size_t bytes);
+
+    private:
+
+        struct device_block
+        {
+            CUdeviceptr pointer;
+            CUstream stream;
+            bool synchronized;
+        };
+
+        struct host_block
+        {
+            void* pointer;
+            bool synchronized;
+        };
+
+        nvrtc_memory_pool() = default;
+
+        void releaseCached(int device);     //mutex is held
+
+        std::mutex mutex;
+        std::vector<std::map<std::size_t, std::vector<device_block>>> deviceBlocks;     //per device, by size class
+        std::map<std::size_t, std::vector<host_block>> hostBlocks;
+        cuda::memory_statistics stats = {};
+    };
+}
+
+#endif
@@ -0,0 +1,76 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_partition.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace xcpp
+{
+    namespace
+    {
+        // weight of a new measurement in the average, launches vary with the load of the device
+        constexpr double SMOOTHING = 0.5;
+    }
+
+    nvrtc_partitioner& nvrtc_partitioner::instance()
+    {
+        static nvrtc_partitioner partitioner;
+        return partitioner;
+    }
+
+    std::vector<cuda::device_slice> nvrtc_partitioner::split(const std::string& kernel, std::size_t extent, std::size_t granularity, int devices, bool weighted)
+    {
+        std::vector<double> weights = weighted ? throughput(kernel, devices) : std::vector<double>();
+        if (weights.empty()) weights.assign(devices, 1.0);
+        double total = 0.0;
+        for (double w : weights) total += w;
+
+        //slices are whole blocks, only the last one can end inside a block
+        granularity = std::max<std::size_t>(granularity, 1);
+        std::size_t units = (extent + granularity - 1) / granularity;
+        std::vector<cuda::device_slice> slices;
+        double cumulative = 0.0;
+        std::size_t begin = 0;
+        for (int device = 0; device < devices; device++)
+        {
+            cumulative += weights[device];
+            std::size_t endUnit = device == devices - 1 ? units : static_cast<std::size_t>(std::llround(units * cumulative / total));
+            std::size_t end = std::min(extent, endUnit * granularity);
+            end = std::max(end, begin);
+            slices.push_back({device, begin, end});
+            begin = end;
+        }
+        return slices;
+    }
+
+    void nvrtc_partitioner::record(const std::string& kernel, int device, std::size_t elements, double milliseconds)
+    {
+        if (elements == 0 || milliseconds <= 0.0) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<double>& values = measured[kernel];
+        if (static_cast<int>(values.size()) <= device) values.resize(device + 1, 0.0);
+        double current = elements / milliseconds;
+        values[device] = values[device] == 0.0 ? current : SMOOTHING * current + (1.0 - SMOOTHING) * values[device];
+    }
+
+    std::vector<double> nvrtc_partitioner::throughput(const std::string& kernel, int devices)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = measured.find(kernel);
+        if (found == measured.end() || static_cast<int>(found->second.size()) < devices) return {};
+        std::vector<double> values(found->second.begin(), found->second.begin() + devices);
+        for (double v : values)
+        {
+            if (v == 0.0) return {};
+        }
+        return values;
+    }
+}
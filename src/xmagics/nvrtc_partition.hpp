@@ -0,0 +1,49 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_PARTITION_HPP
+#define XMAGICS_NVRTC_PARTITION_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xcpp/xcuda.hpp"
+
+namespace xcpp
+{
+    // Splits the index space of xcpp::cuda::launch_all over the devices. The
+    // throughput of each kernel and device is measured by the launches and
+    // averaged, weighted partitions give faster devices a larger slice.
+    class nvrtc_partitioner
+    {
+    public:
+
+        static nvrtc_partitioner& instance();
+
+        // slices of [0, extent) in multiples of granularity, one per device
+        std::vector<cuda::device_slice> split(const std::string& kernel, std::size_t extent, std::size_t granularity, int devices, bool weighted);
+
+        void record(const std::string& kernel, int device, std::size_t elements, double milliseconds);
+
+        // elements per millisecond per device, empty until each device ran the kernel
+        std::vector<double> throughput(const std::string& kernel, int devices);
+
+    private:
+
+        nvrtc_partitioner() = default;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, std::vector<double>> measured;  //kernel to throughput per device, 0 if not measured
+    };
+}
+
+#endif
@@ -0,0 +1,343 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_ptx.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace xcpp
+{
+    namespace
+    {
+        const std::unordered_set<std::string> SFU_OPERATIONS = {"ex2", "lg2", "sin", "cos", "tanh", "rsqrt"};
+        const std::unordered_set<std::string> ARITHMETIC_OPERATIONS = {"add", "sub", "mul", "mad", "fma", "div", "rem", "min", "max", "neg", "abs",
+                                                                       "sqrt", "rcp", "setp", "selp", "and", "or", "xor", "not", "shl", "shr",
+                                                                       "mul24", "mad24", "sad", "popc", "clz", "brev", "bfe", "bfi", "copysign", "testp"};
+
+        // size in bytes of a PTX type modifier, 0 if it is no type
+        int typeBytes(const std::string& type)
+        {
+            static const std::unordered_map<std::string, int> sizes = {
+                {"b8", 1}, {"s8", 1}, {"u8", 1}, {"b16", 2}, {"s16", 2}, {"u16", 2}, {"f16", 2}, {"bf16", 2},
+                {"b32", 4}, {"s32", 4}, {"u32", 4}, {"f32", 4}, {"f16x2", 4}, {"bf16x2", 4},
+                {"b64", 8}, {"s64", 8}, {"u64", 8}, {"f64", 8}, {"b128", 16}};
+            auto size = sizes.find(type);
+            return size == sizes.end() ? 0 : size->second;
+        }
+
+        std::vector<std::string> split(const std::string& opcode)
+        {
+            std::vector<std::string> parts;
+            std::istringstream stream(opcode);
+            std::string part;
+            while (std::getline(stream, part, '.')) parts.push_back(part);
+            return parts;
+        }
+
+        bool contains(const std::vector<std::string>& parts, const std::string& part)
+        {
+            return std::find(parts.begin(), parts.end(), part) != parts.end();
+        }
+
+        void countInstruction(nvrtc_ptx_function& function, const std::string& opcode, bool predicated)
+        {
+            std::vector<std::string> parts = split(opcode);
+            if (parts.empty()) return;
+            const std::string& operation = parts[0];
+
+            //the last type of the modifiers is the one of the operation, e.g. setp.lt.f32
+            std::string type;
+            int bytes = 0;
+            int vector = 1;
+            for (const std::string& part : parts)
+            {
+                if (typeBytes(part) > 0)
+                {
+                    type = part;
+                    bytes = typeBytes(part);
+                }
+                if (part == "v2") vector = 2;
+                if (part == "v4") vector = 4;
+            }
+
+            if (operation == "ld" || operation == "ldu" || operation == "st")
+            {
+                bool load = operation != "st";
+                if (contains(parts, "shared")) (load ? function.sharedLoads : function.sharedStores)++;
+                else if (contains(parts, "local")) (load ? function.localLoads : function.localStores)++;
+                else if (contains(parts, "const")) function.constLoads++;
+                else if (contains(parts, "param")) {}   //kernel arguments
+                else
+                {
+                    (load ? function.globalLoads : function.globalStores)++;
+                    function.globalBytes += static_cast<long long>(bytes) * vector;
+                }
+                return;
+            }
+            if (operation == "atom" || operation == "red")
+            {
+                function.atomics++;
+                if (!contains(parts, "shared")) function.globalBytes += bytes;
+                return;
+            }
+            if (operation == "bra" || operation == "brx")
+            {
+                function.branches++;
+                if (predicated) function.predicatedBranches++;
+                return;
+            }
+            if (operation == "bar" || operation == "barrier")
+            {
+                function.barriers++;
+                return;
+            }
+            if (operation == "call")
+            {
+                function.calls++;
+                return;
+            }
+            if (operation == "cvt")
+            {
+                function.conversions++;
+                if (contains(parts, "f64")) function.fp64Conversions++;
+                return;
+            }
+
+            //approximate transcendentals run on the special function units, in FP64 they are emulated
+            bool approximate = contains(parts, "approx");
+            if ((SFU_OPERATIONS.count(operation) > 0 || (approximate && (operation == "rcp" || operation == "sqrt"))) && type != "f64")
+            {
+                function.sfu++;
+                return;
+            }
+            if (ARITHMETIC_OPERATIONS.count(operation) == 0) return;    //mov, cvta, ret and the like
+            int flops = (operation == "fma" || operation == "mad") ? 2 : 1;
+            if (type == "f32")
+            {
+                function.fp32++;
+                if (operation != "setp" && operation != "selp") function.flops += flops;
+            }
+            else if (type == "f64")
+            {
+                function.fp64++;
+                if (operation != "setp" && operation != "selp") function.flops += flops;
+            }
+            else if (type == "f16" || type == "f16x2" || type == "bf16" || type == "bf16x2")
+            {
+                function.fp16++;
+                if (operation != "setp" && operation != "selp") function.flops += flops * (type.size() > 4 ? 2 : 1);
+            }
+            else
+            {
+                function.integer++;
+            }
+        }
+    }
+
+    int nvrtc_ptx_function::registerCount() const
+    {
+        int count = 0;
+        for (const auto& r : registers)
+        {
+            if (r.first != "pred") count += r.second;
+        }
+        return count;
+    }
+
+    double nvrtc_ptx_function::arithmeticIntensity() const
+    {
+        return globalBytes == 0 ? 0.0 : static_cast<double>(flops) / globalBytes;
+    }
+
+    std::vector<std::string> nvrtc_ptx_function::warnings() const
+    {
+        std::vector<std::string> result;
+        if (fp64 > 0 || fp64Conversions > 0)
+        {
+            result.push_back("uses FP64 (" + std::to_string(fp64) + " operations, " + std::to_string(fp64Conversions) + " conversions)");
+        }
+        if (localLoads > 0 || localStores > 0 || localBytes > 0)
+        {
+            result.push_back("uses local memory (" + std::to_string(localBytes) + " bytes, " + std::to_string(localLoads + localStores) + " accesses)");
+        }
+        return result;
+    }
+
+    std::vector<nvrtc_ptx_function> nvrtc_ptx_analyzer::analyze(const std::string& ptx)
+    {
+        //.visible .entry _Z5saxpyfPfS_(   .func (.param .b32 func_retval0) _Z3fooi(
+        std::regex header(R"(^\s*(?:\.visible\s+|\.extern\s+|\.weak\s+)*\.(entry|func)\s+(?:\([^)]*\)\s*)?([\w$]+))");
+        std::regex registerDeclaration(R"(^\s*\.reg\s+\.(\w+)\s+[%\w$]+(?:<(\d+)>)?)");
+        //.shared .align 4 .b8 _ZZ6reduceE4data[1024];   .local .align 8 .b8 __local_depot0[32];
+        std::regex variable(R"(^\s*\.(shared|local)\s+(?:\.align\s+\d+\s+)?\.(\w+)\s+([\w$]+)(?:\[(\d+)\])?)");
+        std::regex instruction(R"(^\s*(@!?%?\w+\s+)?([a-z][\w.]*))");
+
+        std::vector<nvrtc_ptx_function> functions;
+        std::unordered_map<std::string, long long> moduleShared;    //module scope __shared__ variables, attributed to the functions using them
+        std::istringstream lines(ptx);
+        std::string line;
+        std::smatch match;
+        nvrtc_ptx_function* current = nullptr;
+        std::unordered_set<std::string> usedShared;
+        int depth = 0;
+        bool body = false;
+        while (std::getline(lines, line))
+        {
+            std::size_t comment = line.find("//");
+            if (comment != std::string::npos) line.erase(comment);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+            if (current == nullptr)
+            {
+                if (std::regex_search(line, match, header))
+                {
+                    //a declaration without body (ends with ;) is no function
+                    functions.emplace_back();
+                    current = &functions.back();
+                    current->entry = match[1].str() == "entry";
+                    current->name = match[2].str();
+                    usedShared.clear();
+                    depth = 0;
+                    body = false;
+                }
+                else if (std::regex_search(line, match, variable) && match[1].str() == "shared")
+                {
+                    long long count = match[4].matched ? std::stoll(match[4].str()) : 1;
+                    moduleShared[match[3].str()] = count * typeBytes(match[2].str());
+                }
+                if (current == nullptr) continue;
+            }
+
+            //the body starts with the first brace after the parameters
+            for (char c : line)
+            {
+                if (c == '{')
+                {
+                    depth++;
+                    body = true;
+                }
+                else if (c == '}') depth--;
+            }
+            if (!body)
+            {
+                if (line.find(';') != std::string::npos)   //prototype only
+                {
+                    functions.pop_back();
+                    current = nullptr;
+                }
+                continue;
+            }
+
+            if (std::regex_search(line, match, registerDeclaration))
+            {
+                current->registers[match[1].str()] += match[2].matched ? std::stoi(match[2].str()) : 1;
+            }
+            else if (std::regex_search(line, match, variable))
+            {
+                long long count = match[4].matched ? std::stoll(match[4].str()) : 1;
+                long long bytes = count * typeBytes(match[2].str());
+                if (match[1].str() == "local") current->localBytes += bytes;
+                else current->sharedBytes += bytes;
+            }
+            else if (line.find(':') == std::string::npos || line.find(';') != std::string::npos)
+            {
+                std::string statement = line.substr(0, line.find(';'));
+                if (std::regex_search(statement, match, instruction)) countInstruction(*current, match[2].str(), match[1].matched);
+                for (const auto& shared : moduleShared)
+                {
+                    if (usedShared.count(shared.first) == 0 && statement.find(shared.first) != std::string::npos)
+                    {
+                        usedShared.insert(shared.first);
+                        current->sharedBytes += shared.second;
+                    }
+                }
+            }
+
+            if (depth == 0)
+            {
+                current = nullptr;
+            }
+        }
+        if (current != nullptr && !body) functions.pop_back();
+        return functions;
+    }
+
+    std::string nvrtc_ptx_analyzer::table(const std::vector<nvrtc_ptx_function>& functions)
+    {
+        const std::vector<std::string> columns = {"function", "regs", "fp32", "fp64", "fp16", "int", "sfu", "cvt", "ld.g", "st.g", "ld.s", "st.s",
+                                                  "ld.l", "st.l", "atom", "bra", "@bra", "bar", "flop/B"};
+        std::vector<std::vector<std::string>> rows;
+        for (const nvrtc_ptx_function& f : functions)
+        {
+            std::ostringstream intensity;
+            intensity << std::fixed << std::setprecision(2) << f.arithmeticIntensity();
+            rows.push_back({(f.entry ? "" : ".func ") + f.name, std::to_string(f.registerCount()), std::to_string(f.fp32), std::to_string(f.fp64),
+                            std::to_string(f.fp16), std::to_string(f.integer), std::to_string(f.sfu), std::to_string(f.conversions),
+                            std::to_string(f.globalLoads), std::to_string(f.globalStores), std::to_string(f.sharedLoads), std::to_string(f.sharedStores),
+                            std::to_string(f.localLoads), std::to_string(f.localStores), std::to_string(f.atomics), std::to_string(f.branches),
+                            std::to_string(f.predicatedBranches), std::to_string(f.barriers), f.globalBytes == 0 ? "-" : intensity.str()});
+        }
+        std::vector<std::size_t> widths;
+        for (const std::string& column : columns) widths.push_back(column.size());
+        for (const auto& row : rows)
+        {
+            for (std::size_t i = 0; i < row.size(); i++) widths[i] = std::max(widths[i], row[i].size());
+        }
+
+        std::ostringstream out;
+        auto print = [&out, &widths](const std::vector<std::string>& row)
+        {
+            for (std::size_t i = 0; i < row.size(); i++)
+            {
+                if (i == 0) out << std::left << std::setw(static_cast<int>(widths[i])) << row[i];
+                else out << "  " << std::right << std::setw(static_cast<int>(widths[i])) << row[i];
+            }
+            out << std::endl;
+        };
+        print(columns);
+        for (const auto& row : rows) print(row);
+        for (const nvrtc_ptx_function& f : functions)
+        {
+            for (const std::string& warning : f.warnings()) out << "Warning: " << f.name << " " << warning << std::endl;
+        }
+        return out.str();
+    }
+
+    nlohmann::json nvrtc_ptx_analyzer::toJson(const std::vector<nvrtc_ptx_function>& functions)
+    {
+        nlohmann::json result = nlohmann::json::array();
+        for (const nvrtc_ptx_function& f : functions)
+        {
+            result.push_back({
+                {"name", f.name},
+                {"entry", f.entry},
+                {"registers", f.registers},
+                {"instructions", {{"fp32", f.fp32}, {"fp64", f.fp64}, {"fp16", f.fp16}, {"int", f.integer}, {"sfu", f.sfu},
+                                  {"cvt", f.conversions}, {"cvt_f64", f.fp64Conversions}}},
+                {"memory", {{"global_loads", f.globalLoads}, {"global_stores", f.globalStores}, {"shared_loads", f.sharedLoads},
+                            {"shared_stores", f.sharedStores}, {"local_loads", f.localLoads}, {"local_stores", f.localStores},
+                            {"const_loads", f.constLoads}, {"atomics", f.atomics}, {"global_bytes", f.globalBytes},
+                            {"shared_bytes", f.sharedBytes}, {"local_bytes", f.localBytes}}},
+                {"branches", f.branches},
+                {"predicated_branches", f.predicatedBranches},
+                {"barriers", f.barriers},
+                {"calls", f.calls},
+                {"flops", f.flops},
+                {"arithmetic_intensity", f.arithmeticIntensity()},
+                {"warnings", f.warnings()}
+            });
+        }
+        return result;
+    }
+}
@@ -0,0 +1,70 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_PTX_HPP
+#define XMAGICS_NVRTC_PTX_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace xcpp
+{
+    // static counts of one .entry or .func of a PTX module, each instruction
+    // is counted once regardless of how often it runs
+    struct nvrtc_ptx_function
+    {
+        std::string name;
+        bool entry = true;                      //.entry, else .func
+        std::map<std::string, int> registers;   //declared virtual registers per type, e.g. f32
+        int fp32 = 0;
+        int fp64 = 0;
+        int fp16 = 0;
+        int integer = 0;
+        int sfu = 0;                            //approximate transcendentals of the special function units
+        int conversions = 0;
+        int fp64Conversions = 0;                //cvt from or to f64
+        int globalLoads = 0;                    //generic accesses are counted as global
+        int globalStores = 0;
+        int sharedLoads = 0;
+        int sharedStores = 0;
+        int localLoads = 0;
+        int localStores = 0;
+        int constLoads = 0;
+        int atomics = 0;
+        int branches = 0;
+        int predicatedBranches = 0;
+        int barriers = 0;
+        int calls = 0;
+        int flops = 0;                          //fma and mad count twice
+        long long globalBytes = 0;              //bytes of the global loads and stores
+        long long sharedBytes = 0;              //__shared__ variables used by the function
+        long long localBytes = 0;               //local memory frame
+
+        int registerCount() const;
+        double arithmeticIntensity() const;     //flops per global byte, 0 without global accesses
+        std::vector<std::string> warnings() const;
+    };
+
+    // Parser for the PTX of %%nvrtc -ptxstats. Works on the text alone, no
+    // CUDA library is needed.
+    class nvrtc_ptx_analyzer
+    {
+    public:
+
+        static std::vector<nvrtc_ptx_function> analyze(const std::string& ptx);
+
+        static std::string table(const std::vector<nvrtc_ptx_function>& functions);
+        static nlohmann::json toJson(const std::vector<nvrtc_ptx_function>& functions);
+    };
+}
+
+#endif
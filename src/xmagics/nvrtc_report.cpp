@@ -0,0 +1,186 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_report.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+
+namespace xcpp
+{
+    namespace
+    {
+        const std::vector<std::string> COLUMNS = {"kernel", "GPU", "arch", "registers", "smem", "local", "stack", "spill st", "spill ld", "max threads", "block", "occupancy"};
+
+        std::string value(int bytes)
+        {
+            return bytes < 0 ? "-" : std::to_string(bytes);
+        }
+
+        std::string escape(const std::string& text)
+        {
+            std::string result;
+            for (char c : text)
+            {
+                if (c == '<') result += "&lt;";
+                else if (c == '>') result += "&gt;";
+                else if (c == '&') result += "&amp;";
+                else result += c;
+            }
+            return result;
+        }
+    }
+
+    std::unordered_map<std::string, nvrtc_ptxas_info> nvrtc_resource_report::parsePtxasLog(const std::string& log)
+    {
+        //ptxas info    : Compiling entry function '_Z5saxpyfPfS_' for 'sm_80'
+        //ptxas info    : Function properties for _Z5saxpyfPfS_
+        //    0 bytes stack frame, 0 bytes spill stores, 0 bytes spill loads
+        //ptxas info    : Used 10 registers, 1024 bytes smem, 380 bytes cmem[0]
+        std::regex entry(R"(Compiling entry function '([^']+)')");
+        std::regex properties(R"(Function properties for (\S+))");
+        std::regex frame(R"((\d+) bytes stack frame, (\d+) bytes spill stores, (\d+) bytes spill loads)");
+        std::regex used(R"(Used (\d+) registers)");
+        std::regex shared(R"((\d+) bytes smem)");
+
+        std::unordered_map<std::string, nvrtc_ptxas_info> result;
+        std::istringstream lines(log);
+        std::string line;
+        std::string function;
+        std::smatch match;
+        while (std::getline(lines, line))
+        {
+            if (std::regex_search(line, match, entry) || std::regex_search(line, match, properties))
+            {
+                function = match[1].str();
+                continue;
+            }
+            if (function.empty()) continue;
+            nvrtc_ptxas_info& info = result[function];
+            if (std::regex_search(line, match, frame))
+            {
+                info.stackBytes = std::stoi(match[1].str());
+                info.spillStores = std::stoi(match[2].str());
+                info.spillLoads = std::stoi(match[3].str());
+            }
+            if (std::regex_search(line, match, used))
+            {
+                info.registers = std::stoi(match[1].str());
+                info.sharedBytes = std::regex_search(line, match, shared) ? std::stoi(match[1].str()) : 0;
+            }
+        }
+        return result;
+    }
+
+    void nvrtc_resource_report::add(const nvrtc_kernel_resources& kernel)
+    {
+        kernels.push_back(kernel);
+    }
+
+    bool nvrtc_resource_report::empty() const
+    {
+        return kernels.empty();
+    }
+
+    bool nvrtc_resource_report::spills(const nvrtc_kernel_resources& kernel) const
+    {
+        return kernel.ptxas.spillStores > 0 || kernel.ptxas.spillLoads > 0;
+    }
+
+    std::vector<std::vector<std::string>> nvrtc_resource_report::rows() const
+    {
+        std::vector<std::vector<std::string>> result;
+        for (const nvrtc_kernel_resources& kernel : kernels)
+        {
+            std::ostringstream occupancy;
+            occupancy << std::fixed << std::setprecision(0) << kernel.occupancy * 100 << "%";
+            result.push_back({kernel.kernel, std::to_string(kernel.device), kernel.architecture, value(kernel.registers), value(kernel.sharedBytes),
+                              value(kernel.localBytes), value(kernel.ptxas.stackBytes), value(kernel.ptxas.spillStores), value(kernel.ptxas.spillLoads),
+                              value(kernel.maxThreads), kernel.block > 0 ? std::to_string(kernel.block) : "-", kernel.block > 0 ? occupancy.str() : "-"});
+        }
+        return result;
+    }
+
+    nlohmann::json nvrtc_resource_report::toJson() const
+    {
+        nlohmann::json result = nlohmann::json::array();
+        for (const nvrtc_kernel_resources& kernel : kernels)
+        {
+            result.push_back({
+                {"kernel", kernel.kernel},
+                {"device", kernel.device},
+                {"architecture", kernel.architecture},
+                {"registers", kernel.registers},
+                {"shared_bytes", kernel.sharedBytes},
+                {"local_bytes", kernel.localBytes},
+                {"const_bytes", kernel.constBytes},
+                {"max_threads", kernel.maxThreads},
+                {"stack_bytes", kernel.ptxas.stackBytes},
+                {"spill_stores", kernel.ptxas.spillStores},
+                {"spill_loads", kernel.ptxas.spillLoads},
+                {"block", kernel.block},
+                {"occupancy", kernel.occupancy}
+            });
+        }
+        return result;
+    }
+
+    std::string nvrtc_resource_report::table() const
+    {
+        std::vector<std::vector<std::string>> cells = rows();
+        std::vector<std::size_t> widths;
+        for (const std::string& column : COLUMNS) widths.push_back(column.size());
+        for (const auto& row : cells)
+        {
+            for (std::size_t i = 0; i < row.size(); i++) widths[i] = std::max(widths[i], row[i].size());
+        }
+
+        //the kernel name is left aligned, the numbers right aligned
+        std::ostringstream out;
+        auto print = [&out, &widths](const std::vector<std::string>& row)
+        {
+            for (std::size_t i = 0; i < row.size(); i++)
+            {
+                if (i == 0) out << std::left << std::setw(static_cast<int>(widths[i])) << row[i];
+                else out << "  " << std::right << std::setw(static_cast<int>(widths[i])) << row[i];
+            }
+            out << std::endl;
+        };
+        print(COLUMNS);
+        for (const auto& row : cells) print(row);
+        for (const nvrtc_kernel_resources& kernel : kernels)
+        {
+            if (spills(kernel)) out << "Warning: " << kernel.kernel << " spills registers on GPU" << kernel.device << std::endl;
+        }
+        return out.str();
+    }
+
+    std::string nvrtc_resource_report::html() const
+    {
+        std::vector<std::vector<std::string>> cells = rows();
+        std::ostringstream out;
+        out << "<table><thead><tr>";
+        for (const std::string& column : COLUMNS) out << "<th>" << column << "</th>";
+        out << "</tr></thead><tbody>";
+        for (std::size_t r = 0; r < cells.size(); r++)
+        {
+            //spilling kernels are highlighted, they are the first to look at
+            out << (spills(kernels[r]) ? "<tr style=\"background-color: #fdd\">" : "<tr>");
+            for (std::size_t i = 0; i < cells[r].size(); i++)
+            {
+                out << (i == 0 ? "<td style=\"text-align: left\"><code>" : "<td>") << escape(cells[r][i]) << (i == 0 ? "</code></td>" : "</td>");
+            }
+            out << "</tr>";
+        }
+        out << "</tbody></table>";
+        return out.str();
+    }
+}
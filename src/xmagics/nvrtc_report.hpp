@@ -0,0 +1,71 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_REPORT_HPP
+#define XMAGICS_NVRTC_REPORT_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace xcpp
+{
+    // resources of one function in the ptxas -v output of NVRTC, -1 if not reported
+    struct nvrtc_ptxas_info
+    {
+        int registers = -1;
+        int sharedBytes = -1;
+        int stackBytes = -1;
+        int spillStores = -1;
+        int spillLoads = -1;
+    };
+
+    // resources of one kernel on one device, -1 if unknown
+    struct nvrtc_kernel_resources
+    {
+        std::string kernel;
+        int device = 0;
+        std::string architecture;
+        int registers = -1;
+        int sharedBytes = -1;     //static shared memory
+        int localBytes = -1;      //local memory per thread, spilled registers and stack
+        int constBytes = -1;
+        int maxThreads = -1;      //threads per block the kernel can be launched with
+        nvrtc_ptxas_info ptxas;
+        int block = 0;            //block size of the highest occupancy
+        double occupancy = 0.0;   //active threads per multiprocessor relative to the maximum
+    };
+
+    // Kernel resource table of %%nvrtc -report, as text, HTML and JSON.
+    class nvrtc_resource_report
+    {
+    public:
+
+        // function name to its resources, the log of a compilation with --ptxas-options=-v
+        static std::unordered_map<std::string, nvrtc_ptxas_info> parsePtxasLog(const std::string& log);
+
+        void add(const nvrtc_kernel_resources& kernel);
+        bool empty() const;
+
+        nlohmann::json toJson() const;
+        std::string table() const;
+        std::string html() const;
+
+    private:
+
+        std::vector<std::vector<std::string>> rows() const;
+        bool spills(const nvrtc_kernel_resources& kernel) const;
+
+        std::vector<nvrtc_kernel_resources> kernels;
+    };
+}
+
+#endif
@@ -0,0 +1,515 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+// Implementation of the xcpp::cuda runtime API which cells use through
+// xcpp/xcuda.hpp, the symbols are resolved by cling from libxeus-cling.
+
+#include "xcpp/xcuda.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <new>
+#include <stdexcept>
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_emulator.hpp"
+#include "nvrtc_memory.hpp"
+#include "nvrtc_partition.hpp"
+#include "nvrtc_session.hpp"
+#include "nvrtc_streams.hpp"
+#include "nvrtc_tuner.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        //with -emulate device memory is host memory and launches are synchronous
+        bool emulated()
+        {
+            return nvrtc_emulator::instance().isActive();
+        }
+
+        double hostMilliseconds()
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        //stream of a running graph capture of this thread, replaces the null stream
+        thread_local CUstream captureStream = nullptr;
+
+        CUstream launchStream(CUstream stream)
+        {
+            return stream == nullptr ? captureStream : stream;
+        }
+
+        void* allocateAligned(std::size_t bytes)
+        {
+            //the alignment of cuMemAlloc
+            void* pointer = std::aligned_alloc(256, (bytes + 255) / 256 * 256);
+            if (pointer == nullptr) throw std::bad_alloc();
+            return pointer;
+        }
+    }
+
+    namespace cuda
+    {
+        kernel_future::kernel_future(const std::string& name)
+            : m_name(name)
+        {
+        }
+
+        const std::string& kernel_future::name() const
+        {
+            return m_name;
+        }
+
+        bool kernel_future::ready() const
+        {
+            return nvrtc_session::instance().isReady(m_name);
+        }
+
+        void kernel_future::wait() const
+        {
+            nvrtc_session::instance().wait(m_name);
+        }
+
+        CUfunction kernel_future::get(int device) const
+        {
+            std::vector<CUfunction> handles = nvrtc_session::instance().kernel(m_name);
+            if (device < 0 || device >= static_cast<int>(handles.size()) || handles[device] == nullptr)
+            {
+                throw std::runtime_error("Kernel " + m_name + " is not available on device " + std::to_string(device));
+            }
+            return handles[device];
+        }
+
+        kernel_future kernel(const std::string& name)
+        {
+            return kernel_future(name);
+        }
+
+        CUstream stream(int device, int index)
+        {
+            //distinct handles, the emulator ignores them
+            if (emulated()) return reinterpret_cast<CUstream>(static_cast<std::uintptr_t>(index + 1));
+            return nvrtc_stream_pool::instance().stream(device, index);
+        }
+
+        int synchronize_all()
+        {
+            std::string error;
+            return nvrtc_stream_pool::instance().synchronizeAll(error);
+        }
+
+        event::event(int device, bool timing)
+            : m_device(device)
+        {
+            if (emulated()) return;
+            nvrtc_api& api = nvrtc_api::instance();
+            CUcontext context = nvrtc_stream_pool::instance().context(device);
+            CUcontext previous = nullptr;
+            int result = api.cuda.cuCtxPushCurrent(context);
+            if (result == CUDA_API_SUCCESS)
+            {
+                //events without timing are cheaper for dependencies
+                result = api.cuda.cuEventCreate(&m_event, timing ? 0 : CU_EVENT_API_DISABLE_TIMING);
+                api.cuda.cuCtxPopCurrent(&previous);
+            }
+            if (result != CUDA_API_SUCCESS)
+            {
+                throw std::runtime_error("Could not create event on CUDA device " + std::to_string(device) + ": " + api.cudaError(result));
+            }
+        }
+
+        event::~event()
+        {
+            if (m_event != nullptr) nvrtc_api::instance().cuda.cuEventDestroy(m_event);
+        }
+
+        event::event(event&& other) noexcept
+            : m_event(other.m_event), m_device(other.m_device), m_time(other.m_time)
+        {
+            other.m_event = nullptr;
+        }
+
+        event& event::operator=(event&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_event != nullptr) nvrtc_api::instance().cuda.cuEventDestroy(m_event);
+                m_event = other.m_event;
+                m_device = other.m_device;
+                m_time = other.m_time;
+                other.m_event = nullptr;
+            }
+            return *this;
+        }
+
+        int event::record(CUstream stream)
+        {
+            if (emulated())
+            {
+                m_time = hostMilliseconds();
+                return CUDA_API_SUCCESS;
+            }
+            return nvrtc_api::instance().cuda.cuEventRecord(m_event, stream);
+        }
+
+        int event::wait(CUstream stream) const
+        {
+            if (emulated()) return CUDA_API_SUCCESS;
+            return nvrtc_api::instance().cuda.cuStreamWaitEvent(stream, m_event, 0);
+        }
+
+        int event::synchronize() const
+        {
+            if (emulated()) return CUDA_API_SUCCESS;
+            return nvrtc_api::instance().cuda.cuEventSynchronize(m_event);
+        }
+
+        float event::elapsed_ms(const event& start) const
+        {
+            if (emulated()) return static_cast<float>(m_time - start.m_time);
+            float milliseconds = 0.0f;
+            int result = nvrtc_api::instance().cuda.cuEventElapsedTime(&milliseconds, start.m_event, m_event);
+            if (result != CUDA_API_SUCCESS) throw std::runtime_error("cuEventElapsedTime: " + nvrtc_api::instance().cudaError(result));
+            return milliseconds;
+        }
+
+        CUevent event::get() const
+        {
+            return m_event;
+        }
+
+        CUdeviceptr device_allocate(std::size_t bytes, int device, CUstream stream)
+        {
+            if (emulated()) return reinterpret_cast<CUdeviceptr>(allocateAligned(bytes));
+            return nvrtc_memory_pool::instance().allocateDevice(device, bytes, stream);
+        }
+
+        void device_free(CUdeviceptr pointer, std::size_t bytes, int device, CUstream stream)
+        {
+            if (emulated())
+            {
+                std::free(reinterpret_cast<void*>(pointer));
+                return;
+            }
+            nvrtc_memory_pool::instance().freeDevice(device, pointer, bytes, stream);
+        }
+
+        void* host_allocate(std::size_t bytes)
+        {
+            if (emulated()) return allocateAligned(bytes);
+            return nvrtc_memory_pool::instance().allocateHost(bytes);
+        }
+
+        void host_free(void* pointer, std::size_t bytes, CUstream stream)
+        {
+            if (emulated())
+            {
+                std::free(pointer);
+                return;
+            }
+            nvrtc_memory_pool::instance().freeHost(pointer, bytes, stream);
+        }
+
+        memory_statistics memory_stats()
+        {
+            return nvrtc_memory_pool::instance().statistics();
+        }
+
+        void empty_cache()
+        {
+            nvrtc_memory_pool::instance().releaseCached();
+        }
+
+        int copy_to_device(CUdeviceptr destination, const void* source, std::size_t bytes, int device, CUstream stream)
+        {
+            if (emulated())
+            {
+                std::memcpy(reinterpret_cast<void*>(destination), source, bytes);
+                return CUDA_API_SUCCESS;
+            }
+            nvrtc_api& api = nvrtc_api::instance();
+            CUcontext previous = nullptr;
+            int result = api.cuda.cuCtxPushCurrent(nvrtc_stream_pool::instance().context(device));
+            if (result != CUDA_API_SUCCESS) return result;
+            stream = launchStream(stream);
+            result = stream == nullptr ? api.cuda.cuMemcpyHtoD(destination, source, bytes) : api.cuda.cuMemcpyHtoDAsync(destination, source, bytes, stream);
+            api.cuda.cuCtxPopCurrent(&previous);
+            return result;
+        }
+
+        int copy_to_host(void* destination, CUdeviceptr source, std::size_t bytes, int device, CUstream stream)
+        {
+            if (emulated())
+            {
+                std::memcpy(destination, reinterpret_cast<const void*>(source), bytes);
+                return CUDA_API_SUCCESS;
+            }
+            nvrtc_api& api = nvrtc_api::instance();
+            CUcontext previous = nullptr;
+            int result = api.cuda.cuCtxPushCurrent(nvrtc_stream_pool::instance().context(device));
+            if (result != CUDA_API_SUCCESS) return result;
+            stream = launchStream(stream);
+            result = stream == nullptr ? api.cuda.cuMemcpyDtoH(destination, source, bytes) : api.cuda.cuMemcpyDtoHAsync(destination, source, bytes, stream);
+            api.cuda.cuCtxPopCurrent(&previous);
+            return result;
+        }
+
+        int launch(CUfunction function, dim3 grid, dim3 block, unsigned int sharedMemory, CUstream stream, void** arguments)
+        {
+            if (emulated()) return nvrtc_emulator::instance().launch(function, grid, block, sharedMemory, arguments);
+            return nvrtc_api::instance().cuda.cuLaunchKernel(function, grid.x, grid.y, grid.z, block.x, block.y, block.z,
+                                                             sharedMemory, launchStream(stream), arguments, nullptr);
+        }
+
+        std::vector<device_slice> partition(const std::string& kernel, std::size_t extent, std::size_t granularity, bool weighted)
+        {
+            //the emulator runs all kernels as one device
+            int devices = emulated() ? 1 : nvrtc_stream_pool::instance().deviceCount();
+            if (devices == 0) throw std::out_of_range("No CUDA device, run a %%nvrtc cell first");
+            return nvrtc_partitioner::instance().split(kernel, extent, granularity, devices, weighted);
+        }
+
+        std::vector<tuning_candidate> autotune(CUfunction function, const std::vector<std::string>& variants, std::size_t problem_size,
+                                               const std::vector<unsigned int>& blocks, int repeat, unsigned int shared_memory,
+                                               const std::function<int(CUfunction, dim3, dim3, CUstream)>& launch)
+        {
+            return nvrtc_tuner::instance().tune(function, variants, problem_size, blocks, repeat, shared_memory, launch);
+        }
+
+        unsigned int tuned_launch(CUfunction function, std::size_t problem_size, unsigned int shared_memory, CUfunction& tuned)
+        {
+            return nvrtc_tuner::instance().tuned(function, problem_size, shared_memory, tuned);
+        }
+
+        int run_on_devices(const std::string& kernel, const std::vector<device_slice>& slices, const std::function<int(const device_slice&)>& launch)
+        {
+            nvrtc_api& api = nvrtc_api::instance();
+            std::vector<int> results(slices.size(), CUDA_API_SUCCESS);
+            std::vector<double> milliseconds(slices.size(), 0.0);
+
+            //launch and wait for the stream, the time measures the throughput of the device
+            auto run = [&](std::size_t i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                results[i] = launch(slices[i]);
+                if (results[i] == CUDA_API_SUCCESS && !emulated()) results[i] = api.cuda.cuStreamSynchronize(stream(slices[i].device));
+                milliseconds[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+
+            std::vector<std::size_t> used;
+            for (std::size_t i = 0; i < slices.size(); i++)
+            {
+                if (slices[i].end > slices[i].begin) used.push_back(i);
+            }
+
+            std::shared_ptr<nvrtc_device_workers> workers = emulated() ? nullptr : nvrtc_stream_pool::instance().workers();
+            if (workers == nullptr || used.size() < 2)
+            {
+                //single device, the calling thread switches the context
+                for (std::size_t i : used)
+                {
+                    if (emulated())
+                    {
+                        run(i);
+                        continue;
+                    }
+                    CUcontext previous = nullptr;
+                    results[i] = api.cuda.cuCtxPushCurrent(nvrtc_stream_pool::instance().context(slices[i].device));
+                    if (results[i] != CUDA_API_SUCCESS) continue;
+                    try
+                    {
+                        run(i);
+                    }
+                    catch (...)
+                    {
+                        api.cuda.cuCtxPopCurrent(&previous);
+                        throw;
+                    }
+                    api.cuda.cuCtxPopCurrent(&previous);
+                }
+            }
+            else
+            {
+                std::vector<std::future<void>> done;
+                for (std::size_t i : used)
+                {
+                    done.push_back(workers->submit(slices[i].device, [&run, i]() { run(i); }));
+                }
+                //all devices are joined before an exception of one of them is passed on
+                std::exception_ptr error;
+                for (std::future<void>& f : done)
+                {
+                    try
+                    {
+                        f.get();
+                    }
+                    catch (...)
+                    {
+                        if (!error) error = std::current_exception();
+                    }
+                }
+                if (error) std::rethrow_exception(error);
+            }
+
+            int first = CUDA_API_SUCCESS;
+            for (std::size_t i : used)
+            {
+                if (results[i] == CUDA_API_SUCCESS) nvrtc_partitioner::instance().record(kernel, slices[i].device, slices[i].end - slices[i].begin, milliseconds[i]);
+                else if (first == CUDA_API_SUCCESS) first = results[i];
+            }
+            return first;
+        }
+
+        graph::graph(int device)
+            : m_device(device)
+        {
+        }
+
+        graph::~graph()
+        {
+            release();
+        }
+
+        graph::graph(graph&& other) noexcept
+            : m_device(other.m_device), m_stream(other.m_stream), m_exec(other.m_exec), m_statistics(other.m_statistics)
+        {
+            other.m_stream = nullptr;
+            other.m_exec = nullptr;
+        }
+
+        graph& graph::operator=(graph&& other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                m_device = other.m_device;
+                m_stream = other.m_stream;
+                m_exec = other.m_exec;
+                m_statistics = other.m_statistics;
+                other.m_stream = nullptr;
+                other.m_exec = nullptr;
+            }
+            return *this;
+        }
+
+        void graph::release()
+        {
+            nvrtc_api& api = nvrtc_api::instance();
+            if (m_exec != nullptr) api.cuda.cuGraphExecDestroy(m_exec);
+            if (m_stream != nullptr) api.cuda.cuStreamDestroy(m_stream);
+            m_exec = nullptr;
+            m_stream = nullptr;
+        }
+
+        int graph::capture(const std::function<void(CUstream)>& body)
+        {
+            if (emulated()) throw std::runtime_error("CUDA graphs are not available with -emulate");
+            nvrtc_api& api = nvrtc_api::instance();
+            if (!api.hasGraphs()) return CUDA_API_ERROR_NOT_SUPPORTED;
+
+            CUcontext previous = nullptr;
+            int result = api.cuda.cuCtxPushCurrent(nvrtc_stream_pool::instance().context(m_device));
+            if (result != CUDA_API_SUCCESS) return result;
+            if (m_stream == nullptr) result = api.cuda.cuStreamCreate(&m_stream, CU_STREAM_API_NON_BLOCKING);
+            //thread local mode, builds and frees of other threads are not affected by the capture
+            if (result == CUDA_API_SUCCESS) result = api.cuda.cuStreamBeginCapture(m_stream, CU_STREAM_API_CAPTURE_MODE_THREAD_LOCAL);
+            if (result != CUDA_API_SUCCESS)
+            {
+                api.cuda.cuCtxPopCurrent(&previous);
+                return result;
+            }
+
+            CUgraph captured = nullptr;
+            CUstream outer = captureStream;
+            captureStream = m_stream;
+            auto start = std::chrono::steady_clock::now();
+            try
+            {
+                body(m_stream);
+            }
+            catch (...)
+            {
+                captureStream = outer;
+                if (api.cuda.cuStreamEndCapture(m_stream, &captured) == CUDA_API_SUCCESS && captured != nullptr) api.cuda.cuGraphDestroy(captured);
+                api.cuda.cuCtxPopCurrent(&previous);
+                throw;
+            }
+            m_statistics.capture_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            captureStream = outer;
+
+            //a failed launch invalidates the capture, the graph of the last capture stays
+            result = api.cuda.cuStreamEndCapture(m_stream, &captured);
+            if (result == CUDA_API_SUCCESS)
+            {
+                m_statistics.captures++;
+                std::size_t nodes = 0;
+                if (api.cuda.cuGraphGetNodes != nullptr && api.cuda.cuGraphGetNodes(captured, nullptr, &nodes) == CUDA_API_SUCCESS) m_statistics.nodes = nodes;
+
+                //the parameters are updated in place, a changed topology needs a new instance
+                if (m_exec != nullptr && api.updateGraph(m_exec, captured) == CUDA_API_SUCCESS)
+                {
+                    m_statistics.updates++;
+                }
+                else
+                {
+                    if (m_exec != nullptr) api.cuda.cuGraphExecDestroy(m_exec);
+                    m_exec = nullptr;
+                    result = api.cuda.cuGraphInstantiateWithFlags(&m_exec, captured, 0);
+                    if (result == CUDA_API_SUCCESS) m_statistics.instantiations++;
+                    else m_exec = nullptr;
+                }
+            }
+            if (captured != nullptr) api.cuda.cuGraphDestroy(captured);
+            api.cuda.cuCtxPopCurrent(&previous);
+            return result;
+        }
+
+        int graph::launch(CUstream stream)
+        {
+            if (m_exec == nullptr) return CUDA_API_ERROR_NOT_SUPPORTED;
+            auto start = std::chrono::steady_clock::now();
+            int result = nvrtc_api::instance().cuda.cuGraphLaunch(m_exec, stream == nullptr ? m_stream : stream);
+            m_statistics.launch_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            if (result == CUDA_API_SUCCESS) m_statistics.launches++;
+            return result;
+        }
+
+        int graph::synchronize() const
+        {
+            return m_stream == nullptr ? CUDA_API_SUCCESS : nvrtc_api::instance().cuda.cuStreamSynchronize(m_stream);
+        }
+
+        bool graph::ready() const
+        {
+            return m_exec != nullptr;
+        }
+
+        int graph::device() const
+        {
+            return m_device;
+        }
+
+        CUstream graph::stream() const
+        {
+            return m_stream;
+        }
+
+        graph_statistics graph::statistics() const
+        {
+            return m_statistics;
+        }
+    }
+}
@@ -0,0 +1,191 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_session.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace xcpp
+{
+    nvrtc_session& nvrtc_session::instance()
+    {
+        static nvrtc_session session;
+        return session;
+    }
+
+    void nvrtc_session::setKernel(const std::string& name, const std::vector<CUfunction>& handles)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        kernels[name] = handles;
+        failed.erase(name);
+        //the source name is registered before the name of the cling variable and is kept,
+        //unless the handle of an unloaded module was reused by the driver
+        for (std::size_t device = 0; device < handles.size(); device++)
+        {
+            if (handles[device] == nullptr) continue;
+            auto found = handleNames.find(handles[device]);
+            if (found != handleNames.end() && found->second.first != name)
+            {
+                auto current = kernels.find(found->second.first);
+                if (current != kernels.end() && std::find(current->second.begin(), current->second.end(), handles[device]) != current->second.end()) continue;
+            }
+            handleNames[handles[device]] = std::make_pair(name, static_cast<int>(device));
+        }
+    }
+
+    bool nvrtc_session::findKernel(CUfunction handle, std::string& name, int& device)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = handleNames.find(handle);
+        if (found == handleNames.end()) return false;
+        name = found->second.first;
+        device = found->second.second;
+        return true;
+    }
+
+    void nvrtc_session::setFailed(const std::vector<std::string>& names, const std::string& errors)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::string& name : names)
+        {
+            failed[name] = errors;
+        }
+    }
+
+    std::size_t nvrtc_session::setPending(const std::vector<std::string>& names, const std::shared_future<void>& build)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::size_t id = ++buildCount;
+        for (const std::string& name : names)
+        {
+            pending[name] = pending_build{build, id};
+        }
+        return id;
+    }
+
+    void nvrtc_session::clearPending(const std::vector<std::string>& names, std::size_t buildId)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::string& name : names)
+        {
+            //a newer build of the same kernel stays pending
+            auto it = pending.find(name);
+            if (it != pending.end() && it->second.id == buildId) pending.erase(it);
+        }
+    }
+
+    bool nvrtc_session::isReady(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.find(name) == pending.end() && kernels.find(name) != kernels.end();
+    }
+
+    void nvrtc_session::wait(const std::string& name)
+    {
+        std::shared_future<void> build;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = pending.find(name);
+            if (it == pending.end()) return;
+            build = it->second.done;
+        }
+        build.wait();   //only the build of this kernel is waited for
+    }
+
+    std::vector<CUfunction> nvrtc_session::kernel(const std::string& name)
+    {
+        wait(name);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto error = failed.find(name);
+        if (error != failed.end())
+        {
+            throw std::runtime_error("Build of kernel " + name + " failed:\n" + error->second);
+        }
+        auto it = kernels.find(name);
+        if (it == kernels.end())
+        {
+            throw std::runtime_error("Unknown kernel: " + name);
+        }
+        return it->second;
+    }
+
+    std::size_t nvrtc_session::kernelCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return kernels.size();
+    }
+
+    void nvrtc_session::post(std::function<void()> task)
+    {
+        std::function<void()> hook;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            posted.push_back(std::move(task));
+            hook = postHook;
+        }
+        if (hook) hook();
+    }
+
+    void nvrtc_session::runPosted()
+    {
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.swap(posted);
+        }
+        for (std::function<void()>& task : tasks)
+        {
+            task();
+        }
+    }
+
+    void nvrtc_session::setPostHook(std::function<void()> hook)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        postHook = std::move(hook);
+    }
+
+    void nvrtc_session::setReplyMetadata(const nlohmann::json& metadata)
+    {
+        //entries of several reports of a cell are kept, e.g. timings and resources
+        std::lock_guard<std::mutex> lock(mutex);
+        replyMetadata.merge_patch(metadata);
+    }
+
+    nlohmann::json nvrtc_session::takeReplyMetadata()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nlohmann::json metadata;
+        metadata.swap(replyMetadata);
+        return metadata;
+    }
+
+    void nvrtc_session::setHostCellHook(std::function<bool(const std::string&)> hook)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        hostCellHook = std::move(hook);
+    }
+
+    void nvrtc_session::prepareHostCell(const std::string& code)
+    {
+        std::function<bool(const std::string&)> hook;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!hostCellHook) return;
+            hook = hostCellHook;
+        }
+        //the hook uses cling, it is called without the lock
+        if (hook(code))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            hostCellHook = nullptr;
+        }
+    }
+}
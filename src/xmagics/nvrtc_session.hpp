@@ -0,0 +1,94 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_SESSION_HPP
+#define XMAGICS_NVRTC_SESSION_HPP
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "nvrtc_api.hpp"
+
+namespace xcpp
+{
+    // State of the %%nvrtc magic which is shared with the cells through the
+    // xcpp::cuda runtime API. All members can be used from any thread.
+    class nvrtc_session
+    {
+    public:
+
+        static nvrtc_session& instance();
+
+        // kernel handles per device, published by finished builds
+        void setKernel(const std::string& name, const std::vector<CUfunction>& handles);
+        void setFailed(const std::vector<std::string>& names, const std::string& errors);
+
+        // names of kernels of a build which is still running, returns the id of the build
+        std::size_t setPending(const std::vector<std::string>& names, const std::shared_future<void>& build);
+        void clearPending(const std::vector<std::string>& names, std::size_t buildId);
+
+        bool isReady(const std::string& name);
+        void wait(const std::string& name);
+
+        std::size_t kernelCount();
+
+        // name of the first registration of a handle and its device, false for unknown handles
+        bool findKernel(CUfunction handle, std::string& name, int& device);
+
+        // waits for a pending build, throws std::runtime_error for unknown or failed kernels
+        std::vector<CUfunction> kernel(const std::string& name);
+
+        // tasks which need the shell thread (cling, publishing to the frontend),
+        // executed before the next request of the shell channel
+        void post(std::function<void()> task);
+        void runPosted();
+
+        // called by post on the posting thread, wakes the idle shell thread
+        void setPostHook(std::function<void()> hook);
+
+        // runs before each host cell until it returns true, e.g. to declare the
+        // driver API when a cell uses it for the first time
+        void setHostCellHook(std::function<bool(const std::string&)> hook);
+        void prepareHostCell(const std::string& code);
+
+        // metadata for the execute_reply of the current cell, merged with the metadata set before
+        void setReplyMetadata(const nlohmann::json& metadata);
+        nlohmann::json takeReplyMetadata();
+
+    private:
+
+        struct pending_build
+        {
+            std::shared_future<void> done;
+            std::size_t id;
+        };
+
+        nvrtc_session() = default;
+
+        std::mutex mutex;
+        std::size_t buildCount = 0;
+        std::unordered_map<std::string, std::vector<CUfunction>> kernels;
+        std::unordered_map<CUfunction, std::pair<std::string, int>> handleNames;   //handle to source name and device
+        std::unordered_map<std::string, std::string> failed;
+        std::unordered_map<std::string, pending_build> pending;
+        std::vector<std::function<void()>> posted;
+        nlohmann::json replyMetadata;
+        std::function<bool(const std::string&)> hostCellHook;
+        std::function<void()> postHook;
+    };
+}
+
+#endif
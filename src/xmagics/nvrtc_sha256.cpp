@@ -0,0 +1,146 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_sha256.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        std::uint32_t rotr(std::uint32_t x, int n)
+        {
+            return (x >> n) | (x << (32 - n));
+        }
+
+        std::string toHex(const std::string& bytes)
+        {
+            static const char* digits = "0123456789abcdef";
+            std::string result;
+            for (unsigned char c : bytes)
+            {
+                result += digits[c >> 4];
+                result += digits[c & 0xf];
+            }
+            return result;
+        }
+    }
+
+    nvrtc_sha256::nvrtc_sha256()
+    {
+        state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    }
+
+    void nvrtc_sha256::update(const unsigned char* data, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; i++)
+        {
+            block[blockSize++] = data[i];
+            if (blockSize == 64)
+            {
+                transform();
+                bitLength += 512;
+                blockSize = 0;
+            }
+        }
+    }
+
+    void nvrtc_sha256::update(const std::string& data)
+    {
+        update(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    }
+
+    std::string nvrtc_sha256::digest()
+    {
+        std::uint64_t totalBits = bitLength + blockSize * 8;
+        std::size_t padding = blockSize < 56 ? 56 - blockSize : 120 - blockSize;
+        unsigned char pad[128] = {0x80};
+        update(pad, padding);
+        unsigned char length[8];
+        for (int i = 0; i < 8; i++) length[7 - i] = static_cast<unsigned char>(totalBits >> (8 * i));
+        update(length, 8);
+
+        std::string result;
+        for (std::uint32_t word : state)
+        {
+            for (int shift = 24; shift >= 0; shift -= 8) result += static_cast<char>((word >> shift) & 0xff);
+        }
+        return result;
+    }
+
+    std::string nvrtc_sha256::hexdigest()
+    {
+        return toHex(digest());
+    }
+
+    std::string nvrtc_sha256::hmac(const std::string& key, const std::vector<std::string>& parts)
+    {
+        //keys longer than a block are hashed first, shorter ones padded with zeros
+        std::string blockKey = key;
+        if (blockKey.size() > 64)
+        {
+            nvrtc_sha256 keyHash;
+            keyHash.update(blockKey);
+            blockKey = keyHash.digest();
+        }
+        blockKey.resize(64, '\0');
+
+        std::string innerPad(64, '\0'), outerPad(64, '\0');
+        for (std::size_t i = 0; i < 64; i++)
+        {
+            innerPad[i] = static_cast<char>(blockKey[i] ^ 0x36);
+            outerPad[i] = static_cast<char>(blockKey[i] ^ 0x5c);
+        }
+        nvrtc_sha256 inner;
+        inner.update(innerPad);
+        for (const std::string& part : parts) inner.update(part);
+        nvrtc_sha256 outer;
+        outer.update(outerPad);
+        outer.update(inner.digest());
+        return outer.hexdigest();
+    }
+
+    void nvrtc_sha256::transform()
+    {
+        static const std::uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+        {
+            w[i] = (std::uint32_t(block[4 * i]) << 24) | (std::uint32_t(block[4 * i + 1]) << 16)
+                   | (std::uint32_t(block[4 * i + 2]) << 8) | std::uint32_t(block[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; i++)
+        {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        std::array<std::uint32_t, 8> v = state;
+        for (int i = 0; i < 64; i++)
+        {
+            std::uint32_t s1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+            std::uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            std::uint32_t t1 = v[7] + s1 + ch + k[i] + w[i];
+            std::uint32_t s0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+            std::uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            std::uint32_t t2 = s0 + maj;
+            v = {t1 + t2, v[0], v[1], v[2], v[3] + t1, v[4], v[5], v[6]};
+        }
+        for (int i = 0; i < 8; i++) state[i] += v[i];
+    }
+}
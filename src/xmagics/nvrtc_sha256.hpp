@@ -0,0 +1,50 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_SHA256_HPP
+#define XMAGICS_NVRTC_SHA256_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xcpp
+{
+    // minimal SHA-256 (FIPS 180-4), addresses the cache entries and signs the
+    // messages of the doorbell
+    class nvrtc_sha256
+    {
+    public:
+
+        nvrtc_sha256();
+
+        void update(const unsigned char* data, std::size_t size);
+        void update(const std::string& data);
+
+        // 32 bytes, the hash can not be updated afterwards
+        std::string digest();
+        std::string hexdigest();
+
+        // HMAC-SHA256 (RFC 2104) of the concatenated parts as hex string
+        static std::string hmac(const std::string& key, const std::vector<std::string>& parts);
+
+    private:
+
+        void transform();
+
+        std::array<std::uint32_t, 8> state;
+        unsigned char block[64];
+        std::size_t blockSize = 0;
+        std::uint64_t bitLength = 0;
+    };
+}
+
+#endif
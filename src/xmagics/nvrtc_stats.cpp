@@ -0,0 +1,45 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_stats.hpp"
+
+#include <iostream>
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_cache.hpp"
+#include "nvrtc_memory.hpp"
+#include "nvrtc_session.hpp"
+
+namespace xcpp
+{
+    void nvrtc_stats::operator()(const std::string& /*line*/)
+    {
+        const nvrtc_resources& resources = nvrtc_api::instance().resources;
+        nvrtc_cache diskCache;
+
+        std::cout << "NVRTC programs: " << resources.nvrtcPrograms << std::endl;
+        std::cout << "Loaded modules: " << resources.modules << " (" << resources.imageBytes << " bytes of PTX/CUBIN)" << std::endl;
+        std::cout << "Unloaded modules: " << resources.unloadedModules << std::endl;
+        std::cout << "Kernel handles: " << nvrtc_session::instance().kernelCount() << std::endl;
+        cuda::memory_statistics memory = nvrtc_memory_pool::instance().statistics();
+        std::cout << "Device memory: " << memory.bytes_in_use << " bytes in use (peak " << memory.peak_bytes_in_use << "), "
+                  << memory.bytes_cached << " bytes cached" << std::endl;
+        std::cout << "Allocations: " << memory.allocations << " (" << memory.cache_hits << " from the cache, "
+                  << memory.driver_allocations << " cuMemAlloc)" << std::endl;
+        std::cout << "Pinned host memory: " << memory.host_bytes_in_use << " bytes in use, " << memory.host_bytes_cached << " bytes cached" << std::endl;
+        if (diskCache.isEnabled())
+        {
+            std::cout << "Disk cache: " << diskCache.directory() << " (" << diskCache.size() << " of " << diskCache.sizeLimit() << " bytes)" << std::endl;
+        }
+        else
+        {
+            std::cout << "Disk cache: disabled" << std::endl;
+        }
+    }
+}
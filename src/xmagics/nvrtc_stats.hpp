@@ -0,0 +1,28 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_STATS_HPP
+#define XMAGICS_NVRTC_STATS_HPP
+
+#include <string>
+
+#include "xeus-cling/xmagics.hpp"
+
+namespace xcpp
+{
+    // %nvrtc_stats prints the live resources of the %%nvrtc magic
+    class nvrtc_stats: public xmagic_line
+    {
+    public:
+
+        virtual void operator()(const std::string& line) override;
+    };
+}
+
+#endif
@@ -0,0 +1,122 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_streams.hpp"
+
+#include <stdexcept>
+
+#include "nvrtc_memory.hpp"
+
+namespace xcpp
+{
+    nvrtc_stream_pool& nvrtc_stream_pool::instance()
+    {
+        //never destroyed, the contexts may be gone when static objects are destructed
+        static nvrtc_stream_pool* pool = new nvrtc_stream_pool();
+        return *pool;
+    }
+
+    void nvrtc_stream_pool::setContexts(const std::vector<CUcontext>& deviceContexts)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        contexts = deviceContexts;
+        streams.assign(contexts.size(), {});
+    }
+
+    CUcontext nvrtc_stream_pool::context(int device)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (device < 0 || device >= static_cast<int>(contexts.size()))
+        {
+            throw std::out_of_range("No CUDA device " + std::to_string(device) + ", run a %%nvrtc cell first");
+        }
+        return contexts[device];
+    }
+
+    int nvrtc_stream_pool::deviceCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<int>(contexts.size());
+    }
+
+    void nvrtc_stream_pool::setWorkers(std::shared_ptr<nvrtc_device_workers> workers)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        deviceWorkers = std::move(workers);
+    }
+
+    std::shared_ptr<nvrtc_device_workers> nvrtc_stream_pool::workers()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return deviceWorkers;
+    }
+
+    CUstream nvrtc_stream_pool::stream(int device, int index)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (device < 0 || device >= static_cast<int>(contexts.size()) || index < 0)
+        {
+            throw std::out_of_range("No stream " + std::to_string(index) + " on CUDA device " + std::to_string(device));
+        }
+
+        std::vector<CUstream>& deviceStreams = streams[device];
+        if (index < static_cast<int>(deviceStreams.size())) return deviceStreams[index];
+
+        //the streams up to index are created in the context of the device
+        nvrtc_api& api = nvrtc_api::instance();
+        CUcontext previous = nullptr;
+        int result = api.cuda.cuCtxPushCurrent(contexts[device]);
+        while (result == CUDA_API_SUCCESS && index >= static_cast<int>(deviceStreams.size()))
+        {
+            CUstream created = nullptr;
+            result = api.cuda.cuStreamCreate(&created, CU_STREAM_API_NON_BLOCKING);
+            if (result == CUDA_API_SUCCESS) deviceStreams.push_back(created);
+        }
+        api.cuda.cuCtxPopCurrent(&previous);
+        if (result != CUDA_API_SUCCESS)
+        {
+            throw std::runtime_error("Could not create stream on CUDA device " + std::to_string(device) + ": " + api.cudaError(result));
+        }
+        return deviceStreams[index];
+    }
+
+    int nvrtc_stream_pool::synchronizeAll(std::string& error)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nvrtc_api& api = nvrtc_api::instance();
+        int first = CUDA_API_SUCCESS;
+        for (std::size_t device = 0; device < contexts.size(); device++)
+        {
+            CUcontext previous = nullptr;
+            int pushed = api.cuda.cuCtxPushCurrent(contexts[device]);
+            if (pushed != CUDA_API_SUCCESS)
+            {
+                if (first == CUDA_API_SUCCESS) first = pushed;   //the device was not synchronized
+                continue;
+            }
+            //the context synchronization also waits for the default stream and streams of the user
+            for (CUstream s : streams[device])
+            {
+                int result = api.cuda.cuStreamSynchronize(s);
+                if (first == CUDA_API_SUCCESS && result != CUDA_API_SUCCESS) first = result;
+            }
+            int result = api.cuda.cuCtxSynchronize();
+            if (first == CUDA_API_SUCCESS && result != CUDA_API_SUCCESS) first = result;
+            api.cuda.cuCtxPopCurrent(&previous);
+        }
+        if (first != CUDA_API_SUCCESS)
+        {
+            //a failed device may still run work on the freed blocks
+            error = api.cudaError(first);
+            return first;
+        }
+        nvrtc_memory_pool::instance().markSynchronized();   //freed blocks can be used on any stream
+        return first;
+    }
+}
@@ -0,0 +1,59 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_STREAMS_HPP
+#define XMAGICS_NVRTC_STREAMS_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_workers.hpp"
+
+namespace xcpp
+{
+    // Streams per device context of the %%nvrtc magic, created on first use.
+    // The streams are non-blocking, kernels on different streams of a device
+    // can run concurrently and do not wait for the legacy default stream.
+    class nvrtc_stream_pool
+    {
+    public:
+
+        static nvrtc_stream_pool& instance();
+
+        void setContexts(const std::vector<CUcontext>& contexts);
+        CUcontext context(int device);      //throws std::out_of_range for unknown devices
+        int deviceCount();
+
+        // threads with the current context of each device, nullptr for a single device
+        void setWorkers(std::shared_ptr<nvrtc_device_workers> workers);
+        std::shared_ptr<nvrtc_device_workers> workers();
+
+        // throws std::runtime_error if the stream cannot be created
+        CUstream stream(int device, int index);
+
+        // waits for the streams of the pool and all work of the contexts,
+        // returns the first CUDA error, e.g. of a failed kernel; only a full
+        // success frees the cached blocks of the memory pool for other streams
+        int synchronizeAll(std::string& error);
+
+    private:
+
+        nvrtc_stream_pool() = default;
+
+        std::mutex mutex;
+        std::vector<CUcontext> contexts;
+        std::vector<std::vector<CUstream>> streams;     //per device, by index
+        std::shared_ptr<nvrtc_device_workers> deviceWorkers;
+    };
+}
+
+#endif
@@ -0,0 +1,136 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_timings.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace xcpp
+{
+    void nvrtc_timings::add(const std::string& phase, double milliseconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& p : phases)
+        {
+            if (p.first == phase)
+            {
+                p.second += milliseconds;
+                return;
+            }
+        }
+        phases.emplace_back(phase, milliseconds);
+    }
+
+    void nvrtc_timings::addCompilerReport(const std::string& report)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        compilerReport += report;
+    }
+
+    void nvrtc_timings::setStatus(const std::string& name, const std::string& status)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& s : statuses)
+        {
+            if (s.first == name)
+            {
+                s.second = status;
+                return;
+            }
+        }
+        statuses.emplace_back(name, status);
+    }
+
+    nlohmann::json nvrtc_timings::toJson() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nlohmann::json result;
+        result["phases"] = nlohmann::json::object();
+        for (const auto& p : phases)
+        {
+            result["phases"][p.first] = p.second;
+        }
+        for (const auto& s : statuses)
+        {
+            result["status"][s.first] = s.second;
+        }
+        if (!compilerReport.empty()) result["nvrtc_time"] = compilerReport;
+        return result;
+    }
+
+    std::string nvrtc_timings::table() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::size_t width = 5;
+        for (const auto& p : phases) width = std::max(width, p.first.size());
+        for (const auto& s : statuses) width = std::max(width, s.first.size());
+
+        std::ostringstream out;
+        out << std::left << std::setw(static_cast<int>(width)) << "Phase" << "  " << std::right << std::setw(10) << "ms" << std::endl;
+        for (const auto& p : phases)
+        {
+            out << std::left << std::setw(static_cast<int>(width)) << p.first << "  " << std::right << std::setw(10) << std::fixed << std::setprecision(2) << p.second << std::endl;
+        }
+        for (const auto& s : statuses)
+        {
+            out << std::left << std::setw(static_cast<int>(width)) << s.first << "  " << std::right << std::setw(10) << s.second << std::endl;
+        }
+        if (!compilerReport.empty()) out << std::endl << "NVRTC -time:" << std::endl << compilerReport;
+        return out.str();
+    }
+
+    nvrtc_phase::nvrtc_phase(nvrtc_timings* timings, std::string phase)
+        : m_timings(timings), m_phase(std::move(phase)), m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    nvrtc_phase::~nvrtc_phase()
+    {
+        if (m_timings == nullptr) return;
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - m_start;
+        m_timings->add(m_phase, duration.count());
+    }
+
+    nvrtc_total::nvrtc_total(std::shared_ptr<nvrtc_timings> timings, std::function<void(const nvrtc_timings&)> report)
+        : m_timings(std::move(timings)), m_report(std::move(report)), m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    nvrtc_total::~nvrtc_total()
+    {
+        std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - m_start;
+        m_timings->add("total", total.count());
+        try
+        {
+            m_report(*m_timings);
+        }
+        catch (...)
+        {
+            //a failed report must not end a cell that is already unwinding
+        }
+    }
+
+    void logTimings(const nlohmann::json& timings)
+    {
+        std::string line = timings.dump();
+        std::clog << line << std::endl;
+
+        const char* path = std::getenv("XEUS_CLING_NVRTC_TIMING_LOG");
+        if (path != nullptr && *path != '\0')
+        {
+            std::ofstream file(path, std::ios::app);
+            if (file) file << line << std::endl;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_TIMINGS_HPP
+#define XMAGICS_NVRTC_TIMINGS_HPP
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace xcpp
+{
+    // Duration of the phases of the %%nvrtc pipeline in milliseconds. Phases
+    // with the same name are summed up, phases can be added from any thread.
+    class nvrtc_timings
+    {
+    public:
+
+        void add(const std::string& phase, double milliseconds);
+        void addCompilerReport(const std::string& report);   //output of the NVRTC -time option
+        void setStatus(const std::string& name, const std::string& status);    //e.g. cache hits
+
+        nlohmann::json toJson() const;
+        std::string table() const;
+
+    private:
+
+        mutable std::mutex mutex;
+        std::vector<std::pair<std::string, double>> phases;
+        std::string compilerReport;
+        std::vector<std::pair<std::string, std::string>> statuses;
+    };
+
+    // measures the lifetime of the object with a monotonic clock
+    class nvrtc_phase
+    {
+    public:
+
+        nvrtc_phase(nvrtc_timings* timings, std::string phase);
+        ~nvrtc_phase();
+
+        nvrtc_phase(const nvrtc_phase&) = delete;
+        nvrtc_phase& operator=(const nvrtc_phase&) = delete;
+
+    private:
+
+        nvrtc_timings* m_timings;
+        std::string m_phase;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // adds the "total" phase on destruction and passes the timings to report,
+    // so every return of a cell is reported once
+    class nvrtc_total
+    {
+    public:
+
+        nvrtc_total(std::shared_ptr<nvrtc_timings> timings, std::function<void(const nvrtc_timings&)> report);
+        ~nvrtc_total();
+
+        nvrtc_total(const nvrtc_total&) = delete;
+        nvrtc_total& operator=(const nvrtc_total&) = delete;
+
+    private:
+
+        std::shared_ptr<nvrtc_timings> m_timings;
+        std::function<void(const nvrtc_timings&)> m_report;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // writes the timings as one JSON line to std::clog and, if set, to the file
+    // XEUS_CLING_NVRTC_TIMING_LOG
+    void logTimings(const nlohmann::json& timings);
+}
+
+#endif
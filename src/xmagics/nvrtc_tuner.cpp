@@ -0,0 +1,237 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_tuner.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "nvrtc_api.hpp"
+#include "nvrtc_emulator.hpp"
+#include "nvrtc_session.hpp"
+#include "nvrtc_streams.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        constexpr unsigned int DEFAULT_BLOCK = 256;
+        constexpr unsigned int MAX_BLOCK = 1024;
+    }
+
+    nvrtc_tuner& nvrtc_tuner::instance()
+    {
+        static nvrtc_tuner tuner;
+        return tuner;
+    }
+
+    std::size_t nvrtc_tuner::sizeClass(std::size_t problemSize)
+    {
+        std::size_t size = 1;
+        while (size < problemSize) size <<= 1;
+        return size;
+    }
+
+    std::vector<cuda::tuning_candidate> nvrtc_tuner::tune(CUfunction function, const std::vector<std::string>& variants, std::size_t problemSize,
+                                                          const std::vector<unsigned int>& blocks, int repeat, unsigned int sharedMemory,
+                                                          const std::function<int(CUfunction, cuda::dim3, cuda::dim3, CUstream)>& launch)
+    {
+        nvrtc_api& api = nvrtc_api::instance();
+        nvrtc_session& session = nvrtc_session::instance();
+        bool emulated = nvrtc_emulator::instance().isActive();
+        std::string name = "kernel";
+        int device = 0;
+        if (!session.findKernel(function, name, device)) std::cerr << "Autotune: the kernel is not registered by %%nvrtc, the result is not kept" << std::endl;
+
+        //the kernel and the variants on the same device
+        std::vector<std::pair<std::string, CUfunction>> functions = {{name, function}};
+        for (const std::string& variant : variants)
+        {
+            try
+            {
+                std::vector<CUfunction> handles = session.kernel(variant);
+                if (device < static_cast<int>(handles.size()) && handles[device] != nullptr) functions.emplace_back(variant, handles[device]);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Autotune: variant " << variant << ": " << e.what() << std::endl;
+            }
+        }
+
+        CUcontext previous = nullptr;
+        if (!emulated)
+        {
+            try
+            {
+                if (api.cuda.cuCtxPushCurrent(nvrtc_stream_pool::instance().context(device)) != CUDA_API_SUCCESS) return {};
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Autotune: " << e.what() << std::endl;
+                return {};
+            }
+        }
+        int threadsPerMultiprocessor = 0;
+        CUdevice cuDevice = 0;
+        if (!emulated && api.cuda.cuCtxGetDevice != nullptr && api.cuda.cuCtxGetDevice(&cuDevice) == CUDA_API_SUCCESS)
+        {
+            api.cuda.cuDeviceGetAttribute(&threadsPerMultiprocessor, CU_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR, cuDevice);
+        }
+
+        std::vector<cuda::tuning_candidate> results;
+        try
+        {
+            CUstream stream = cuda::stream(device);
+            cuda::event start(device, true);
+            cuda::event stop(device, true);
+            repeat = std::max(repeat, 1);
+            for (const auto& entry : functions)
+            {
+                //the occupancy calculator seeds the sweep, the limit of the kernel bounds it
+                int limit = MAX_BLOCK;
+                if (!emulated && api.cuda.cuFuncGetAttribute != nullptr) api.cuda.cuFuncGetAttribute(&limit, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, entry.second);
+                unsigned int suggested = 0;
+                if (!emulated)
+                {
+                    //the suggestions are shared with tuned, called by launches of other threads
+                    std::lock_guard<std::mutex> lock(mutex);
+                    suggested = suggestedBlock(entry.second, sharedMemory);
+                }
+                std::vector<unsigned int> sizes = blocks;
+                if (sizes.empty())
+                {
+                    if (suggested > 0) sizes.push_back(suggested);
+                    for (unsigned int b = 32; b <= MAX_BLOCK; b *= 2)
+                    {
+                        if (b != suggested) sizes.push_back(b);
+                    }
+                }
+
+                for (unsigned int block : sizes)
+                {
+                    if (block == 0 || static_cast<int>(block) > limit) continue;
+                    cuda::tuning_candidate candidate = {entry.first, block, -1.0, 0.0, block == suggested};
+                    cuda::dim3 grid(static_cast<unsigned int>((problemSize + block - 1) / block));
+
+                    //the first launch loads the module and warms the caches, it is not timed
+                    int result = launch(entry.second, grid, cuda::dim3(block), stream);
+                    if (result == CUDA_API_SUCCESS) result = start.record(stream);
+                    for (int i = 0; i < repeat && result == CUDA_API_SUCCESS; i++) result = launch(entry.second, grid, cuda::dim3(block), stream);
+                    if (result == CUDA_API_SUCCESS) result = stop.record(stream);
+                    if (result == CUDA_API_SUCCESS) result = stop.synchronize();
+                    if (result == CUDA_API_SUCCESS) candidate.milliseconds = stop.elapsed_ms(start) / repeat;
+                    else std::cerr << "Autotune: " << entry.first << " with " << block << " threads: " << api.cudaError(result) << std::endl;
+
+                    int active = 0;
+                    if (threadsPerMultiprocessor > 0 && api.cuda.cuOccupancyMaxActiveBlocksPerMultiprocessor != nullptr
+                        && api.cuda.cuOccupancyMaxActiveBlocksPerMultiprocessor(&active, entry.second, static_cast<int>(block), sharedMemory) == CUDA_API_SUCCESS)
+                    {
+                        candidate.occupancy = static_cast<double>(active) * block / threadsPerMultiprocessor;
+                    }
+                    results.push_back(candidate);
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Autotune: " << e.what() << std::endl;
+        }
+        if (!emulated) api.cuda.cuCtxPopCurrent(&previous);
+
+        //fastest first, failed launches last
+        std::stable_sort(results.begin(), results.end(), [](const cuda::tuning_candidate& a, const cuda::tuning_candidate& b)
+        {
+            if ((a.milliseconds < 0) != (b.milliseconds < 0)) return b.milliseconds < 0;
+            return a.milliseconds < b.milliseconds;
+        });
+        if (!results.empty() && results.front().milliseconds < 0) results.clear();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!results.empty() && session.findKernel(function, name, device))
+        {
+            winners[std::make_tuple(name, device, sizeClass(problemSize))] = {results.front().kernel, results.front().block};
+        }
+        candidates = results;
+        kernel = name;
+        return results;
+    }
+
+    unsigned int nvrtc_tuner::tuned(CUfunction function, std::size_t problemSize, unsigned int sharedMemory, CUfunction& result)
+    {
+        result = function;
+        std::string name;
+        int device = 0;
+        nvrtc_session& session = nvrtc_session::instance();
+        if (session.findKernel(function, name, device))
+        {
+            winner best;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = winners.find(std::make_tuple(name, device, sizeClass(problemSize)));
+                if (it != winners.end())
+                {
+                    best = it->second;
+                    found = true;
+                }
+            }
+            if (found)
+            {
+                //a variant which is no longer available falls back to the kernel
+                if (best.kernel != name)
+                {
+                    try
+                    {
+                        std::vector<CUfunction> handles = session.kernel(best.kernel);
+                        if (device < static_cast<int>(handles.size()) && handles[device] != nullptr) result = handles[device];
+                    }
+                    catch (const std::exception&)
+                    {
+                    }
+                }
+                return best.block;
+            }
+        }
+        if (nvrtc_emulator::instance().isActive()) return DEFAULT_BLOCK;
+        std::lock_guard<std::mutex> lock(mutex);
+        unsigned int block = suggestedBlock(function, sharedMemory);
+        return block > 0 ? block : DEFAULT_BLOCK;
+    }
+
+    unsigned int nvrtc_tuner::suggestedBlock(CUfunction function, unsigned int sharedMemory)
+    {
+        //the occupancy calculator is called once per function
+        auto key = std::make_pair(function, sharedMemory);
+        auto found = suggestions.find(key);
+        if (found != suggestions.end()) return found->second;
+        nvrtc_api& api = nvrtc_api::instance();
+        int minGridSize = 0;
+        int blockSize = 0;
+        if (api.cuda.cuOccupancyMaxPotentialBlockSize == nullptr
+            || api.cuda.cuOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, function, nullptr, sharedMemory, 0) != CUDA_API_SUCCESS)
+        {
+            blockSize = 0;
+        }
+        suggestions[key] = static_cast<unsigned int>(blockSize);
+        return static_cast<unsigned int>(blockSize);
+    }
+
+    std::vector<cuda::tuning_candidate> nvrtc_tuner::lastCandidates()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return candidates;
+    }
+
+    std::string nvrtc_tuner::lastKernel()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return kernel;
+    }
+}
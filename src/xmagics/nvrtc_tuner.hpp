@@ -0,0 +1,68 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_TUNER_HPP
+#define XMAGICS_NVRTC_TUNER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xcpp/xcuda.hpp"
+
+namespace xcpp
+{
+    // Block size autotuner of xcpp::cuda::autotune and %nvrtc_autotune. The
+    // candidates are timed with CUDA events on the first stream of the device,
+    // the winner is kept per kernel, device and problem size class for
+    // typed_kernel::launch_n.
+    class nvrtc_tuner
+    {
+    public:
+
+        static nvrtc_tuner& instance();
+
+        std::vector<cuda::tuning_candidate> tune(CUfunction function, const std::vector<std::string>& variants, std::size_t problemSize,
+                                                 const std::vector<unsigned int>& blocks, int repeat, unsigned int sharedMemory,
+                                                 const std::function<int(CUfunction, cuda::dim3, cuda::dim3, CUstream)>& launch);
+
+        unsigned int tuned(CUfunction function, std::size_t problemSize, unsigned int sharedMemory, CUfunction& result);
+
+        // candidates of the last tune call, e.g. for the table of the magic
+        std::vector<cuda::tuning_candidate> lastCandidates();
+        std::string lastKernel();
+
+        static std::size_t sizeClass(std::size_t problemSize);     //next power of two
+
+    private:
+
+        struct winner
+        {
+            std::string kernel;
+            unsigned int block;
+        };
+
+        nvrtc_tuner() = default;
+
+        unsigned int suggestedBlock(CUfunction function, unsigned int sharedMemory);    //with the lock
+
+        std::mutex mutex;
+        std::map<std::tuple<std::string, int, std::size_t>, winner> winners;     //kernel, device and size class
+        std::map<std::pair<CUfunction, unsigned int>, unsigned int> suggestions;  //occupancy suggestion per function and shared memory
+        std::vector<cuda::tuning_candidate> candidates;
+        std::string kernel;
+    };
+}
+
+#endif
@@ -0,0 +1,88 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include "nvrtc_workers.hpp"
+
+namespace xcpp
+{
+    nvrtc_device_workers::~nvrtc_device_workers()
+    {
+        for (auto& w : workers)
+        {
+            {
+                std::lock_guard<std::mutex> lock(w->mutex);
+                w->stop = true;
+            }
+            w->condition.notify_one();
+        }
+        for (auto& w : workers)
+        {
+            if (w->thread.joinable()) w->thread.join();
+        }
+    }
+
+    void nvrtc_device_workers::start(const std::vector<CUcontext>& contexts)
+    {
+        for (CUcontext context : contexts)
+        {
+            workers.push_back(std::make_unique<worker>());
+            worker& w = *workers.back();
+            w.thread = std::thread(&nvrtc_device_workers::run, std::ref(w), context);
+        }
+    }
+
+    std::size_t nvrtc_device_workers::size() const
+    {
+        return workers.size();
+    }
+
+    std::future<void> nvrtc_device_workers::submit(int device, std::function<void()> task)
+    {
+        worker& w = *workers.at(device);
+        std::packaged_task<void()> packaged(std::move(task));
+        std::future<void> result = packaged.get_future();
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.tasks.push_back(std::move(packaged));
+        }
+        w.condition.notify_one();
+        return result;
+    }
+
+    void nvrtc_device_workers::runOnAll(const std::function<void(int)>& task)
+    {
+        std::vector<std::future<void>> results;
+        for (std::size_t i = 0; i < workers.size(); i++)
+        {
+            int device = static_cast<int>(i);
+            results.push_back(submit(device, [&task, device]() { task(device); }));
+        }
+        for (std::future<void>& result : results)
+        {
+            result.get();   //rethrows exceptions of the worker
+        }
+    }
+
+    void nvrtc_device_workers::run(worker& w, CUcontext context)
+    {
+        nvrtc_api::instance().cuda.cuCtxSetCurrent(context);
+        while (true)
+        {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(w.mutex);
+                w.condition.wait(lock, [&w]() { return w.stop || !w.tasks.empty(); });
+                if (w.tasks.empty()) return;    //stop only after the queue is drained
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+            }
+            task();
+        }
+    }
+}
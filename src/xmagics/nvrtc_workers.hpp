@@ -0,0 +1,64 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XMAGICS_NVRTC_WORKERS_HPP
+#define XMAGICS_NVRTC_WORKERS_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "nvrtc_api.hpp"
+
+namespace xcpp
+{
+    // One worker thread per CUDA context. The context is made current once when
+    // the thread starts, tasks for a device then run without context switches.
+    class nvrtc_device_workers
+    {
+    public:
+
+        nvrtc_device_workers() = default;
+        ~nvrtc_device_workers();
+
+        nvrtc_device_workers(const nvrtc_device_workers&) = delete;
+        nvrtc_device_workers& operator=(const nvrtc_device_workers&) = delete;
+
+        void start(const std::vector<CUcontext>& contexts);
+        std::size_t size() const;
+
+        // queue a task on the thread of the device
+        std::future<void> submit(int device, std::function<void()> task);
+
+        // run task(device) concurrently on all devices and wait for completion
+        void runOnAll(const std::function<void(int)>& task);
+
+    private:
+
+        struct worker
+        {
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::deque<std::packaged_task<void()>> tasks;
+            bool stop = false;
+        };
+
+        static void run(worker& w, CUcontext context);
+
+        std::vector<std::unique_ptr<worker>> workers;
+    };
+}
+
+#endif
@@ -0,0 +1,82 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+// Throughput of scanSource on a generated source of several MB with many
+// kernels, device functions, raw strings, string literals and comments, the
+// text the lexer replaced the regular expressions for.
+//
+//     benchmark_nvrtc_lexer [size MB] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "nvrtc_lexer.hpp"
+
+namespace
+{
+    // one block of about 1 KB with a kernel, a device function and the
+    // constructs the lexer has to skip
+    std::string block(std::size_t i)
+    {
+        std::string n = std::to_string(i);
+        return "#include \"header" + n + ".cuh\"\n"
+               "// __global__ void commented" + n + "(int n) {}\n"
+               "/* block comment with \"quotes\" and #include <ignored.h>\n"
+               "   __global__ void inComment" + n + "() {} */\n"
+               "const char* text" + n + " = \"__global__ void quoted(int) /* not a comment */\";\n"
+               "const char* raw" + n + " = R\"cuda(__global__ void raw() { \"// )\" })cuda\";\n"
+               "const char quote" + n + " = '\\'';\n"
+               "__device__ float helper" + n + "(float x) { return x * x + 1.0f; }\n"
+               "template <typename T>\n"
+               "__global__ void fill" + n + "(T* x, T value, int n) { int i = threadIdx.x; if (i < n) x[i] = value; }\n"
+               "__global__ void __launch_bounds__(256) saxpy" + n + "(float a, const float* __restrict__ x /* input */,\n"
+               "                                                   float* y, int n)\n"
+               "{\n"
+               "    int i = blockIdx.x * blockDim.x + threadIdx.x;   // global index\n"
+               "    if (i < n) y[i] = a * x[i] + helper" + n + "(y[i]);\n"
+               "}\n\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 4.0;
+    int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+
+    std::string code;
+    std::size_t blocks = 0;
+    while (code.size() < megabytes * 1024 * 1024) code += block(blocks++);
+
+    std::vector<double> times;
+    xcpp::nvrtc_source source;
+    for (int run = 0; run < repetitions; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        source = xcpp::scanSource(code);
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+
+    //every block has two kernels, one device function and one include
+    if (source.kernels.size() != 2 * blocks || source.deviceFunctions.size() != blocks || source.includes.size() != blocks)
+    {
+        std::fprintf(stderr, "unexpected scan: %zu kernels, %zu device functions, %zu includes for %zu blocks\n",
+                     source.kernels.size(), source.deviceFunctions.size(), source.includes.size(), blocks);
+        return 1;
+    }
+    double median = times[times.size() / 2];
+    std::printf("source %.2f MB, %zu kernels, %zu lines\n", code.size() / (1024.0 * 1024.0), source.kernels.size(), source.lineOffsets.size());
+    std::printf("scanSource median %.1f ms, min %.1f ms, %.0f MB/s\n", median, times.front(), code.size() / (1024.0 * 1024.0) / (median / 1000.0));
+    return 0;
+}
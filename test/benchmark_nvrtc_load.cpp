@@ -0,0 +1,93 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+// Latency of buildProgram with 1 to MAX_DEVICE_COUNT stub devices. The stub
+// cuModuleLoadData sleeps like the driver JIT, so the time shows whether the
+// modules of the devices are loaded concurrently: it stays near one load
+// delay, a serial load grows with the device count.
+//
+//     benchmark_nvrtc_load [delay ms] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nvrtc_compiler.hpp"
+
+#include "stub_driver.hpp"
+#include "test_nvrtc_utils.hpp"
+
+namespace
+{
+    const char* kernels =
+        "extern \"C\" __global__ void scale(float* x, float a, int n) {}\n"
+        "extern \"C\" __global__ void saxpy(float a, const float* x, float* y, int n) {}\n"
+        "extern \"C\" __global__ void reduce(const float* x, float* sum, int n) {}\n";
+
+    // median time of a build which loads the cached image on count devices
+    double buildTime(int count, int repetitions)
+    {
+        std::vector<CUcontext> contexts = test::stubContexts(count);
+        auto workers = std::make_shared<xcpp::nvrtc_device_workers>();
+        if (count > 1) workers->start(contexts);
+        xcpp::nvrtc_compiler compiler;
+        compiler.setDevices(contexts, workers);
+
+        std::vector<double> times;
+        for (int run = 0; run <= repetitions; run++)
+        {
+            xcpp::nvrtc_build build;
+            build.code = kernels;
+            build.cacheKey = xcpp::nvrtc_cache::fingerprint({build.code});
+            build.targets.emplace_back();
+            for (int i = 0; i < count; i++) build.targets[0].devices.push_back(i);
+
+            auto start = std::chrono::steady_clock::now();
+            if (compiler.buildProgram(build) != 0)
+            {
+                std::fprintf(stderr, "build failed:\n%s", build.errors.c_str());
+                std::exit(1);
+            }
+            auto end = std::chrono::steady_clock::now();
+            if (run > 0) times.push_back(std::chrono::duration<double, std::milli>(end - start).count());  //the first run compiles
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string delay = argc > 1 ? argv[1] : "50";
+    int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+    setenv(stub::LOAD_DELAY_VARIABLE, delay.c_str(), 1);
+    if (!test::loadStubDriver())
+    {
+        std::fprintf(stderr, "could not load the stub driver %s\n", STUB_DRIVER_LIBRARY);
+        return 1;
+    }
+    std::filesystem::path directory = test::cacheDirectory("benchmark_load");
+
+    double loadDelay = std::atof(delay.c_str());
+    std::printf("module load delay %s ms, median of %d builds\n\n", delay.c_str(), repetitions);
+    std::printf("%8s %12s %12s %10s\n", "devices", "build ms", "serial ms", "speedup");
+    for (int count = 1; count <= stub::MAX_DEVICE_COUNT; count++)
+    {
+        double time = buildTime(count, repetitions);
+        double serial = count * loadDelay;
+        std::printf("%8d %12.1f %12.1f %10.2f\n", count, time, serial, time > 0 ? serial / time : 0.0);
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,323 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+// Stub of libcuda and libnvrtc with the symbols the %%nvrtc magic loads. The
+// devices are host memory, launches do nothing and modules know the .entry
+// functions of their image.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xcpp/xcuda.hpp"
+
+#include "stub_driver.hpp"
+
+typedef struct _nvrtcProgram* nvrtcProgram;
+
+namespace
+{
+    constexpr int SUCCESS = 0;
+    constexpr int ERROR_INVALID_VALUE = 1;
+    constexpr int ERROR_INVALID_CONTEXT = 201;
+    constexpr int ERROR_NOT_FOUND = 500;
+
+    stub::context contexts[stub::MAX_DEVICE_COUNT] = {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}};
+    thread_local std::vector<stub::context*> current;    //top is the current context
+
+    stub::context* currentContext()
+    {
+        return current.empty() ? nullptr : current.back();
+    }
+
+    std::chrono::milliseconds loadDelay()
+    {
+        static const std::chrono::milliseconds delay = []()
+        {
+            const char* value = std::getenv(stub::LOAD_DELAY_VARIABLE);
+            return std::chrono::milliseconds(value != nullptr ? std::atoi(value) : 0);
+        }();
+        return delay;
+    }
+
+    bool isIdentifierChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    // one .entry per "__global__ void name(" of the source
+    std::string stubPTX(const std::string& source)
+    {
+        std::string ptx = "//\n// stub PTX\n//\n.version 8.0\n.target sm_80\n.address_size 64\n\n";
+        const std::string marker = "__global__ void ";
+        for (std::size_t start = source.find(marker); start != std::string::npos; start = source.find(marker, start + 1))
+        {
+            std::size_t end = start + marker.size();
+            while (end < source.size() && isIdentifierChar(source[end])) end++;
+            std::string name = source.substr(start + marker.size(), end - start - marker.size());
+            ptx += "\t// .globl\t" + name + "\n.visible .entry " + name + "()\n{\n\tret;\n}\n";
+        }
+        return ptx;
+    }
+}
+
+extern "C"
+{
+    int cuInit(unsigned int) { return SUCCESS; }
+
+    int cuGetErrorString(int, const char** str)
+    {
+        *str = "stub driver error";
+        return SUCCESS;
+    }
+
+    int cuDeviceGetCount(int* count)
+    {
+        *count = stub::DEVICE_COUNT;
+        return SUCCESS;
+    }
+
+    int cuDeviceGet(CUdevice* device, int ordinal)
+    {
+        if (ordinal < 0 || ordinal >= stub::MAX_DEVICE_COUNT) return ERROR_INVALID_VALUE;
+        *device = ordinal;
+        return SUCCESS;
+    }
+
+    int cuDeviceGetName(char* name, int len, CUdevice device)
+    {
+        std::string text = "Stub GPU " + std::to_string(device);
+        std::strncpy(name, text.c_str(), static_cast<std::size_t>(len));
+        return SUCCESS;
+    }
+
+    int cuDeviceGetAttribute(int* value, int attribute, CUdevice)
+    {
+        *value = attribute == 75 ? 8 : 0;   //compute capability 8.0
+        return SUCCESS;
+    }
+
+    int cuCtxCreate_v2(CUcontext* context, unsigned int, CUdevice device)
+    {
+        if (device < 0 || device >= stub::MAX_DEVICE_COUNT) return ERROR_INVALID_VALUE;
+        *context = reinterpret_cast<CUcontext>(&contexts[device]);
+        current.assign(1, &contexts[device]);
+        return SUCCESS;
+    }
+
+    int cuCtxSetCurrent(CUcontext context)
+    {
+        current.assign(1, reinterpret_cast<stub::context*>(context));
+        return SUCCESS;
+    }
+
+    int cuCtxPushCurrent_v2(CUcontext context)
+    {
+        if (context == nullptr) return ERROR_INVALID_CONTEXT;
+        current.push_back(reinterpret_cast<stub::context*>(context));
+        return SUCCESS;
+    }
+
+    int cuCtxPopCurrent_v2(CUcontext* context)
+    {
+        if (current.empty()) return ERROR_INVALID_CONTEXT;
+        if (context != nullptr) *context = reinterpret_cast<CUcontext>(current.back());
+        current.pop_back();
+        return SUCCESS;
+    }
+
+    int cuModuleLoadData(CUmodule* module, const void* image)
+    {
+        if (currentContext() == nullptr) return ERROR_INVALID_CONTEXT;
+        if (loadDelay().count() > 0) std::this_thread::sleep_for(loadDelay());
+        auto* loaded = new stub::module{currentContext()->device, static_cast<const char*>(image), {}};
+        *module = reinterpret_cast<CUmodule>(loaded);
+        return SUCCESS;
+    }
+
+    int cuModuleUnload(CUmodule module)
+    {
+        auto* loaded = reinterpret_cast<stub::module*>(module);
+        for (stub::function* function : loaded->functions) delete function;
+        delete loaded;
+        return SUCCESS;
+    }
+
+    int cuModuleGetFunction(CUfunction* function, CUmodule module, const char* name)
+    {
+        auto* loaded = reinterpret_cast<stub::module*>(module);
+        std::string entry = ".entry " + std::string(name) + "(";
+        if (loaded->image.find(entry) == std::string::npos) return ERROR_NOT_FOUND;
+        loaded->functions.push_back(new stub::function{name, loaded->device});
+        *function = reinterpret_cast<CUfunction>(loaded->functions.back());
+        return SUCCESS;
+    }
+
+    int cuLaunchKernel(CUfunction, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int,
+                       unsigned int, CUstream, void**, void**)
+    {
+        return SUCCESS;
+    }
+
+    int cuCtxSynchronize()
+    {
+        const char* value = std::getenv(stub::SYNC_ERROR_VARIABLE);
+        return value != nullptr ? std::atoi(value) : SUCCESS;
+    }
+
+    int cuStreamCreate(CUstream* stream, unsigned int)
+    {
+        *stream = reinterpret_cast<CUstream>(new int(0));
+        return SUCCESS;
+    }
+
+    int cuStreamDestroy_v2(CUstream stream)
+    {
+        delete reinterpret_cast<int*>(stream);
+        return SUCCESS;
+    }
+
+    int cuStreamSynchronize(CUstream) { return SUCCESS; }
+    int cuStreamWaitEvent(CUstream, CUevent, unsigned int) { return SUCCESS; }
+
+    int cuEventCreate(CUevent* event, unsigned int)
+    {
+        *event = reinterpret_cast<CUevent>(new int(0));
+        return SUCCESS;
+    }
+
+    int cuEventDestroy_v2(CUevent event)
+    {
+        delete reinterpret_cast<int*>(event);
+        return SUCCESS;
+    }
+
+    int cuEventRecord(CUevent, CUstream) { return SUCCESS; }
+    int cuEventSynchronize(CUevent) { return SUCCESS; }
+
+    int cuEventElapsedTime(float* milliseconds, CUevent, CUevent)
+    {
+        *milliseconds = 0.0f;
+        return SUCCESS;
+    }
+
+    int cuMemAlloc_v2(CUdeviceptr* pointer, std::size_t bytes)
+    {
+        *pointer = reinterpret_cast<CUdeviceptr>(std::malloc(bytes));
+        return *pointer != 0 ? SUCCESS : 2;
+    }
+
+    int cuMemFree_v2(CUdeviceptr pointer)
+    {
+        std::free(reinterpret_cast<void*>(pointer));
+        return SUCCESS;
+    }
+
+    int cuMemHostAlloc(void** pointer, std::size_t bytes, unsigned int)
+    {
+        *pointer = std::malloc(bytes);
+        return *pointer != nullptr ? SUCCESS : 2;
+    }
+
+    int cuMemFreeHost(void* pointer)
+    {
+        std::free(pointer);
+        return SUCCESS;
+    }
+
+    int cuMemcpyHtoD_v2(CUdeviceptr destination, const void* source, std::size_t bytes)
+    {
+        std::memcpy(reinterpret_cast<void*>(destination), source, bytes);
+        return SUCCESS;
+    }
+
+    int cuMemcpyDtoH_v2(void* destination, CUdeviceptr source, std::size_t bytes)
+    {
+        std::memcpy(destination, reinterpret_cast<const void*>(source), bytes);
+        return SUCCESS;
+    }
+
+    int cuMemcpyHtoDAsync_v2(CUdeviceptr destination, const void* source, std::size_t bytes, CUstream)
+    {
+        return cuMemcpyHtoD_v2(destination, source, bytes);
+    }
+
+    int cuMemcpyDtoHAsync_v2(void* destination, CUdeviceptr source, std::size_t bytes, CUstream)
+    {
+        return cuMemcpyDtoH_v2(destination, source, bytes);
+    }
+
+    int nvrtcVersion(int* major, int* minor)
+    {
+        *major = 12;
+        *minor = 0;
+        return SUCCESS;
+    }
+
+    const char* nvrtcGetErrorString(int)
+    {
+        return "stub NVRTC error";
+    }
+
+    int nvrtcCreateProgram(nvrtcProgram* prog, const char* src, const char*, int, const char* const*, const char* const*)
+    {
+        *prog = reinterpret_cast<nvrtcProgram>(new stub::program{src, ""});
+        return SUCCESS;
+    }
+
+    int nvrtcDestroyProgram(nvrtcProgram* prog)
+    {
+        delete reinterpret_cast<stub::program*>(*prog);
+        *prog = nullptr;
+        return SUCCESS;
+    }
+
+    int nvrtcCompileProgram(nvrtcProgram prog, int, const char* const*)
+    {
+        auto* program = reinterpret_cast<stub::program*>(prog);
+        program->ptx = stubPTX(program->source);
+        return SUCCESS;
+    }
+
+    int nvrtcGetPTXSize(nvrtcProgram prog, std::size_t* ptxSize)
+    {
+        *ptxSize = reinterpret_cast<stub::program*>(prog)->ptx.size() + 1;
+        return SUCCESS;
+    }
+
+    int nvrtcGetPTX(nvrtcProgram prog, char* ptx)
+    {
+        const std::string& text = reinterpret_cast<stub::program*>(prog)->ptx;
+        std::memcpy(ptx, text.c_str(), text.size() + 1);
+        return SUCCESS;
+    }
+
+    int nvrtcGetProgramLogSize(nvrtcProgram, std::size_t* logSize)
+    {
+        *logSize = 1;
+        return SUCCESS;
+    }
+
+    int nvrtcGetProgramLog(nvrtcProgram, char* log)
+    {
+        log[0] = '\0';
+        return SUCCESS;
+    }
+
+    int nvrtcAddNameExpression(nvrtcProgram, const char*) { return SUCCESS; }
+
+    int nvrtcGetLoweredName(nvrtcProgram, const char* nameExpression, const char** loweredName)
+    {
+        *loweredName = nameExpression;
+        return SUCCESS;
+    }
+}
@@ -0,0 +1,56 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XEUS_CLING_TEST_STUB_DRIVER_HPP
+#define XEUS_CLING_TEST_STUB_DRIVER_HPP
+
+#include <string>
+#include <vector>
+
+// Objects behind the handles of the stub driver, the tests cast the handles
+// back to check on which device and for which kernel they were created.
+namespace stub
+{
+    constexpr int DEVICE_COUNT = 2;         //reported by cuDeviceGetCount
+    constexpr int MAX_DEVICE_COUNT = 8;     //contexts the benchmarks can create
+
+    // cuModuleLoadData sleeps this long, like the driver JIT of a real image
+    constexpr const char* LOAD_DELAY_VARIABLE = "XEUS_CLING_STUB_LOAD_DELAY_MS";
+
+    // cuCtxSynchronize returns this error while the variable is set, like after a failed kernel
+    constexpr const char* SYNC_ERROR_VARIABLE = "XEUS_CLING_STUB_SYNC_ERROR";
+
+    struct context
+    {
+        int device;
+    };
+
+    struct function
+    {
+        std::string name;
+        int device;
+    };
+
+    struct module
+    {
+        int device;
+        std::string image;
+        std::vector<function*> functions;   //owned, deleted by cuModuleUnload
+    };
+
+    // the stub NVRTC returns a PTX with one .entry per extern "C" __global__ function
+    // of the source, other functions exist only in the text of the image
+    struct program
+    {
+        std::string source;
+        std::string ptx;
+    };
+}
+
+#endif
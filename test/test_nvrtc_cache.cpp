@@ -0,0 +1,130 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "doctest/doctest.h"
+
+#include "nvrtc_cache.hpp"
+
+#include "test_nvrtc_utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace xcpp
+{
+    namespace
+    {
+        void writeFile(const fs::path& path, std::size_t size)
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << std::string(size, 'x');
+        }
+
+        std::size_t temporaryFiles(const fs::path& directory)
+        {
+            std::size_t count = 0;
+            for (const fs::directory_entry& file : fs::directory_iterator(directory))
+            {
+                if (file.path().extension() == ".tmp") count++;
+            }
+            return count;
+        }
+    }
+
+    TEST_SUITE("nvrtc_cache")
+    {
+        TEST_CASE("fingerprint")
+        {
+            //SHA-256 of the empty input
+            CHECK_EQ(nvrtc_cache::fingerprint({}), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+            CHECK_EQ(nvrtc_cache::fingerprint({"a", "b"}), nvrtc_cache::fingerprint({"a", "b"}));
+            CHECK_EQ(nvrtc_cache::fingerprint({"a", "b"}).size(), 64);
+            //the parts are prefixed with their length, moving a character changes the key
+            CHECK_NE(nvrtc_cache::fingerprint({"ab", "c"}), nvrtc_cache::fingerprint({"a", "bc"}));
+            CHECK_NE(nvrtc_cache::fingerprint({"abc"}), nvrtc_cache::fingerprint({"ab", "c"}));
+        }
+
+        TEST_CASE("store and load")
+        {
+            fs::path directory = test::cacheDirectory("store");
+            nvrtc_cache cache;
+            REQUIRE(cache.isEnabled());
+            CHECK_EQ(cache.directory(), directory.string());
+
+            std::string image;
+            CHECK_FALSE(cache.load("key", "ptx", image));
+            cache.store("key", "ptx", std::string("ptx\0image", 9));
+            REQUIRE(cache.load("key", "ptx", image));
+            CHECK_EQ(image, std::string("ptx\0image", 9));
+            CHECK_FALSE(cache.load("key", "cubin", image));
+
+            //an entry is replaced as a whole, no temporary file is left
+            cache.store("key", "ptx", "new");
+            REQUIRE(cache.load("key", "ptx", image));
+            CHECK_EQ(image, "new");
+            CHECK_EQ(temporaryFiles(directory), 0);
+            CHECK_EQ(cache.size(), 3);
+            fs::remove_all(directory);
+        }
+
+        TEST_CASE("size limit")
+        {
+            fs::path directory = test::cacheDirectory("evict", "1");
+            nvrtc_cache cache;
+            REQUIRE(cache.isEnabled());
+            REQUIRE_EQ(cache.sizeLimit(), 1 << 20);
+            const std::size_t size = 400000;
+
+            cache.store("a", "ptx", std::string(size, 'a'));
+            cache.store("b", "ptx", std::string(size, 'b'));
+
+            //the precompiled headers of a running compile
+            std::string pchPath;
+            auto lease = std::make_unique<nvrtc_cache_lease>();
+            CHECK_FALSE(cache.directoryEntry("p", "pch", pchPath, *lease));
+            writeFile(fs::path(pchPath) / "header.pch", size);
+            cache.trim(pchPath);
+
+            //a burst of writes does not pass the limit, the least recently used entry goes
+            CHECK_FALSE(fs::exists(directory / "a.ptx"));
+            CHECK(fs::exists(directory / "b.ptx"));
+            CHECK(fs::exists(pchPath));
+            CHECK_LE(cache.size(), cache.sizeLimit());
+
+            //temporary files of concurrent writers, one of them left behind by a crash
+            writeFile(directory / "c.ptx.1.2.3.tmp", 10);
+            writeFile(directory / "d.ptx.1.2.4.tmp", 10);
+            test::age(directory / "d.ptx.1.2.4.tmp", std::chrono::minutes(120));
+
+            test::age(pchPath, std::chrono::minutes(150));
+            test::age(directory / "b.ptx", std::chrono::minutes(90));
+            cache.store("c", "ptx", std::string(size, 'c'));
+
+            //least recently used first, the leased directory is skipped
+            CHECK_FALSE(fs::exists(directory / "b.ptx"));
+            CHECK(fs::exists(directory / "c.ptx"));
+            CHECK(fs::exists(pchPath));
+            CHECK(fs::exists(directory / "c.ptx.1.2.3.tmp"));
+            CHECK_FALSE(fs::exists(directory / "d.ptx.1.2.4.tmp"));
+
+            //without the lease the directory is an entry like the others
+            lease.reset();
+            test::age(directory / "c.ptx", std::chrono::minutes(60));
+            cache.store("d", "ptx", std::string(size, 'd'));
+            CHECK_FALSE(fs::exists(pchPath));
+            CHECK(fs::exists(directory / "c.ptx"));
+            CHECK(fs::exists(directory / "d.ptx"));
+            CHECK_LE(cache.size(), cache.sizeLimit());
+            fs::remove_all(directory);
+        }
+    }
+}
@@ -0,0 +1,285 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "nvrtc_compiler.hpp"
+
+#include "stub_driver.hpp"
+#include "test_nvrtc_utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace xcpp
+{
+    namespace
+    {
+        // ELF64 image with a symbol table, like the CUBIN of NVRTC
+        class elf_builder
+        {
+        public:
+
+            // info is (binding << 4) | type, section 0 is an undefined symbol
+            void addSymbol(const std::string& name, unsigned char info, std::uint16_t section)
+            {
+                symbols.push_back({static_cast<std::uint32_t>(strings.size()), info, section});
+                strings += name + '\0';
+            }
+
+            std::string image() const
+            {
+                const std::size_t symbolSize = 24, sectionSize = 64;
+                std::string symbolTable(symbolSize, '\0');     //symbol 0 is always empty
+                for (const symbol& s : symbols)
+                {
+                    std::string entry(symbolSize, '\0');
+                    write(entry, 0, s.name, 4);
+                    write(entry, 4, s.info, 1);
+                    write(entry, 6, s.section, 2);
+                    symbolTable += entry;
+                }
+
+                std::string elf(64, '\0');
+                elf.replace(0, 5, "\x7f" "ELF\x02");
+                std::size_t symbolOffset = elf.size();
+                std::size_t stringOffset = symbolOffset + symbolTable.size();
+                std::size_t sectionOffset = stringOffset + strings.size();
+                write(elf, 0x28, sectionOffset, 8);
+                write(elf, 0x3A, sectionSize, 2);
+                write(elf, 0x3C, 3, 2);
+                elf += symbolTable + strings;
+
+                //null section, .symtab linked to .strtab, .strtab
+                std::string sections(3 * sectionSize, '\0');
+                write(sections, sectionSize + 4, 2, 4);
+                write(sections, sectionSize + 24, symbolOffset, 8);
+                write(sections, sectionSize + 32, symbolTable.size(), 8);
+                write(sections, sectionSize + 40, 2, 4);
+                write(sections, sectionSize + 56, symbolSize, 8);
+                write(sections, 2 * sectionSize + 4, 3, 4);
+                write(sections, 2 * sectionSize + 24, stringOffset, 8);
+                write(sections, 2 * sectionSize + 32, strings.size(), 8);
+                return elf + sections;
+            }
+
+        private:
+
+            struct symbol
+            {
+                std::uint32_t name;
+                unsigned char info;
+                std::uint16_t section;
+            };
+
+            static void write(std::string& data, std::size_t offset, std::uint64_t value, std::size_t size)
+            {
+                std::memcpy(&data[offset], &value, size);   //little endian host
+            }
+
+            std::vector<symbol> symbols;
+            std::string strings = std::string(1, '\0');
+        };
+
+        const char* threeKernels =
+            "extern \"C\" __global__ void first(float* x) {}\n"
+            "extern \"C\" __global__ void second(float* x, int n) {}\n"
+            "extern \"C\" __global__ void third(const float* __restrict__ x, float& y) {}\n";
+
+        // a build of the code for the first count devices, as the magic creates it without -co
+        nvrtc_build makeBuild(const std::string& code, int count)
+        {
+            nvrtc_build build;
+            build.code = code;
+            build.cacheKey = nvrtc_cache::fingerprint({code});
+            nvrtc_target target;
+            for (int i = 0; i < count; i++) target.devices.push_back(i);
+            build.targets.push_back(target);
+            return build;
+        }
+
+        // compiler of the stub devices, workers are only used for more than one device
+        std::shared_ptr<nvrtc_compiler> makeCompiler(int count, std::shared_ptr<nvrtc_device_workers>& workers)
+        {
+            std::vector<CUcontext> contexts = test::stubContexts(count);
+            workers = std::make_shared<nvrtc_device_workers>();
+            if (count > 1) workers->start(contexts);
+            auto compiler = std::make_shared<nvrtc_compiler>();
+            compiler->setDevices(contexts, workers);
+            return compiler;
+        }
+
+        void checkHandles(const nvrtc_loaded_program& program, int count)
+        {
+            REQUIRE_EQ(program.functionNames, std::vector<std::string>({"first", "second", "third"}));
+            for (const std::string& name : program.functionNames)
+            {
+                const std::vector<CUfunction>& handles = program.functions.at(name);
+                REQUIRE_EQ(handles.size(), static_cast<std::size_t>(count));
+                for (int device = 0; device < count; device++)
+                {
+                    //each variable gets the handle of its own kernel on each device
+                    const auto* function = reinterpret_cast<const stub::function*>(handles[device]);
+                    REQUIRE(function != nullptr);
+                    CHECK_EQ(function->name, name);
+                    CHECK_EQ(function->device, device);
+                }
+            }
+        }
+    }
+
+    TEST_SUITE("nvrtc_compiler")
+    {
+        TEST_CASE("extractCubinFunctionNames")
+        {
+            elf_builder elf;
+            elf.addSymbol("_Z5saxpyfPKfPfi", 0x12, 1);   //STB_GLOBAL, STT_FUNC
+            elf.addSymbol("local", 0x02, 1);              //STB_LOCAL
+            elf.addSymbol("constant", 0x11, 1);           //STT_OBJECT
+            elf.addSymbol("external", 0x12, 0);           //undefined
+            elf.addSymbol("reduce", 0x12, 2);
+            CHECK_EQ(nvrtc_compiler::extractCubinFunctionNames(elf.image()), std::vector<std::string>({"_Z5saxpyfPKfPfi", "reduce"}));
+
+            //PTX, truncated and 32 bit images have no symbols
+            CHECK(nvrtc_compiler::extractCubinFunctionNames(".version 8.0\n").empty());
+            CHECK(nvrtc_compiler::extractCubinFunctionNames(elf.image().substr(0, 100)).empty());
+            std::string elf32 = elf.image();
+            elf32[4] = 1;
+            CHECK(nvrtc_compiler::extractCubinFunctionNames(elf32).empty());
+        }
+
+        TEST_CASE("extractFunctionNames")
+        {
+            std::string ptx = "\t// .globl\t_Z5saxpyfPKfPfi\n.visible .entry _Z5saxpyfPKfPfi(\n)\n"
+                              "\t// .globl\treduce\n.visible .entry reduce(\n)\n";
+            CHECK_EQ(nvrtc_compiler::extractFunctionNames(ptx), std::vector<std::string>({"_Z5saxpyfPKfPfi", "reduce"}));
+        }
+
+        TEST_CASE("kernelName")
+        {
+            CHECK_EQ(nvrtc_compiler::kernelName("_Z5saxpyfPKfPfi"), "saxpy");
+            CHECK_EQ(nvrtc_compiler::kernelName("_Z12scale_kernelPfi"), "scale_kernel");
+            CHECK_EQ(nvrtc_compiler::kernelName("reduce"), "reduce");
+            CHECK_EQ(nvrtc_compiler::kernelName("_ZN2ns6kernelEv"), "_ZN2ns6kernelEv");
+        }
+
+        TEST_CASE("getLauncherTypes")
+        {
+            std::string types;
+            REQUIRE(nvrtc_compiler::getLauncherTypes("float a, const float* __restrict__ x, float* y, int n", types));
+            CHECK_EQ(types, "float, CUdeviceptr, CUdeviceptr, int");
+            REQUIRE(nvrtc_compiler::getLauncherTypes("unsigned int n, float x[], vec<float, 3> v", types));
+            CHECK_EQ(types, "unsigned int, CUdeviceptr, vec<float, 3>");
+            REQUIRE(nvrtc_compiler::getLauncherTypes("void", types));
+            CHECK_EQ(types, "");
+            REQUIRE(nvrtc_compiler::getLauncherTypes("", types));
+            CHECK_EQ(types, "");
+            CHECK_FALSE(nvrtc_compiler::getLauncherTypes("float& y", types));
+        }
+
+        TEST_CASE("targets of a fixed architecture and their cache keys")
+        {
+            REQUIRE(test::loadStubDriver());
+            //CUBIN needs nvrtcGetCUBIN, which the stub does not have, like NVRTC before 11.1
+            nvrtc_target real = nvrtc_compiler::fixedTarget({"-arch=sm_80"}, "-arch=sm_80");
+            CHECK_EQ(real.cubin, nvrtc_api::instance().nvrtc.nvrtcGetCUBIN != nullptr);
+            CHECK_EQ(real.options, std::vector<std::string>({"-arch=sm_80"}));
+            CHECK_FALSE(nvrtc_compiler::fixedTarget({"-arch=compute_80"}, "-arch=compute_80").cubin);
+            CHECK_FALSE(nvrtc_compiler::fixedTarget({}, "default").cubin);
+
+            //the key of an image depends on the build, its kind and the options of the target
+            nvrtc_build build;
+            build.cacheKey = "build";
+            build.targets = {real, real, nvrtc_compiler::fixedTarget({"-arch=sm_90"}, "-arch=sm_90")};
+            build.targets[0].cubin = true;
+            build.targets[1].cubin = false;
+            nvrtc_compiler::setTargetKeys(build);
+            CHECK_NE(build.targets[0].cacheKey, build.targets[1].cacheKey);
+            CHECK_NE(build.targets[0].cacheKey, build.targets[2].cacheKey);
+            std::string key = build.targets[0].cacheKey;
+            build.cacheKey = "other";
+            nvrtc_compiler::setTargetKeys(build);
+            CHECK_NE(build.targets[0].cacheKey, key);
+        }
+
+        TEST_CASE("a build loads its kernels")
+        {
+            REQUIRE(test::loadStubDriver());
+            fs::path directory = test::cacheDirectory("build");
+            std::shared_ptr<nvrtc_device_workers> workers;
+            std::shared_ptr<nvrtc_compiler> compiler = makeCompiler(1, workers);
+
+            nvrtc_build build = makeBuild(threeKernels, 1);
+            REQUIRE_EQ(compiler->buildProgram(build), 0);
+            CHECK(build.errors.empty());
+            REQUIRE_EQ(build.program.functionNames, std::vector<std::string>({"first", "second", "third"}));
+            for (const std::string& name : build.program.functionNames)
+            {
+                const auto* function = reinterpret_cast<const stub::function*>(build.program.functions.at(name).at(0));
+                REQUIRE(function != nullptr);
+                CHECK_EQ(function->name, name);
+            }
+
+            //typed launchers only for kernels whose parameters can be passed from cling
+            CHECK_EQ(build.program.launcherTypes.at("first"), "CUdeviceptr");
+            CHECK_EQ(build.program.launcherTypes.at("second"), "CUdeviceptr, int");
+            CHECK_EQ(build.program.launcherTypes.count("third"), 0);
+            fs::remove_all(directory);
+        }
+
+        TEST_CASE("kernel handles of each device")
+        {
+            REQUIRE(test::loadStubDriver());
+            fs::path directory = test::cacheDirectory("handles");
+
+            for (int count = 1; count <= stub::DEVICE_COUNT; count++)
+            {
+                CAPTURE(count);
+                std::shared_ptr<nvrtc_device_workers> workers;
+                std::shared_ptr<nvrtc_compiler> compiler = makeCompiler(count, workers);
+
+                //the first build compiles, the second one loads the cached image
+                for (int run = 0; run < 2; run++)
+                {
+                    CAPTURE(run);
+                    nvrtc_build build = makeBuild(threeKernels, count);
+                    REQUIRE_EQ(compiler->buildProgram(build), 0);
+                    CHECK(build.errors.empty());
+                    checkHandles(build.program, count);
+                    CHECK_EQ(build.program.modules.size(), static_cast<std::size_t>(count));
+                }
+            }
+            fs::remove_all(directory);
+        }
+
+        TEST_CASE("a missing function fails the build")
+        {
+            REQUIRE(test::loadStubDriver());
+            fs::path directory = test::cacheDirectory("missing");
+            std::shared_ptr<nvrtc_device_workers> workers;
+            std::shared_ptr<nvrtc_compiler> compiler = makeCompiler(1, workers);
+
+            //a cached image which lists a function the module does not contain
+            nvrtc_build build = makeBuild("extern \"C\" __global__ void ghost() {}\n", 1);
+            nvrtc_cache cache;
+            std::string key = nvrtc_cache::fingerprint({build.cacheKey, "ptx"});
+            cache.store(key, "ptx", "\t// .globl\tghost\n");
+
+            CHECK_NE(compiler->buildProgram(build), 0);
+            CHECK_NE(build.errors.find("cuModuleGetFunction: ghost"), std::string::npos);
+            CHECK(build.program.functions.empty());
+            fs::remove_all(directory);
+        }
+    }
+}
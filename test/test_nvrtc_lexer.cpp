@@ -0,0 +1,86 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <string>
+
+#include "doctest/doctest.h"
+
+#include "nvrtc_lexer.hpp"
+
+namespace xcpp
+{
+    TEST_SUITE("nvrtc_lexer")
+    {
+        TEST_CASE("includes")
+        {
+            nvrtc_source source = scanSource(
+                "#include \"local.cuh\"\n"
+                "  #  include <system.h>\n"
+                "// #include \"commented.h\"\n"
+                "/* #include \"block.h\"\n"
+                "   #include \"block2.h\" */\n"
+                "const char* text = \"#include \\\"string.h\\\"\";\n"
+                "#include MACRO_HEADER\n");
+            REQUIRE_EQ(source.includes.size(), 2);
+            CHECK_EQ(source.includes[0].name, "local.cuh");
+            CHECK(source.includes[0].quoted);
+            CHECK_EQ(source.includes[0].line, 1);
+            CHECK_EQ(source.includes[1].name, "system.h");
+            CHECK_FALSE(source.includes[1].quoted);
+            CHECK_EQ(source.includes[1].line, 2);
+        }
+
+        TEST_CASE("comments keep the offsets")
+        {
+            std::string code = "int a; /* one\ntwo */ int b; // three\nint c;";
+            nvrtc_source source = scanSource(code);
+            REQUIRE_EQ(source.code.size(), code.size());
+            CHECK_EQ(source.code.find("one"), std::string::npos);
+            CHECK_EQ(source.code.find("three"), std::string::npos);
+            CHECK_EQ(source.code.find("int b"), code.find("int b"));
+            REQUIRE_EQ(source.lineOffsets.size(), 3);
+            CHECK_EQ(source.lineOffsets[2], code.find("int c"));
+        }
+
+        TEST_CASE("kernels")
+        {
+            nvrtc_source source = scanSource(
+                "// __global__ void commented(int n) {}\n"
+                "const char* s = \"__global__ void quoted()\";\n"
+                "__global__ void saxpy(float a, const float* x /* input */, float* y, int n)\n"
+                "{\n"
+                "}\n"
+                "template <typename T>\n"
+                "__global__ void fill(T* x, T value) {}\n"
+                "__global__ void __launch_bounds__(256) bounded(int n) {}\n"
+                "extern \"C\" __global__ void prototype(int n);\n");
+            REQUIRE_EQ(source.kernels.size(), 4);
+            CHECK_EQ(source.kernels[0].name, "saxpy");
+            CHECK_EQ(source.kernels[0].parameters, "float a, const float* x " + std::string(11, ' ') + ", float* y, int n");    //the comment is blanked
+            CHECK_FALSE(source.kernels[0].isTemplate);
+            CHECK_EQ(source.kernels[0].line, 3);
+            CHECK_EQ(source.kernels[1].name, "fill");
+            CHECK(source.kernels[1].isTemplate);
+            CHECK_EQ(source.kernels[2].name, "bounded");
+            CHECK_EQ(source.kernels[2].parameters, "int n");
+            CHECK_EQ(source.kernels[3].name, "prototype");
+        }
+
+        TEST_CASE("device functions")
+        {
+            nvrtc_source source = scanSource(
+                "__device__ float square(float x) { return x * x; }\n"
+                "__device__ float cube(float x);\n"
+                "__global__ void kernel(float* x) { x[0] = square(x[0]); }\n");
+            REQUIRE_EQ(source.deviceFunctions.size(), 1);
+            CHECK_EQ(source.deviceFunctions[0], "square");
+            CHECK_EQ(source.kernels.size(), 1);
+        }
+    }
+}
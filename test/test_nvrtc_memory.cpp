@@ -0,0 +1,135 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+
+#include "doctest/doctest.h"
+
+#include "nvrtc_memory.hpp"
+#include "nvrtc_streams.hpp"
+
+#include "stub_driver.hpp"
+#include "test_nvrtc_utils.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        // unique stream handles, the stub driver does not look at them
+        CUstream fakeStream(std::size_t id)
+        {
+            return reinterpret_cast<CUstream>(id);
+        }
+    }
+
+    TEST_SUITE("nvrtc_memory")
+    {
+        TEST_CASE("sizeClass")
+        {
+            const std::size_t MB = std::size_t(1) << 20;
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(0), 256);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(1), 256);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(256), 256);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(257), 512);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(3 * MB), 4 * MB);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(32 * MB), 32 * MB);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(32 * MB + 1), 34 * MB);
+            CHECK_EQ(nvrtc_memory_pool::sizeClass(100 * MB), 100 * MB);
+        }
+
+        TEST_CASE("reuse of device blocks")
+        {
+            REQUIRE(test::loadStubDriver());
+            nvrtc_stream_pool::instance().setContexts(test::stubContexts(1));
+            nvrtc_memory_pool& pool = nvrtc_memory_pool::instance();
+            const std::size_t bytes = 5000;     //size class of no other test
+
+            //the stream of the free gets the block at once, other streams after the synchronization
+            CUdeviceptr block = pool.allocateDevice(0, bytes, fakeStream(1));
+            pool.freeDevice(0, block, bytes, fakeStream(1));
+            CUdeviceptr other = pool.allocateDevice(0, bytes, fakeStream(2));
+            CHECK_NE(other, block);
+            CUdeviceptr same = pool.allocateDevice(0, bytes, fakeStream(1));
+            CHECK_EQ(same, block);
+
+            pool.freeDevice(0, same, bytes, fakeStream(1));
+            pool.markSynchronized();
+            CHECK_EQ(pool.allocateDevice(0, bytes, fakeStream(2)), block);
+            pool.freeDevice(0, block, bytes, nullptr);
+            pool.freeDevice(0, other, bytes, nullptr);
+        }
+
+        TEST_CASE("device blocks freed without a stream wait for the synchronization")
+        {
+            REQUIRE(test::loadStubDriver());
+            nvrtc_stream_pool::instance().setContexts(test::stubContexts(1));
+            nvrtc_memory_pool& pool = nvrtc_memory_pool::instance();
+            const std::size_t bytes = 17000;
+
+            //a kernel on a non-blocking pool stream may still use the block
+            CUdeviceptr block = pool.allocateDevice(0, bytes, nullptr);
+            pool.freeDevice(0, block, bytes, nullptr);
+            CUdeviceptr other = pool.allocateDevice(0, bytes, nullptr);
+            CHECK_NE(other, block);
+            pool.markSynchronized();
+            CHECK_EQ(pool.allocateDevice(0, bytes, nullptr), block);
+            pool.freeDevice(0, block, bytes, nullptr);
+            pool.freeDevice(0, other, bytes, nullptr);
+        }
+
+        TEST_CASE("a failed synchronization keeps the freed blocks")
+        {
+            REQUIRE(test::loadStubDriver());
+            nvrtc_stream_pool& streams = nvrtc_stream_pool::instance();
+            streams.setContexts(test::stubContexts(1));
+            nvrtc_memory_pool& pool = nvrtc_memory_pool::instance();
+            const std::size_t bytes = 70000;     //size class of no other test
+
+            //a stream may still use the block after an error of the context
+            CUdeviceptr block = pool.allocateDevice(0, bytes, fakeStream(1));
+            pool.freeDevice(0, block, bytes, fakeStream(1));
+            std::string error;
+            setenv(stub::SYNC_ERROR_VARIABLE, "700", 1);
+            CHECK_EQ(streams.synchronizeAll(error), 700);
+            unsetenv(stub::SYNC_ERROR_VARIABLE);
+            CHECK_FALSE(error.empty());
+            CUdeviceptr other = pool.allocateDevice(0, bytes, fakeStream(2));
+            CHECK_NE(other, block);
+
+            CHECK_EQ(streams.synchronizeAll(error), 0);
+            CHECK_EQ(pool.allocateDevice(0, bytes, fakeStream(2)), block);
+            pool.freeDevice(0, block, bytes, nullptr);
+            pool.freeDevice(0, other, bytes, nullptr);
+        }
+
+        TEST_CASE("reuse of pinned host blocks")
+        {
+            REQUIRE(test::loadStubDriver());
+            nvrtc_stream_pool::instance().setContexts(test::stubContexts(1));
+            nvrtc_memory_pool& pool = nvrtc_memory_pool::instance();
+            const std::size_t bytes = 9000;
+
+            //a block of an asynchronous copy waits for the synchronization
+            void* block = pool.allocateHost(bytes);
+            pool.freeHost(block, bytes, fakeStream(1));
+            void* other = pool.allocateHost(bytes);
+            CHECK_NE(other, block);
+            pool.markSynchronized();
+            CHECK_EQ(pool.allocateHost(bytes), block);
+
+            //a block of synchronous copies is free at once
+            pool.freeHost(other, bytes, nullptr);
+            CHECK_EQ(pool.allocateHost(bytes), other);
+            pool.freeHost(block, bytes, nullptr);
+            pool.freeHost(other, bytes, nullptr);
+        }
+    }
+}
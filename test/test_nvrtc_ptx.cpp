@@ -0,0 +1,152 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "nvrtc_ptx.hpp"
+
+namespace xcpp
+{
+    namespace
+    {
+        // hand-written like the output of NVRTC: a double precision axpy with a
+        // local array, a device function and the prototype of an external one
+        const std::string PTX = R"(//
+// Generated by NVIDIA NVVM Compiler
+//
+.version 8.0
+.target sm_80
+.address_size 64
+
+.extern .func (.param .b32 func_retval0) vprintf
+(
+	.param .b64 vprintf_param_0,
+	.param .b64 vprintf_param_1
+)
+;
+.shared .align 8 .b8 _ZZ4daxpyE5cache[256];
+
+.visible .entry daxpy(
+	.param .f64 daxpy_param_0,
+	.param .u64 daxpy_param_1,
+	.param .u64 daxpy_param_2,
+	.param .u32 daxpy_param_3
+)
+{
+	.local .align 8 .b8 	__local_depot0[64];
+	.reg .b64 	%SP;
+	.reg .pred 	%p<2>;
+	.reg .b32 	%r<5>;
+	.reg .f64 	%fd<5>;
+	.reg .b64 	%rd<9>;
+
+	mov.u64 	%SP, __local_depot0;
+	ld.param.f64 	%fd1, [daxpy_param_0];
+	ld.param.u64 	%rd1, [daxpy_param_1];
+	ld.param.u32 	%r2, [daxpy_param_3];
+	mov.u32 	%r3, %ctaid.x;
+	mad.lo.s32 	%r1, %r3, %r2, %r2;
+	setp.ge.s32 	%p1, %r1, %r2;
+	@%p1 bra 	$L__BB0_2;
+
+	cvta.to.global.u64 	%rd2, %rd1;
+	mul.wide.s32 	%rd3, %r1, 8;
+	add.s64 	%rd4, %rd2, %rd3;
+	ld.global.f64 	%fd2, [%rd4];
+	st.local.f64 	[%SP], %fd2;
+	ld.local.f64 	%fd3, [%SP];
+	st.shared.f64 	[_ZZ4daxpyE5cache], %fd3;
+	fma.rn.f64 	%fd4, %fd1, %fd3, %fd2;
+	st.global.f64 	[%rd4], %fd4;
+
+$L__BB0_2:
+	ret;
+
+}
+	// .globl	_Z4halfPf
+.visible .func  (.param .b32 func_retval0) _Z4halfPf(
+	.param .b64 _Z4halfPf_param_0
+)
+{
+	.reg .f32 	%f<3>;
+	.reg .b64 	%rd<2>;
+
+	ld.param.u64 	%rd1, [_Z4halfPf_param_0];
+	ld.f32 	%f1, [%rd1];
+	mul.f32 	%f2, %f1, 0f3F000000;
+	st.param.f32 	[func_retval0+0], %f2;
+	ret;
+
+}
+)";
+    }
+
+    TEST_SUITE("nvrtc_ptx")
+    {
+        TEST_CASE("instruction mix and memory of the functions")
+        {
+            std::vector<nvrtc_ptx_function> functions = nvrtc_ptx_analyzer::analyze(PTX);
+            REQUIRE_EQ(functions.size(), 2);     //the prototype of vprintf has no body
+
+            const nvrtc_ptx_function& daxpy = functions[0];
+            CHECK_EQ(daxpy.name, "daxpy");
+            CHECK(daxpy.entry);
+            CHECK_EQ(daxpy.registerCount(), 1 + 5 + 5 + 9);
+            CHECK_EQ(daxpy.registers.at("pred"), 2);
+
+            //instruction mix, fma.rn.f64 is FP64 and counts two flops
+            CHECK_EQ(daxpy.fp64, 1);
+            CHECK_EQ(daxpy.fp32, 0);
+            CHECK_EQ(daxpy.integer, 4);
+            CHECK_EQ(daxpy.flops, 2);
+            CHECK_EQ(daxpy.conversions, 0);
+
+            CHECK_EQ(daxpy.globalLoads, 1);
+            CHECK_EQ(daxpy.globalStores, 1);
+            CHECK_EQ(daxpy.globalBytes, 16);
+            CHECK_EQ(daxpy.localLoads, 1);
+            CHECK_EQ(daxpy.localStores, 1);
+            CHECK_EQ(daxpy.localBytes, 64);     //__local_depot0
+            CHECK_EQ(daxpy.sharedStores, 1);
+            CHECK_EQ(daxpy.sharedBytes, 256);   //module scope variable used by the kernel
+
+            CHECK_EQ(daxpy.branches, 1);
+            CHECK_EQ(daxpy.predicatedBranches, 1);
+            CHECK_EQ(daxpy.arithmeticIntensity(), 0.125);    //2 flops per 16 bytes
+
+            const nvrtc_ptx_function& half = functions[1];
+            CHECK_EQ(half.name, "_Z4halfPf");
+            CHECK_FALSE(half.entry);
+            CHECK_EQ(half.fp32, 1);
+            CHECK_EQ(half.globalLoads, 1);     //generic access
+            CHECK_EQ(half.globalBytes, 4);
+            CHECK_EQ(half.sharedBytes, 0);
+            CHECK_EQ(half.branches, 0);
+        }
+
+        TEST_CASE("warnings of FP64 and local memory")
+        {
+            std::vector<nvrtc_ptx_function> functions = nvrtc_ptx_analyzer::analyze(PTX);
+            REQUIRE_EQ(functions.size(), 2);
+
+            std::vector<std::string> warnings = functions[0].warnings();
+            REQUIRE_EQ(warnings.size(), 2);
+            CHECK_EQ(warnings[0], "uses FP64 (1 operations, 0 conversions)");
+            CHECK_EQ(warnings[1], "uses local memory (64 bytes, 2 accesses)");
+            CHECK(functions[1].warnings().empty());
+
+            std::string table = nvrtc_ptx_analyzer::table(functions);
+            CHECK_NE(table.find("Warning: daxpy uses FP64"), std::string::npos);
+            CHECK_NE(table.find(".func _Z4halfPf"), std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "doctest/doctest.h"
+
+#include "nvrtc_session.hpp"
+#include "nvrtc_sha256.hpp"
+
+namespace xcpp
+{
+    TEST_SUITE("nvrtc_session")
+    {
+        TEST_CASE("a post from another thread rings the hook")
+        {
+            nvrtc_session& session = nvrtc_session::instance();
+            std::atomic<int> rings{0};
+            session.setPostHook([&rings]() { rings++; });
+
+            //the task waits for the shell thread, the hook wakes it
+            bool ran = false;
+            std::thread worker([&session, &ran]() { session.post([&ran]() { ran = true; }); });
+            worker.join();
+            CHECK_EQ(rings.load(), 1);
+            CHECK_FALSE(ran);
+            session.runPosted();
+            CHECK(ran);
+            session.setPostHook(nullptr);
+        }
+
+        TEST_CASE("HMAC-SHA256 of the doorbell messages")
+        {
+            //RFC 4231 test cases 2 and 6
+            CHECK_EQ(nvrtc_sha256::hmac("Jefe", {"what do ya ", "want for nothing?"}),
+                     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+            CHECK_EQ(nvrtc_sha256::hmac(std::string(131, '\xaa'), {"Test Using Larger Than Block-Size Key - Hash Key First"}),
+                     "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+        }
+    }
+}
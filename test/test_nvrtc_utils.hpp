@@ -0,0 +1,60 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#ifndef XEUS_CLING_TEST_NVRTC_UTILS_HPP
+#define XEUS_CLING_TEST_NVRTC_UTILS_HPP
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "nvrtc_api.hpp"
+
+namespace test
+{
+    namespace fs = std::filesystem;
+
+    // empty cache directory of one test, selected through the environment like in the kernel
+    inline fs::path cacheDirectory(const std::string& name, const std::string& sizeMB = "512")
+    {
+        fs::path directory = fs::temp_directory_path() / ("xeus_cling_test_" + name + "_" + std::to_string(::getpid()));
+        fs::remove_all(directory);
+        setenv("XEUS_CLING_NVRTC_CACHE_DIR", directory.c_str(), 1);
+        setenv("XEUS_CLING_NVRTC_CACHE_SIZE", sizeMB.c_str(), 1);
+        return directory;
+    }
+
+    // the entry was last used the given time ago
+    inline void age(const fs::path& path, std::chrono::minutes minutes)
+    {
+        fs::last_write_time(path, fs::file_time_type::clock::now() - minutes);
+    }
+
+    // loads the stub library as libcuda and libnvrtc, once per process
+    inline bool loadStubDriver()
+    {
+        setenv("XEUS_CLING_CUDA_LIBRARY", STUB_DRIVER_LIBRARY, 1);
+        setenv("XEUS_CLING_NVRTC_LIBRARY", STUB_DRIVER_LIBRARY, 1);
+        xcpp::nvrtc_api& api = xcpp::nvrtc_api::instance();
+        return api.load("") == 0 && api.cuda.cuInit(0) == xcpp::CUDA_API_SUCCESS;
+    }
+
+    inline std::vector<CUcontext> stubContexts(int count)
+    {
+        std::vector<CUcontext> contexts(count, nullptr);
+        for (int i = 0; i < count; i++) xcpp::nvrtc_api::instance().cuda.cuCtxCreate(&contexts[i], 0, i);
+        return contexts;
+    }
+}
+
+#endif
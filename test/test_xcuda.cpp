@@ -0,0 +1,93 @@
+/****************************************************************************************
+* Copyright (c) 2025, David Tadaewsky                                                   *
+* Copyright (c) 2025, FernUniversität in Hagen, Fakultät für Mathematik und Informatik  *
+*                                                                                       *
+* Distributed under the terms of the BSD 3-Clause License.                              *
+*                                                                                       *
+* The full license is in the file LICENSE, distributed with this software.              *
+****************************************************************************************/
+
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "xcpp/xcuda.hpp"
+
+#include "nvrtc_session.hpp"
+#include "nvrtc_streams.hpp"
+#include "nvrtc_workers.hpp"
+
+#include "test_nvrtc_utils.hpp"
+
+namespace xcpp
+{
+    namespace cuda
+    {
+        TEST_SUITE("xcuda")
+        {
+            TEST_CASE("slice_argument")
+            {
+                device_slice first = {0, 0, 768};
+                device_slice second = {1, 768, 1000};
+
+                //plain values are the same on all devices
+                static_assert(std::is_same<detail::slice_argument<float>::type, float>::value, "");
+                CHECK_EQ(detail::slice_argument<float>::get(2.5f, second), 2.5f);
+
+                //placeholders become the slice of the device
+                static_assert(std::is_same<detail::slice_argument<slice_begin_t>::type, unsigned int>::value, "");
+                static_assert(std::is_same<detail::slice_argument<slice_size_t>::type, unsigned int>::value, "");
+                CHECK_EQ(detail::slice_argument<slice_begin_t>::get(slice_begin, first), 0u);
+                CHECK_EQ(detail::slice_argument<slice_begin_t>::get(slice_begin, second), 768u);
+                CHECK_EQ(detail::slice_argument<slice_size_t>::get(slice_size, first), 768u);
+                CHECK_EQ(detail::slice_argument<slice_size_t>::get(slice_size, second), 232u);
+
+                //per_device values are selected by the device of the slice
+                per_device<int> values = {10, 20};
+                static_assert(std::is_same<detail::slice_argument<per_device<int>>::type, int>::value, "");
+                CHECK_EQ(detail::slice_argument<per_device<int>>::get(values, first), 10);
+                CHECK_EQ(detail::slice_argument<per_device<int>>::get(values, second), 20);
+            }
+
+            TEST_CASE("launch_all passes device_buffers only to their device")
+            {
+                REQUIRE(test::loadStubDriver());
+                std::vector<CUcontext> contexts = test::stubContexts(2);
+                auto workers = std::make_shared<nvrtc_device_workers>();
+                workers->start(contexts);
+                nvrtc_stream_pool::instance().setContexts(contexts);
+                nvrtc_stream_pool::instance().setWorkers(workers);
+
+                //the stub launch ignores the handles
+                static int handles[2];
+                nvrtc_session::instance().setKernel("launch_all_scale", {reinterpret_cast<CUfunction>(&handles[0]), reinterpret_cast<CUfunction>(&handles[1])});
+                kernel_future scale = kernel("launch_all_scale");
+
+                //a buffer of device 0 would be a foreign pointer on device 1
+                device_buffer<float> x(1024, 0);
+                CHECK_THROWS_AS(launch_all(scale, dim3(1024), launch_all_options(), x, slice_begin, slice_size), std::invalid_argument);
+
+                std::vector<device_buffer<float>> buffers;
+                buffers.emplace_back(1024, 0);
+                buffers.emplace_back(1024, 1);
+                per_device<CUdeviceptr> pointers = {buffers[0].get(), buffers[1].get()};
+                CHECK_EQ(launch_all(scale, dim3(1024), launch_all_options(), pointers, slice_begin, slice_size), 0);
+                per_device<device_buffer<float>> perDevice(std::move(buffers));
+                CHECK_EQ(launch_all(scale, dim3(1024), launch_all_options(), perDevice, slice_begin, slice_size), 0);
+
+                //buffers listed for the wrong devices
+                std::vector<device_buffer<float>> swapped;
+                swapped.emplace_back(1024, 1);
+                swapped.emplace_back(1024, 0);
+                per_device<device_buffer<float>> wrong(std::move(swapped));
+                CHECK_THROWS_AS(launch_all(scale, dim3(1024), launch_all_options(), wrong, slice_begin, slice_size), std::invalid_argument);
+
+                nvrtc_stream_pool::instance().setWorkers(nullptr);
+            }
+        }
+    }
+}